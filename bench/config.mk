@@ -0,0 +1,18 @@
+PRJTYPE = Executable
+LIBS = assetloader macu physfs orb vorbis ogg freetype png jpeg tiff zlib
+ifeq ($(TARGET_OS), Windows)
+	LIBS += psapi
+else
+	LIBS += pthread m
+endif
+ADDLIBDIR = ../lib \
+			../deps/ZLib/lib \
+			../deps/Png/lib \
+			../deps/Jpeg/lib \
+			../deps/Tiff/lib \
+			../deps/Vorbis/lib \
+			../deps/Ogg/lib \
+			../deps/Freetype/lib \
+			../deps/PhysFS/lib
+MOREDEPS = .. ../deps/ZLib ../deps/Png ../deps/Tiff ../deps/Ogg ../deps/Vorbis
+EXTDEPS = macu::0.0.2dev orb::dev
@@ -0,0 +1,815 @@
+/*********************************************************************************************************************/
+/*                                                  /===-_---~~~~~~~~~------____                                     */
+/*                                                 |===-~___                _,-'                                     */
+/*                  -==\\                         `//~\\   ~~~~`---.___.-~~                                          */
+/*              ______-==|                         | |  \\           _-~`                                            */
+/*        __--~~~  ,-/-==\\                        | |   `\        ,'                                                */
+/*     _-~       /'    |  \\                      / /      \      /                                                  */
+/*   .'        /       |   \\                   /' /        \   /'                                                   */
+/*  /  ____  /         |    \`\.__/-~~ ~ \ _ _/'  /          \/'                                                     */
+/* /-'~    ~~~~~---__  |     ~-/~         ( )   /'        _--~`                                                      */
+/*                   \_|      /        _)   ;  ),   __--~~                                                           */
+/*                     '~~--_/      _-~/-  / \   '-~ \                                                               */
+/*                    {\__--_/}    / \\_>- )<__\      \                                                              */
+/*                    /'   (_/  _-~  | |__>--<__|      |                                                             */
+/*                   |0  0 _/) )-~     | |__>--<__|     |                                                            */
+/*                   / /~ ,_/       / /__>---<__/      |                                                             */
+/*                  o o _//        /-~_>---<__-~      /                                                              */
+/*                  (^(~          /~_>---<__-      _-~                                                               */
+/*                 ,/|           /__>--<__/     _-~                                                                  */
+/*              ,//('(          |__>--<__|     /                  .----_                                             */
+/*             ( ( '))          |__>--<__|    |                 /' _---_~\                                           */
+/*          `-)) )) (           |__>--<__|    |               /'  /     ~\`\                                         */
+/*         ,/,'//( (             \__>--<__\    \            /'  //        ||                                         */
+/*       ,( ( ((, ))              ~-__>--<_~-_  ~--____---~' _/'/        /'                                          */
+/*     `~/  )` ) ,/|                 ~-_~>--<_/-__       __-~ _/                                                     */
+/*   ._-~//( )/ )) `                    ~~-'_/_/ /~~~~~~~__--~                                                       */
+/*    ;'( ')/ ,)(                              ~~~~~~~~~~                                                            */
+/*   ' ') '( (/                                                                                                      */
+/*     '   '  `                                                                                                      */
+/*********************************************************************************************************************/
+#include "gen.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <setjmp.h>
+#include <math.h>
+#include <png.h>
+#include <tiffio.h>
+#include <zlib.h>
+#include <vorbis/vorbisenc.h>
+
+#define GEN_PI 3.14159265358979323846
+#define GEN_IOBUF_SZ (1 << 20)
+
+/*-----------------------------------------------------------------
+ * Helpers
+ *-----------------------------------------------------------------*/
+static FILE* gen_open(const char* fpath)
+{
+    FILE* f = fopen(fpath, "wb");
+    if (f)
+        setvbuf(f, 0, _IOFBF, GEN_IOBUF_SZ);
+    return f;
+}
+
+/* Closes the file, reporting write errors as failure */
+static int gen_close(FILE* f, int ok)
+{
+    if (ferror(f))
+        ok = 0;
+    if (fclose(f) != 0)
+        ok = 0;
+    return ok;
+}
+
+static size_t gen_side(size_t n)
+{
+    size_t side = (size_t)(sqrt((double)n) + 0.5);
+    return side ? side : 1;
+}
+
+static uint32_t gen_hash(uint32_t x, uint32_t y)
+{
+    uint32_t h = x * 0x8da6b343u ^ y * 0xd8163841u;
+    h ^= h >> 15;
+    h *= 0x2c1b3c6du;
+    h ^= h >> 12;
+    return h;
+}
+
+/* Height field used by the grid generators */
+static float gen_height(float u, float v)
+{
+    return 0.25f * sinf(u * 12.0f) * cosf(v * 9.0f);
+}
+
+/*-----------------------------------------------------------------
+ * Obj
+ *-----------------------------------------------------------------*/
+int gen_obj(const char* fpath, size_t num_tris)
+{
+    FILE* f = gen_open(fpath);
+    if (!f)
+        return 0;
+
+    /* Two triangles per grid cell */
+    size_t n = gen_side(num_tris / 2);
+    size_t w = n + 1;
+    fprintf(f, "# Generated grid, %lu triangles\no grid\n", (unsigned long)(2 * n * n));
+    for (size_t j = 0; j < w; ++j) {
+        for (size_t i = 0; i < w; ++i) {
+            float u = (float)i / n, v = (float)j / n;
+            fprintf(f, "v %.6f %.6f %.6f\n", u, gen_height(u, v), v);
+        }
+    }
+    for (size_t j = 0; j < w; ++j)
+        for (size_t i = 0; i < w; ++i)
+            fprintf(f, "vt %.6f %.6f\n", (float)i / n, (float)j / n);
+    for (size_t j = 0; j < w; ++j) {
+        for (size_t i = 0; i < w; ++i) {
+            float u = (float)i / n, v = (float)j / n;
+            float dx = 3.0f * cosf(u * 12.0f) * cosf(v * 9.0f);
+            float dz = -2.25f * sinf(u * 12.0f) * sinf(v * 9.0f);
+            float l = sqrtf(dx * dx + 1.0f + dz * dz);
+            fprintf(f, "vn %.6f %.6f %.6f\n", -dx / l, 1.0f / l, -dz / l);
+        }
+    }
+    fprintf(f, "usemtl grid\n");
+    for (size_t j = 0; j < n; ++j) {
+        for (size_t i = 0; i < n; ++i) {
+            unsigned long a = j * w + i + 1, b = a + 1, c = a + w + 1, d = a + w;
+            fprintf(f, "f %lu/%lu/%lu %lu/%lu/%lu %lu/%lu/%lu\n", a, a, a, b, b, b, c, c, c);
+            fprintf(f, "f %lu/%lu/%lu %lu/%lu/%lu %lu/%lu/%lu\n", a, a, a, c, c, c, d, d, d);
+        }
+    }
+    return gen_close(f, 1);
+}
+
+/*-----------------------------------------------------------------
+ * Ply
+ *-----------------------------------------------------------------*/
+int gen_ply(const char* fpath, size_t num_points, int binary)
+{
+    FILE* f = gen_open(fpath);
+    if (!f)
+        return 0;
+
+    fprintf(f, "ply\nformat %s 1.0\ncomment Generated point cloud\n"
+               "element vertex %lu\n"
+               "property float x\nproperty float y\nproperty float z\n"
+               "property float nx\nproperty float ny\nproperty float nz\n"
+               "property uchar red\nproperty uchar green\nproperty uchar blue\n"
+               "end_header\n",
+            binary ? "binary_little_endian" : "ascii", (unsigned long)num_points);
+
+    /* Points spread evenly over a unit sphere (golden angle spiral) */
+    for (size_t i = 0; i < num_points; ++i) {
+        float y = 1.0f - 2.0f * ((float)i + 0.5f) / num_points;
+        float r = sqrtf(1.0f - y * y);
+        float phi = (float)i * 2.39996323f;
+        float p[6] = {cosf(phi) * r, y, sinf(phi) * r, 0.0f, 0.0f, 0.0f};
+        p[3] = p[0]; p[4] = p[1]; p[5] = p[2];
+        unsigned char col[3] = {
+            (unsigned char)(127.5f + p[0] * 127.5f),
+            (unsigned char)(127.5f + p[1] * 127.5f),
+            (unsigned char)(127.5f + p[2] * 127.5f)
+        };
+        if (binary) {
+            /* Little endian hosts only */
+            fwrite(p, sizeof(p), 1, f);
+            fwrite(col, sizeof(col), 1, f);
+        } else {
+            fprintf(f, "%.6f %.6f %.6f %.6f %.6f %.6f %u %u %u\n",
+                    p[0], p[1], p[2], p[3], p[4], p[5], col[0], col[1], col[2]);
+        }
+    }
+    return gen_close(f, 1);
+}
+
+/*-----------------------------------------------------------------
+ * Fbx
+ *-----------------------------------------------------------------*/
+#define FBX_MAX_DEPTH 8
+#define FBX_VERSION 7400
+#define FBX_NUM_JOINTS 4
+#define FBX_GRID_SZ 8
+#define FBX_KTIME_SECOND 46186158000ll
+
+/* Builds a binary fbx in memory, patching each record's
+ * end offset and property sizes once it is closed */
+struct fbx_writer {
+    unsigned char* buf;
+    size_t len;
+    size_t cap;
+    struct {
+        size_t start;
+        size_t props_start;
+        size_t props_end;
+        uint32_t num_props;
+        int has_children;
+    } stack[FBX_MAX_DEPTH];
+    int depth;
+    int failed;
+};
+
+static unsigned char* fw_grow(struct fbx_writer* fw, size_t n)
+{
+    if (fw->failed)
+        return 0;
+    if (fw->len + n > fw->cap) {
+        size_t ncap = fw->cap ? fw->cap : 1 << 16;
+        while (ncap < fw->len + n)
+            ncap *= 2;
+        unsigned char* nbuf = realloc(fw->buf, ncap);
+        if (!nbuf) {
+            fw->failed = 1;
+            return 0;
+        }
+        fw->buf = nbuf;
+        fw->cap = ncap;
+    }
+    unsigned char* p = fw->buf + fw->len;
+    fw->len += n;
+    return p;
+}
+
+/* Little endian hosts only */
+static void fw_bytes(struct fbx_writer* fw, const void* data, size_t n)
+{
+    unsigned char* p = fw_grow(fw, n);
+    if (p)
+        memcpy(p, data, n);
+}
+
+static void fw_u32(struct fbx_writer* fw, uint32_t v) { fw_bytes(fw, &v, 4); }
+
+static void fw_patch_u32(struct fbx_writer* fw, size_t ofs, uint32_t v)
+{
+    if (!fw->failed)
+        memcpy(fw->buf + ofs, &v, 4);
+}
+
+static void fw_begin(struct fbx_writer* fw, const char* name)
+{
+    if (fw->depth > 0 && !fw->stack[fw->depth - 1].has_children) {
+        fw->stack[fw->depth - 1].props_end = fw->len;
+        fw->stack[fw->depth - 1].has_children = 1;
+    }
+    if (fw->depth == FBX_MAX_DEPTH) {
+        fw->failed = 1;
+        return;
+    }
+    /* End offset, property count and length are patched on close */
+    size_t start = fw->len;
+    uint32_t zeros[3] = {0, 0, 0};
+    unsigned char name_len = (unsigned char)strlen(name);
+    fw_bytes(fw, zeros, sizeof(zeros));
+    fw_bytes(fw, &name_len, 1);
+    fw_bytes(fw, name, name_len);
+    fw->stack[fw->depth].start = start;
+    fw->stack[fw->depth].props_start = fw->len;
+    fw->stack[fw->depth].num_props = 0;
+    fw->stack[fw->depth].has_children = 0;
+    ++fw->depth;
+}
+
+static void fw_end(struct fbx_writer* fw)
+{
+    if (fw->depth == 0) {
+        fw->failed = 1;
+        return;
+    }
+    --fw->depth;
+    if (fw->stack[fw->depth].has_children) {
+        /* Nested list is terminated by a null record */
+        static const unsigned char null_rec[13] = {0};
+        fw_bytes(fw, null_rec, sizeof(null_rec));
+    } else {
+        fw->stack[fw->depth].props_end = fw->len;
+    }
+    /* Offsets are 32 bit before version 7500 */
+    if (fw->len > UINT32_MAX) {
+        fw->failed = 1;
+        return;
+    }
+    size_t start = fw->stack[fw->depth].start;
+    fw_patch_u32(fw, start, (uint32_t)fw->len);
+    fw_patch_u32(fw, start + 4, fw->stack[fw->depth].num_props);
+    fw_patch_u32(fw, start + 8, (uint32_t)(fw->stack[fw->depth].props_end - fw->stack[fw->depth].props_start));
+}
+
+static void fw_prop(struct fbx_writer* fw, char code, const void* data, size_t sz)
+{
+    if (fw->depth > 0)
+        fw->stack[fw->depth - 1].num_props++;
+    fw_bytes(fw, &code, 1);
+    fw_bytes(fw, data, sz);
+}
+
+static void fw_prop_i32(struct fbx_writer* fw, int32_t v) { fw_prop(fw, 'I', &v, 4); }
+static void fw_prop_i64(struct fbx_writer* fw, int64_t v) { fw_prop(fw, 'L', &v, 8); }
+static void fw_prop_f64(struct fbx_writer* fw, double v) { fw_prop(fw, 'D', &v, 8); }
+
+/* Strings may contain the "\0\1" name/class separator, so length is explicit */
+static void fw_prop_strn(struct fbx_writer* fw, const char* s, size_t len)
+{
+    if (fw->depth > 0)
+        fw->stack[fw->depth - 1].num_props++;
+    char code = 'S';
+    fw_bytes(fw, &code, 1);
+    fw_u32(fw, (uint32_t)len);
+    fw_bytes(fw, s, len);
+}
+
+static void fw_prop_str(struct fbx_writer* fw, const char* s) { fw_prop_strn(fw, s, strlen(s)); }
+
+/* Array property, deflated when that makes it smaller */
+static void fw_prop_arr(struct fbx_writer* fw, char code, const void* data, size_t count, size_t unit_sz)
+{
+    if (fw->depth > 0)
+        fw->stack[fw->depth - 1].num_props++;
+    size_t raw_sz = count * unit_sz;
+    uLongf bound = compressBound((uLong)raw_sz);
+    unsigned char* hdr = fw_grow(fw, 13 + bound);
+    if (!hdr)
+        return;
+    uint32_t len = (uint32_t)count, enc = 1, comp_sz;
+    uLongf dst_sz = bound;
+    if (compress2(hdr + 13, &dst_sz, data, (uLong)raw_sz, 1) == Z_OK && dst_sz < raw_sz) {
+        comp_sz = (uint32_t)dst_sz;
+    } else {
+        enc = 0;
+        comp_sz = (uint32_t)raw_sz;
+        memcpy(hdr + 13, data, raw_sz);
+    }
+    hdr[0] = (unsigned char)code;
+    memcpy(hdr + 1, &len, 4);
+    memcpy(hdr + 5, &enc, 4);
+    memcpy(hdr + 9, &comp_sz, 4);
+    /* Give back the unused part of the bound */
+    fw->len -= bound - comp_sz;
+}
+
+/* Properties70 entry with double values */
+static void fw_p70_vec(struct fbx_writer* fw, const char* name, const char* type, const double* v, int n)
+{
+    fw_begin(fw, "P");
+    fw_prop_str(fw, name);
+    fw_prop_str(fw, type);
+    fw_prop_str(fw, "");
+    fw_prop_str(fw, "A");
+    for (int i = 0; i < n; ++i)
+        fw_prop_f64(fw, v[i]);
+    fw_end(fw);
+}
+
+static void fw_p70_int(struct fbx_writer* fw, const char* name, const char* type, int32_t v)
+{
+    fw_begin(fw, "P");
+    fw_prop_str(fw, name);
+    fw_prop_str(fw, type);
+    fw_prop_str(fw, "");
+    fw_prop_str(fw, "");
+    fw_prop_i32(fw, v);
+    fw_end(fw);
+}
+
+static void fw_leaf_i32(struct fbx_writer* fw, const char* name, int32_t v)
+{
+    fw_begin(fw, name);
+    fw_prop_i32(fw, v);
+    fw_end(fw);
+}
+
+static void fw_leaf_str(struct fbx_writer* fw, const char* name, const char* s)
+{
+    fw_begin(fw, name);
+    fw_prop_str(fw, s);
+    fw_end(fw);
+}
+
+/* Object name with class suffix, i.e. "name\0\1class" */
+static void fw_prop_objname(struct fbx_writer* fw, const char* name, const char* cls)
+{
+    char buf[128];
+    size_t nl = strlen(name), cl = strlen(cls);
+    if (nl + cl + 2 > sizeof(buf))
+        nl = sizeof(buf) - cl - 2;
+    memcpy(buf, name, nl);
+    buf[nl] = '\0';
+    buf[nl + 1] = '\1';
+    memcpy(buf + nl + 2, cls, cl);
+    fw_prop_strn(fw, buf, nl + 2 + cl);
+}
+
+static void fw_connection(struct fbx_writer* fw, int64_t child, int64_t parent, const char* desc)
+{
+    fw_begin(fw, "C");
+    fw_prop_str(fw, desc ? "OP" : "OO");
+    fw_prop_i64(fw, child);
+    fw_prop_i64(fw, parent);
+    if (desc)
+        fw_prop_str(fw, desc);
+    fw_end(fw);
+}
+
+/* Object ids */
+#define FBX_ID_JOINT(j)        (1000 + (int64_t)(j))
+#define FBX_ID_ACN(j, c)       (2000 + (int64_t)(j) * 2 + (c))
+#define FBX_ID_CURVE(j, c, a)  (3000 + ((int64_t)(j) * 2 + (c)) * 3 + (a))
+#define FBX_ID_GEOM(g)         (100000 + (int64_t)(g) * 2)
+#define FBX_ID_MODEL(g)        (100000 + (int64_t)(g) * 2 + 1)
+
+static void fbx_write_skeleton(struct fbx_writer* fw, size_t num_frames, int64_t* ktimes, float* kvals)
+{
+    static const char* comps[2] = {"T", "R"};
+    static const char* axes[3] = {"d|X", "d|Y", "d|Z"};
+    char name[32];
+    for (int j = 0; j < FBX_NUM_JOINTS; ++j) {
+        fw_begin(fw, "Model");
+        snprintf(name, sizeof(name), "Joint%d", j);
+        fw_prop_i64(fw, FBX_ID_JOINT(j));
+        fw_prop_objname(fw, name, "Model");
+        fw_prop_str(fw, "LimbNode");
+        fw_leaf_i32(fw, "Version", 232);
+        fw_begin(fw, "Properties70");
+        double t[3] = {0.0, j ? 1.0 : 0.0, 0.0};
+        fw_p70_vec(fw, "Lcl Translation", "Lcl Translation", t, 3);
+        fw_end(fw);
+        fw_end(fw);
+    }
+    for (int j = 0; j < FBX_NUM_JOINTS; ++j) {
+        for (int c = 0; c < 2; ++c) {
+            fw_begin(fw, "AnimationCurveNode");
+            fw_prop_i64(fw, FBX_ID_ACN(j, c));
+            fw_prop_objname(fw, comps[c], "AnimCurveNode");
+            fw_prop_str(fw, "");
+            fw_begin(fw, "Properties70");
+            double zero = 0.0;
+            for (int a = 0; a < 3; ++a)
+                fw_p70_vec(fw, axes[a], "Number", &zero, 1);
+            fw_end(fw);
+            fw_end(fw);
+            for (int a = 0; a < 3; ++a) {
+                for (size_t k = 0; k < num_frames; ++k)
+                    kvals[k] = (c ? 45.0f : 0.5f) * sinf(0.05f * k + j + a);
+                fw_begin(fw, "AnimationCurve");
+                fw_prop_i64(fw, FBX_ID_CURVE(j, c, a));
+                fw_prop_objname(fw, "", "AnimCurve");
+                fw_prop_str(fw, "");
+                fw_begin(fw, "Default");
+                fw_prop_f64(fw, 0.0);
+                fw_end(fw);
+                fw_leaf_i32(fw, "KeyVer", 4008);
+                fw_begin(fw, "KeyTime");
+                fw_prop_arr(fw, 'l', ktimes, num_frames, sizeof(int64_t));
+                fw_end(fw);
+                fw_begin(fw, "KeyValueFloat");
+                fw_prop_arr(fw, 'f', kvals, num_frames, sizeof(float));
+                fw_end(fw);
+                fw_end(fw);
+            }
+        }
+    }
+}
+
+static void fbx_write_geometry(struct fbx_writer* fw, size_t g)
+{
+    const size_t n = FBX_GRID_SZ, w = FBX_GRID_SZ + 1;
+    double verts[(FBX_GRID_SZ + 1) * (FBX_GRID_SZ + 1) * 3];
+    double uvs[(FBX_GRID_SZ + 1) * (FBX_GRID_SZ + 1) * 2];
+    int32_t indices[FBX_GRID_SZ * FBX_GRID_SZ * 4];
+    int32_t uv_idxs[FBX_GRID_SZ * FBX_GRID_SZ * 4];
+    double norms[FBX_GRID_SZ * FBX_GRID_SZ * 4 * 3];
+    for (size_t j = 0; j < w; ++j) {
+        for (size_t i = 0; i < w; ++i) {
+            size_t v = j * w + i;
+            float u = (float)i / n, t = (float)j / n;
+            verts[v * 3 + 0] = u;
+            verts[v * 3 + 1] = gen_height(u + g, t);
+            verts[v * 3 + 2] = t;
+            uvs[v * 2 + 0] = u;
+            uvs[v * 2 + 1] = t;
+        }
+    }
+    /* Quads, the last index of each polygon is stored negated minus one */
+    for (size_t j = 0; j < n; ++j) {
+        for (size_t i = 0; i < n; ++i) {
+            size_t p = (j * n + i) * 4;
+            int32_t a = (int32_t)(j * w + i);
+            int32_t q[4] = {a, a + 1, a + (int32_t)w + 1, a + (int32_t)w};
+            for (int k = 0; k < 4; ++k) {
+                indices[p + k] = k == 3 ? -q[k] - 1 : q[k];
+                uv_idxs[p + k] = q[k];
+                norms[(p + k) * 3 + 0] = 0.0;
+                norms[(p + k) * 3 + 1] = 1.0;
+                norms[(p + k) * 3 + 2] = 0.0;
+            }
+        }
+    }
+
+    char name[32];
+    snprintf(name, sizeof(name), "Geo%lu", (unsigned long)g);
+    fw_begin(fw, "Geometry");
+    fw_prop_i64(fw, FBX_ID_GEOM(g));
+    fw_prop_objname(fw, name, "Geometry");
+    fw_prop_str(fw, "Mesh");
+    fw_begin(fw, "Vertices");
+    fw_prop_arr(fw, 'd', verts, sizeof(verts) / sizeof(double), sizeof(double));
+    fw_end(fw);
+    fw_begin(fw, "PolygonVertexIndex");
+    fw_prop_arr(fw, 'i', indices, sizeof(indices) / sizeof(int32_t), sizeof(int32_t));
+    fw_end(fw);
+    fw_leaf_i32(fw, "GeometryVersion", 124);
+    fw_begin(fw, "LayerElementNormal");
+    fw_prop_i32(fw, 0);
+    fw_leaf_i32(fw, "Version", 101);
+    fw_leaf_str(fw, "Name", "");
+    fw_leaf_str(fw, "MappingInformationType", "ByPolygonVertex");
+    fw_leaf_str(fw, "ReferenceInformationType", "Direct");
+    fw_begin(fw, "Normals");
+    fw_prop_arr(fw, 'd', norms, sizeof(norms) / sizeof(double), sizeof(double));
+    fw_end(fw);
+    fw_end(fw);
+    fw_begin(fw, "LayerElementUV");
+    fw_prop_i32(fw, 0);
+    fw_leaf_i32(fw, "Version", 101);
+    fw_leaf_str(fw, "Name", "map1");
+    fw_leaf_str(fw, "MappingInformationType", "ByPolygonVertex");
+    fw_leaf_str(fw, "ReferenceInformationType", "IndexToDirect");
+    fw_begin(fw, "UV");
+    fw_prop_arr(fw, 'd', uvs, sizeof(uvs) / sizeof(double), sizeof(double));
+    fw_end(fw);
+    fw_begin(fw, "UVIndex");
+    fw_prop_arr(fw, 'i', uv_idxs, sizeof(uv_idxs) / sizeof(int32_t), sizeof(int32_t));
+    fw_end(fw);
+    fw_end(fw);
+    fw_begin(fw, "Layer");
+    fw_prop_i32(fw, 0);
+    fw_leaf_i32(fw, "Version", 100);
+    fw_end(fw);
+    fw_end(fw);
+
+    snprintf(name, sizeof(name), "Mesh%lu", (unsigned long)g);
+    fw_begin(fw, "Model");
+    fw_prop_i64(fw, FBX_ID_MODEL(g));
+    fw_prop_objname(fw, name, "Model");
+    fw_prop_str(fw, "Mesh");
+    fw_leaf_i32(fw, "Version", 232);
+    fw_begin(fw, "Properties70");
+    double t[3] = {(double)(g % 64), 0.0, (double)(g / 64)};
+    fw_p70_vec(fw, "Lcl Translation", "Lcl Translation", t, 3);
+    fw_end(fw);
+    fw_end(fw);
+}
+
+int gen_fbx(const char* fpath, size_t num_geoms, size_t num_frames)
+{
+    if (num_frames == 0)
+        num_frames = 1;
+    int64_t* ktimes = malloc(num_frames * sizeof(int64_t));
+    float* kvals = malloc(num_frames * sizeof(float));
+    if (!ktimes || !kvals) {
+        free(ktimes);
+        free(kvals);
+        return 0;
+    }
+    for (size_t k = 0; k < num_frames; ++k)
+        ktimes[k] = (int64_t)k * (FBX_KTIME_SECOND / 30);
+
+    struct fbx_writer fw;
+    memset(&fw, 0, sizeof(struct fbx_writer));
+    fw_bytes(&fw, "Kaydara FBX Binary  \0\x1a\0", 23);
+    fw_u32(&fw, FBX_VERSION);
+
+    fw_begin(&fw, "FBXHeaderExtension");
+    fw_leaf_i32(&fw, "FBXHeaderVersion", 1003);
+    fw_end(&fw);
+
+    /* Y up, right handed, 30 fps */
+    fw_begin(&fw, "GlobalSettings");
+    fw_leaf_i32(&fw, "Version", 1000);
+    fw_begin(&fw, "Properties70");
+    fw_p70_int(&fw, "UpAxis", "int", 1);
+    fw_p70_int(&fw, "UpAxisSign", "int", 1);
+    fw_p70_int(&fw, "FrontAxis", "int", 2);
+    fw_p70_int(&fw, "FrontAxisSign", "int", 1);
+    fw_p70_int(&fw, "CoordAxis", "int", 0);
+    fw_p70_int(&fw, "CoordAxisSign", "int", 1);
+    fw_p70_int(&fw, "TimeMode", "enum", 6);
+    fw_end(&fw);
+    fw_end(&fw);
+
+    fw_begin(&fw, "Documents");
+    fw_leaf_i32(&fw, "Count", 1);
+    fw_end(&fw);
+    fw_begin(&fw, "Definitions");
+    fw_leaf_i32(&fw, "Version", 100);
+    fw_end(&fw);
+
+    fw_begin(&fw, "Objects");
+    fbx_write_skeleton(&fw, num_frames, ktimes, kvals);
+    for (size_t g = 0; g < num_geoms; ++g)
+        fbx_write_geometry(&fw, g);
+    fw_end(&fw);
+
+    fw_begin(&fw, "Connections");
+    for (int j = 0; j < FBX_NUM_JOINTS; ++j) {
+        fw_connection(&fw, FBX_ID_JOINT(j), j ? FBX_ID_JOINT(j - 1) : 0, 0);
+        for (int c = 0; c < 2; ++c) {
+            fw_connection(&fw, FBX_ID_ACN(j, c), FBX_ID_JOINT(j), c ? "Lcl Rotation" : "Lcl Translation");
+            fw_connection(&fw, FBX_ID_CURVE(j, c, 0), FBX_ID_ACN(j, c), "d|X");
+            fw_connection(&fw, FBX_ID_CURVE(j, c, 1), FBX_ID_ACN(j, c), "d|Y");
+            fw_connection(&fw, FBX_ID_CURVE(j, c, 2), FBX_ID_ACN(j, c), "d|Z");
+        }
+    }
+    for (size_t g = 0; g < num_geoms; ++g) {
+        fw_connection(&fw, FBX_ID_GEOM(g), FBX_ID_MODEL(g), 0);
+        fw_connection(&fw, FBX_ID_MODEL(g), 0, 0);
+    }
+    fw_end(&fw);
+
+    fw_begin(&fw, "Takes");
+    fw_leaf_str(&fw, "Current", "");
+    fw_end(&fw);
+
+    /* Top level null record and footer */
+    static const unsigned char tail[13 + 160] = {0};
+    fw_bytes(&fw, tail, sizeof(tail));
+    free(ktimes);
+    free(kvals);
+
+    int ok = !fw.failed && fw.depth == 0;
+    if (ok) {
+        FILE* f = gen_open(fpath);
+        ok = f && fwrite(fw.buf, 1, fw.len, f) == fw.len;
+        if (f)
+            ok = gen_close(f, ok);
+    }
+    free(fw.buf);
+    return ok;
+}
+
+/*-----------------------------------------------------------------
+ * Images
+ *-----------------------------------------------------------------*/
+/* Smooth gradients with a checker overlay and a little noise,
+ * so that compression ratios resemble real textures */
+static void gen_image_row(unsigned char* row, size_t side, size_t y)
+{
+    for (size_t x = 0; x < side; ++x) {
+        uint32_t h = gen_hash((uint32_t)x, (uint32_t)y);
+        int checker = ((x >> 6) ^ (y >> 6)) & 1;
+        row[x * 4 + 0] = (unsigned char)(x * 255 / side);
+        row[x * 4 + 1] = (unsigned char)(y * 255 / side);
+        row[x * 4 + 2] = (unsigned char)((checker ? 176 : 64) + (h & 15));
+        row[x * 4 + 3] = 255;
+    }
+}
+
+int gen_png(const char* fpath, size_t num_pixels)
+{
+    size_t side = gen_side(num_pixels);
+    FILE* f = gen_open(fpath);
+    png_structp png = png_create_write_struct(PNG_LIBPNG_VER_STRING, 0, 0, 0);
+    png_infop info = png ? png_create_info_struct(png) : 0;
+    unsigned char* row = malloc(side * 4);
+    if (!f || !png || !info || !row || setjmp(png_jmpbuf(png))) {
+        png_destroy_write_struct(&png, &info);
+        free(row);
+        if (f)
+            fclose(f);
+        return 0;
+    }
+
+    png_init_io(png, f);
+    png_set_IHDR(png, info, (png_uint_32)side, (png_uint_32)side, 8, PNG_COLOR_TYPE_RGBA,
+                 PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+    png_set_compression_level(png, 3);
+    png_write_info(png, info);
+    for (size_t y = 0; y < side; ++y) {
+        gen_image_row(row, side, y);
+        png_write_row(png, row);
+    }
+    png_write_end(png, 0);
+    png_destroy_write_struct(&png, &info);
+    free(row);
+    return gen_close(f, 1);
+}
+
+int gen_tiff(const char* fpath, size_t num_pixels)
+{
+    size_t side = gen_side(num_pixels);
+    TIFF* tif = TIFFOpen(fpath, "w");
+    if (!tif)
+        return 0;
+    unsigned char* row = malloc(side * 4);
+    if (!row) {
+        TIFFClose(tif);
+        return 0;
+    }
+
+    uint16 extra[1] = {EXTRASAMPLE_UNASSALPHA};
+    TIFFSetField(tif, TIFFTAG_IMAGEWIDTH, (uint32)side);
+    TIFFSetField(tif, TIFFTAG_IMAGELENGTH, (uint32)side);
+    TIFFSetField(tif, TIFFTAG_BITSPERSAMPLE, 8);
+    TIFFSetField(tif, TIFFTAG_SAMPLESPERPIXEL, 4);
+    TIFFSetField(tif, TIFFTAG_EXTRASAMPLES, 1, extra);
+    TIFFSetField(tif, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_RGB);
+    TIFFSetField(tif, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
+    TIFFSetField(tif, TIFFTAG_COMPRESSION, COMPRESSION_LZW);
+    TIFFSetField(tif, TIFFTAG_PREDICTOR, 2);
+    TIFFSetField(tif, TIFFTAG_ROWSPERSTRIP, TIFFDefaultStripSize(tif, 0));
+
+    int ok = 1;
+    for (size_t y = 0; y < side && ok; ++y) {
+        gen_image_row(row, side, y);
+        ok = TIFFWriteScanline(tif, row, (uint32)y, 0) >= 0;
+    }
+    free(row);
+    TIFFClose(tif);
+    return ok;
+}
+
+/*-----------------------------------------------------------------
+ * Ogg
+ *-----------------------------------------------------------------*/
+#define OGG_RATE 44100
+#define OGG_CHUNK 1024
+
+static int ogg_write_page(FILE* f, ogg_page* og)
+{
+    return fwrite(og->header, 1, og->header_len, f) == (size_t)og->header_len
+        && fwrite(og->body, 1, og->body_len, f) == (size_t)og->body_len;
+}
+
+int gen_ogg(const char* fpath, size_t seconds)
+{
+    FILE* f = gen_open(fpath);
+    if (!f)
+        return 0;
+
+    vorbis_info vi;
+    vorbis_info_init(&vi);
+    if (vorbis_encode_init_vbr(&vi, 2, OGG_RATE, 0.3f) != 0) {
+        vorbis_info_clear(&vi);
+        fclose(f);
+        return 0;
+    }
+    vorbis_comment vc;
+    vorbis_comment_init(&vc);
+    vorbis_comment_add_tag(&vc, "ENCODER", "assetloader bench");
+
+    vorbis_dsp_state vd;
+    vorbis_block vb;
+    ogg_stream_state os;
+    vorbis_analysis_init(&vd, &vi);
+    vorbis_block_init(&vd, &vb);
+    ogg_stream_init(&os, 1);
+
+    /* Header packets go on their own pages */
+    int ok = 1;
+    ogg_packet hdr, hdr_comm, hdr_code;
+    ogg_page og;
+    vorbis_analysis_headerout(&vd, &vc, &hdr, &hdr_comm, &hdr_code);
+    ogg_stream_packetin(&os, &hdr);
+    ogg_stream_packetin(&os, &hdr_comm);
+    ogg_stream_packetin(&os, &hdr_code);
+    while (ok && ogg_stream_flush(&os, &og))
+        ok = ogg_write_page(f, &og);
+
+    /* A slowly modulated chord with some noise */
+    size_t total = seconds * OGG_RATE, done = 0;
+    int eos = 0, flushed = 0;
+    uint32_t seed = 1;
+    while (ok && !eos) {
+        if (done < total) {
+            size_t n = total - done < OGG_CHUNK ? total - done : OGG_CHUNK;
+            float** buf = vorbis_analysis_buffer(&vd, (int)n);
+            for (size_t i = 0; i < n; ++i) {
+                double t = (double)(done + i) / OGG_RATE;
+                double env = 0.5 + 0.5 * sin(2.0 * GEN_PI * 0.25 * t);
+                double s = env * (0.30 * sin(2.0 * GEN_PI * 220.0 * t)
+                                + 0.20 * sin(2.0 * GEN_PI * 277.18 * t)
+                                + 0.15 * sin(2.0 * GEN_PI * 329.63 * t));
+                seed = seed * 1664525u + 1013904223u;
+                double noise = ((double)(seed >> 8) / (double)(1 << 24) - 0.5) * 0.02;
+                buf[0][i] = (float)(s + noise);
+                buf[1][i] = (float)(s - noise);
+            }
+            vorbis_analysis_wrote(&vd, (int)n);
+            done += n;
+        } else if (!flushed) {
+            vorbis_analysis_wrote(&vd, 0);
+            flushed = 1;
+        }
+        while (ok && vorbis_analysis_blockout(&vd, &vb) == 1) {
+            vorbis_analysis(&vb, 0);
+            vorbis_bitrate_addblock(&vb);
+            ogg_packet op;
+            while (ok && vorbis_bitrate_flushpacket(&vd, &op)) {
+                ogg_stream_packetin(&os, &op);
+                while (ok && ogg_stream_pageout(&os, &og)) {
+                    ok = ogg_write_page(f, &og);
+                    if (ogg_page_eos(&og))
+                        eos = 1;
+                }
+            }
+        }
+        if (flushed && !eos) {
+            /* Nothing left to encode */
+            while (ok && ogg_stream_flush(&os, &og))
+                ok = ogg_write_page(f, &og);
+            eos = 1;
+        }
+    }
+
+    ogg_stream_clear(&os);
+    vorbis_block_clear(&vb);
+    vorbis_dsp_clear(&vd);
+    vorbis_comment_clear(&vc);
+    vorbis_info_clear(&vi);
+    return gen_close(f, ok);
+}
@@ -0,0 +1,55 @@
+/*********************************************************************************************************************/
+/*                                                  /===-_---~~~~~~~~~------____                                     */
+/*                                                 |===-~___                _,-'                                     */
+/*                  -==\\                         `//~\\   ~~~~`---.___.-~~                                          */
+/*              ______-==|                         | |  \\           _-~`                                            */
+/*        __--~~~  ,-/-==\\                        | |   `\        ,'                                                */
+/*     _-~       /'    |  \\                      / /      \      /                                                  */
+/*   .'        /       |   \\                   /' /        \   /'                                                   */
+/*  /  ____  /         |    \`\.__/-~~ ~ \ _ _/'  /          \/'                                                     */
+/* /-'~    ~~~~~---__  |     ~-/~         ( )   /'        _--~`                                                      */
+/*                   \_|      /        _)   ;  ),   __--~~                                                           */
+/*                     '~~--_/      _-~/-  / \   '-~ \                                                               */
+/*                    {\__--_/}    / \\_>- )<__\      \                                                              */
+/*                    /'   (_/  _-~  | |__>--<__|      |                                                             */
+/*                   |0  0 _/) )-~     | |__>--<__|     |                                                            */
+/*                   / /~ ,_/       / /__>---<__/      |                                                             */
+/*                  o o _//        /-~_>---<__-~      /                                                              */
+/*                  (^(~          /~_>---<__-      _-~                                                               */
+/*                 ,/|           /__>--<__/     _-~                                                                  */
+/*              ,//('(          |__>--<__|     /                  .----_                                             */
+/*             ( ( '))          |__>--<__|    |                 /' _---_~\                                           */
+/*          `-)) )) (           |__>--<__|    |               /'  /     ~\`\                                         */
+/*         ,/,'//( (             \__>--<__\    \            /'  //        ||                                         */
+/*       ,( ( ((, ))              ~-__>--<_~-_  ~--____---~' _/'/        /'                                          */
+/*     `~/  )` ) ,/|                 ~-_~>--<_/-__       __-~ _/                                                     */
+/*   ._-~//( )/ )) `                    ~~-'_/_/ /~~~~~~~__--~                                                       */
+/*    ;'( ')/ ,)(                              ~~~~~~~~~~                                                            */
+/*   ' ') '( (/                                                                                                      */
+/*     '   '  `                                                                                                      */
+/*********************************************************************************************************************/
+#ifndef _GEN_H_
+#define _GEN_H_
+
+#include <stddef.h>
+
+/* Synthetic input generators for the scale benchmark. Each writes a file of
+ * the requested size with content shaped like real assets (grids, smooth
+ * images, tones) and returns non zero on success. Outputs are streamed where
+ * the format allows it, so inputs far larger than the loaders' memory budget
+ * can be produced */
+
+/* Triangulated grid with positions, texcoords and normals */
+int gen_obj(const char* fpath, size_t num_tris);
+/* Point cloud with positions, normals and colors */
+int gen_ply(const char* fpath, size_t num_points, int binary);
+/* Binary fbx with given number of small grid geometries and a short
+ * skeleton animated over given number of frames. Arrays are deflated */
+int gen_fbx(const char* fpath, size_t num_geoms, size_t num_frames);
+/* Square RGBA image covering given number of pixels */
+int gen_png(const char* fpath, size_t num_pixels);
+int gen_tiff(const char* fpath, size_t num_pixels);
+/* Stereo 44.1kHz vorbis stream of given length */
+int gen_ogg(const char* fpath, size_t seconds);
+
+#endif /* ! _GEN_H_ */
@@ -0,0 +1,391 @@
+/*********************************************************************************************************************/
+/*                                                  /===-_---~~~~~~~~~------____                                     */
+/*                                                 |===-~___                _,-'                                     */
+/*                  -==\\                         `//~\\   ~~~~`---.___.-~~                                          */
+/*              ______-==|                         | |  \\           _-~`                                            */
+/*        __--~~~  ,-/-==\\                        | |   `\        ,'                                                */
+/*     _-~       /'    |  \\                      / /      \      /                                                  */
+/*   .'        /       |   \\                   /' /        \   /'                                                   */
+/*  /  ____  /         |    \`\.__/-~~ ~ \ _ _/'  /          \/'                                                     */
+/* /-'~    ~~~~~---__  |     ~-/~         ( )   /'        _--~`                                                      */
+/*                   \_|      /        _)   ;  ),   __--~~                                                           */
+/*                     '~~--_/      _-~/-  / \   '-~ \                                                               */
+/*                    {\__--_/}    / \\_>- )<__\      \                                                              */
+/*                    /'   (_/  _-~  | |__>--<__|      |                                                             */
+/*                   |0  0 _/) )-~     | |__>--<__|     |                                                            */
+/*                   / /~ ,_/       / /__>---<__/      |                                                             */
+/*                  o o _//        /-~_>---<__-~      /                                                              */
+/*                  (^(~          /~_>---<__-      _-~                                                               */
+/*                 ,/|           /__>--<__/     _-~                                                                  */
+/*              ,//('(          |__>--<__|     /                  .----_                                             */
+/*             ( ( '))          |__>--<__|    |                 /' _---_~\                                           */
+/*          `-)) )) (           |__>--<__|    |               /'  /     ~\`\                                         */
+/*         ,/,'//( (             \__>--<__\    \            /'  //        ||                                         */
+/*       ,( ( ((, ))              ~-__>--<_~-_  ~--____---~' _/'/        /'                                          */
+/*     `~/  )` ) ,/|                 ~-_~>--<_/-__       __-~ _/                                                     */
+/*   ._-~//( )/ )) `                    ~~-'_/_/ /~~~~~~~__--~                                                       */
+/*    ;'( ')/ ,)(                              ~~~~~~~~~~                                                            */
+/*   ' ') '( (/                                                                                                      */
+/*     '   '  `                                                                                                      */
+/*********************************************************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <plat.h>
+#include <vector.h>
+#include <assets/assetload.h>
+#include <assets/fileload.h>
+#include <assets/font/texture_font.h>
+#include "bench.h"
+#ifdef OS_WINDOWS
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <time.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+#endif
+
+/* Loads every supported asset found under a directory tree a number of times
+ * and reports throughput, peak memory and allocation counts as JSON, so that
+ * results can be diffed across versions.
+ * Usage: bench [-n iterations] [-o output.json] [root]
+ *        bench scale [options] (see scale.c) */
+
+#define DEFAULT_ROOT "../demo/ext"
+#define DEFAULT_ITERATIONS 10
+#define FONT_GLYPHS "ABCDEFGHIJKLMNOPQRSTUVWXYZ abcdefghijklmnopqrstuvwxyz_0123456789"
+
+/*-----------------------------------------------------------------
+ * Formats
+ *-----------------------------------------------------------------*/
+enum bench_kind {
+    BENCH_ASSET = 0, /* Goes through asset_load */
+    BENCH_FONT       /* Goes through the texture font loader */
+};
+
+struct bench_format {
+    const char* ext;
+    enum bench_kind kind;
+    enum asset_type type;
+    /* Accumulated over all iterations */
+    size_t num_files;
+    uint64_t bytes;
+    uint64_t loads;
+    uint64_t failures;
+    uint64_t ns;
+};
+
+static struct bench_format formats[] = {
+    {"obj",  BENCH_ASSET, ASSET_MODEL,    0, 0, 0, 0, 0},
+    {"fbx",  BENCH_ASSET, ASSET_MODEL,    0, 0, 0, 0, 0},
+    {"ply",  BENCH_ASSET, ASSET_MODEL,    0, 0, 0, 0, 0},
+    {"iqm",  BENCH_ASSET, ASSET_MODEL,    0, 0, 0, 0, 0},
+    {"mdl",  BENCH_ASSET, ASSET_MODEL,    0, 0, 0, 0, 0},
+    {"anm",  BENCH_ASSET, ASSET_FRAMESET, 0, 0, 0, 0, 0},
+    {"png",  BENCH_ASSET, ASSET_IMAGE,    0, 0, 0, 0, 0},
+    {"jpg",  BENCH_ASSET, ASSET_IMAGE,    0, 0, 0, 0, 0},
+    {"jpeg", BENCH_ASSET, ASSET_IMAGE,    0, 0, 0, 0, 0},
+    {"tga",  BENCH_ASSET, ASSET_IMAGE,    0, 0, 0, 0, 0},
+    {"tif",  BENCH_ASSET, ASSET_IMAGE,    0, 0, 0, 0, 0},
+    {"tiff", BENCH_ASSET, ASSET_IMAGE,    0, 0, 0, 0, 0},
+    {"ktx",  BENCH_ASSET, ASSET_IMAGE,    0, 0, 0, 0, 0},
+    {"wav",  BENCH_ASSET, ASSET_SOUND,    0, 0, 0, 0, 0},
+    {"ogg",  BENCH_ASSET, ASSET_SOUND,    0, 0, 0, 0, 0},
+    {"ttf",  BENCH_FONT,  ASSET_IMAGE,    0, 0, 0, 0, 0}
+};
+#define NUM_FORMATS (sizeof(formats) / sizeof(formats[0]))
+
+static struct bench_format* format_from_path(const char* path)
+{
+    const char* dot = strrchr(path, '.');
+    const char* slash = strrchr(path, '/');
+    if (!dot || (slash && dot < slash))
+        return 0;
+    for (size_t i = 0; i < NUM_FORMATS; ++i) {
+        const char* a = dot + 1;
+        const char* b = formats[i].ext;
+        while (*a && *b && (*a | 0x20) == *b) {
+            ++a;
+            ++b;
+        }
+        if (!*a && !*b)
+            return &formats[i];
+    }
+    return 0;
+}
+
+/*-----------------------------------------------------------------
+ * Platform helpers
+ *-----------------------------------------------------------------*/
+uint64_t bench_now_ns()
+{
+#ifdef OS_WINDOWS
+    LARGE_INTEGER freq, cnt;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&cnt);
+    return (uint64_t)((double)cnt.QuadPart * 1e9 / (double)freq.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+uint64_t bench_peak_rss()
+{
+#ifdef OS_WINDOWS
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+        return 0;
+    return (uint64_t)pmc.PeakWorkingSetSize;
+#else
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) != 0)
+        return 0;
+#ifdef OS_OSX
+    return (uint64_t)ru.ru_maxrss;
+#else
+    return (uint64_t)ru.ru_maxrss * 1024;
+#endif
+#endif
+}
+
+struct bench_file {
+    char* path;
+    size_t size;
+    struct bench_format* fmt;
+};
+
+static void add_file(struct vector* files, const char* path)
+{
+    struct bench_format* fmt = format_from_path(path);
+    if (!fmt)
+        return;
+    long sz = filesize(path);
+    if (sz <= 0)
+        return;
+    struct bench_file bf;
+    bf.path = strdup(path);
+    bf.size = (size_t)sz;
+    bf.fmt = fmt;
+    fmt->num_files++;
+    vector_append(files, &bf);
+}
+
+/* Recursively collects the files with known extensions under given dir */
+static void gather_files(struct vector* files, const char* dir)
+{
+    char path[1024];
+#ifdef OS_WINDOWS
+    WIN32_FIND_DATAA fd;
+    snprintf(path, sizeof(path), "%s/*", dir);
+    HANDLE h = FindFirstFileA(path, &fd);
+    if (h == INVALID_HANDLE_VALUE)
+        return;
+    do {
+        if (strcmp(fd.cFileName, ".") == 0 || strcmp(fd.cFileName, "..") == 0)
+            continue;
+        snprintf(path, sizeof(path), "%s/%s", dir, fd.cFileName);
+        if (fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+            gather_files(files, path);
+        else
+            add_file(files, path);
+    } while (FindNextFileA(h, &fd));
+    FindClose(h);
+#else
+    DIR* d = opendir(dir);
+    if (!d)
+        return;
+    struct dirent* de;
+    while ((de = readdir(d))) {
+        if (strcmp(de->d_name, ".") == 0 || strcmp(de->d_name, "..") == 0)
+            continue;
+        snprintf(path, sizeof(path), "%s/%s", dir, de->d_name);
+        struct stat st;
+        if (stat(path, &st) != 0)
+            continue;
+        if (S_ISDIR(st.st_mode))
+            gather_files(files, path);
+        else if (S_ISREG(st.st_mode))
+            add_file(files, path);
+    }
+    closedir(d);
+#endif
+}
+
+/* Keeps runs comparable regardless of readdir order */
+static int bench_file_cmp(const void* a, const void* b)
+{
+    return strcmp(((const struct bench_file*)a)->path, ((const struct bench_file*)b)->path);
+}
+
+/*-----------------------------------------------------------------
+ * Loading
+ *-----------------------------------------------------------------*/
+/* Loads and frees a single file, returns non zero on success */
+static int bench_load(struct bench_file* bf)
+{
+    if (bf->fmt->kind == BENCH_FONT) {
+        texture_atlas_t* atlas = texture_atlas_new(512, 512, 1);
+        texture_font_t* font = texture_font_new_from_file(atlas, 16, bf->path);
+        if (font) {
+            texture_font_load_glyphs(font, FONT_GLYPHS);
+            texture_font_delete(font);
+        }
+        texture_atlas_delete(atlas);
+        return font != 0;
+    }
+    void* asset = asset_load(bf->fmt->type, bf->path, 0);
+    if (!asset)
+        return 0;
+    asset_delete(bf->fmt->type, asset);
+    return 1;
+}
+
+/*-----------------------------------------------------------------
+ * Report
+ *-----------------------------------------------------------------*/
+void bench_json_string(FILE* f, const char* s)
+{
+    fputc('"', f);
+    for (; *s; ++s) {
+        if (*s == '"' || *s == '\\')
+            fprintf(f, "\\%c", *s);
+        else if ((unsigned char)*s < 0x20)
+            fprintf(f, "\\u%04x", (unsigned char)*s);
+        else
+            fputc(*s, f);
+    }
+    fputc('"', f);
+}
+
+static void json_rates(FILE* f, uint64_t bytes, uint64_t loads, uint64_t ns)
+{
+    double secs = (double)ns * 1e-9;
+    fprintf(f, "\"seconds\": %.6f, \"mb_per_s\": %.3f, \"assets_per_s\": %.3f",
+            secs,
+            secs > 0.0 ? (double)bytes / (1024.0 * 1024.0) / secs : 0.0,
+            secs > 0.0 ? (double)loads / secs : 0.0);
+}
+
+static void write_report(FILE* f, const char* root, unsigned int iterations, const struct asset_stats* st, uint64_t rss)
+{
+    uint64_t bytes = 0, loads = 0, failures = 0, ns = 0;
+    size_t num_files = 0;
+    for (size_t i = 0; i < NUM_FORMATS; ++i) {
+        num_files += formats[i].num_files;
+        bytes += formats[i].bytes;
+        loads += formats[i].loads;
+        failures += formats[i].failures;
+        ns += formats[i].ns;
+    }
+
+    fprintf(f, "{\n  \"root\": ");
+    bench_json_string(f, root);
+    fprintf(f, ",\n  \"iterations\": %u,\n", iterations);
+    fprintf(f, "  \"total\": {\"files\": %lu, \"bytes\": %llu, \"loads\": %llu, \"failures\": %llu, ",
+            (unsigned long)num_files, (unsigned long long)bytes, (unsigned long long)loads, (unsigned long long)failures);
+    json_rates(f, bytes, loads, ns);
+    fprintf(f, "},\n  \"formats\": {");
+    int first = 1;
+    for (size_t i = 0; i < NUM_FORMATS; ++i) {
+        struct bench_format* fmt = &formats[i];
+        if (!fmt->num_files)
+            continue;
+        fprintf(f, "%s\n    \"%s\": {\"files\": %lu, \"bytes\": %llu, \"loads\": %llu, \"failures\": %llu, ",
+                first ? "" : ",", fmt->ext, (unsigned long)fmt->num_files,
+                (unsigned long long)fmt->bytes, (unsigned long long)fmt->loads, (unsigned long long)fmt->failures);
+        json_rates(f, fmt->bytes, fmt->loads, fmt->ns);
+        fprintf(f, "}");
+        first = 0;
+    }
+    fprintf(f, "\n  },\n  \"phases\": {");
+    for (int ph = 0; ph < ASSET_PHASE_COUNT; ++ph) {
+        fprintf(f, "%s\n    \"%s\": {\"ns\": %llu, \"calls\": %llu}",
+                ph ? "," : "", asset_phase_name(ph),
+                (unsigned long long)st->phase_ns[ph], (unsigned long long)st->phase_calls[ph]);
+    }
+    fprintf(f, "\n  },\n  \"memory\": {\"peak_rss_bytes\": %llu, \"bytes_allocated\": %llu, \"allocs\": %llu, \"frees\": %llu}\n}\n",
+            (unsigned long long)rss, (unsigned long long)st->bytes_allocated,
+            (unsigned long long)st->num_allocs, (unsigned long long)st->num_frees);
+}
+
+/*-----------------------------------------------------------------
+ * Entrypoint
+ *-----------------------------------------------------------------*/
+int main(int argc, char* argv[])
+{
+    if (argc > 1 && strcmp(argv[1], "scale") == 0)
+        return scale_main(argc - 1, argv + 1);
+
+    const char* root = DEFAULT_ROOT;
+    const char* out_path = 0;
+    unsigned int iterations = DEFAULT_ITERATIONS;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+            iterations = (unsigned int)strtoul(argv[++i], 0, 10);
+        else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+            out_path = argv[++i];
+        else if (argv[i][0] == '-') {
+            fprintf(stderr, "Usage: %s [-n iterations] [-o output.json] [root]\n", argv[0]);
+            return 1;
+        } else
+            root = argv[i];
+    }
+    if (iterations == 0)
+        iterations = 1;
+
+    /* Collect the input set */
+    struct vector files;
+    vector_init(&files, sizeof(struct bench_file));
+    gather_files(&files, root);
+    if (files.size == 0) {
+        fprintf(stderr, "No supported assets found under %s\n", root);
+        vector_destroy(&files);
+        return 1;
+    }
+    qsort(vector_at(&files, 0), files.size, sizeof(struct bench_file), bench_file_cmp);
+
+    /* Warm the page cache and lazily initialized decoder state once,
+     * so the first iteration is not an outlier */
+    for (size_t i = 0; i < files.size; ++i)
+        bench_load(vector_at(&files, i));
+
+    /* Timed runs */
+    asset_stats_reset();
+    asset_stats_enable(1);
+    for (unsigned int it = 0; it < iterations; ++it) {
+        for (size_t i = 0; i < files.size; ++i) {
+            struct bench_file* bf = vector_at(&files, i);
+            uint64_t t0 = bench_now_ns();
+            int ok = bench_load(bf);
+            bf->fmt->ns += bench_now_ns() - t0;
+            bf->fmt->loads++;
+            if (ok)
+                bf->fmt->bytes += bf->size;
+            else
+                bf->fmt->failures++;
+        }
+    }
+    asset_stats_enable(0);
+    struct asset_stats st;
+    asset_stats_get(&st);
+
+    /* Report */
+    FILE* f = out_path ? fopen(out_path, "w") : stdout;
+    if (!f) {
+        fprintf(stderr, "Could not open %s\n", out_path);
+        f = stdout;
+    }
+    write_report(f, root, iterations, &st, bench_peak_rss());
+    if (f != stdout)
+        fclose(f);
+
+    for (size_t i = 0; i < files.size; ++i)
+        free(((struct bench_file*)vector_at(&files, i))->path);
+    vector_destroy(&files);
+    return 0;
+}
@@ -0,0 +1,340 @@
+/*********************************************************************************************************************/
+/*                                                  /===-_---~~~~~~~~~------____                                     */
+/*                                                 |===-~___                _,-'                                     */
+/*                  -==\\                         `//~\\   ~~~~`---.___.-~~                                          */
+/*              ______-==|                         | |  \\           _-~`                                            */
+/*        __--~~~  ,-/-==\\                        | |   `\        ,'                                                */
+/*     _-~       /'    |  \\                      / /      \      /                                                  */
+/*   .'        /       |   \\                   /' /        \   /'                                                   */
+/*  /  ____  /         |    \`\.__/-~~ ~ \ _ _/'  /          \/'                                                     */
+/* /-'~    ~~~~~---__  |     ~-/~         ( )   /'        _--~`                                                      */
+/*                   \_|      /        _)   ;  ),   __--~~                                                           */
+/*                     '~~--_/      _-~/-  / \   '-~ \                                                               */
+/*                    {\__--_/}    / \\_>- )<__\      \                                                              */
+/*                    /'   (_/  _-~  | |__>--<__|      |                                                             */
+/*                   |0  0 _/) )-~     | |__>--<__|     |                                                            */
+/*                   / /~ ,_/       / /__>---<__/      |                                                             */
+/*                  o o _//        /-~_>---<__-~      /                                                              */
+/*                  (^(~          /~_>---<__-      _-~                                                               */
+/*                 ,/|           /__>--<__/     _-~                                                                  */
+/*              ,//('(          |__>--<__|     /                  .----_                                             */
+/*             ( ( '))          |__>--<__|    |                 /' _---_~\                                           */
+/*          `-)) )) (           |__>--<__|    |               /'  /     ~\`\                                         */
+/*         ,/,'//( (             \__>--<__\    \            /'  //        ||                                         */
+/*       ,( ( ((, ))              ~-__>--<_~-_  ~--____---~' _/'/        /'                                          */
+/*     `~/  )` ) ,/|                 ~-_~>--<_/-__       __-~ _/                                                     */
+/*   ._-~//( )/ )) `                    ~~-'_/_/ /~~~~~~~__--~                                                       */
+/*    ;'( ')/ ,)(                              ~~~~~~~~~~                                                            */
+/*   ' ') '( (/                                                                                                      */
+/*     '   '  `                                                                                                      */
+/*********************************************************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <assets/assetload.h>
+#include <assets/fileload.h>
+#include "bench.h"
+#include "gen.h"
+
+/* Generates inputs of growing size for each format, times a single decode
+ * of each and reports how time and memory grow with input size. A series'
+ * exponent is the least squares slope of log(time) over log(size): about 1
+ * for linear loaders, about 2 when a quadratic path dominates.
+ * Usage: bench scale [-s steps] [-f] [-k] [-d dir] [-o output.json] [series...]
+ *   -s  Number of doubling steps per series (default 4)
+ *   -f  Run every series up to its full size instead
+ *   -k  Keep generated files
+ *   -d  Directory for generated files (default current) */
+
+#define DEFAULT_STEPS 4
+
+/*-----------------------------------------------------------------
+ * Memory tracking
+ *-----------------------------------------------------------------*/
+/* Asset allocator keeping the live and peak byte counts of a decode */
+struct track_state {
+    size_t cur;
+    size_t peak;
+    uint64_t allocs;
+};
+
+#define TRACK_HDR_SZ 16
+
+static void* track_alloc(void* userdata, size_t sz)
+{
+    struct track_state* ts = userdata;
+    unsigned char* p = malloc(sz + TRACK_HDR_SZ);
+    if (!p)
+        return 0;
+    *(size_t*)p = sz;
+    ts->cur += sz;
+    if (ts->cur > ts->peak)
+        ts->peak = ts->cur;
+    ts->allocs++;
+    return p + TRACK_HDR_SZ;
+}
+
+static void* track_realloc(void* userdata, void* ptr, size_t sz)
+{
+    if (!ptr)
+        return track_alloc(userdata, sz);
+    struct track_state* ts = userdata;
+    unsigned char* base = (unsigned char*)ptr - TRACK_HDR_SZ;
+    size_t old_sz = *(size_t*)base;
+    unsigned char* p = realloc(base, sz + TRACK_HDR_SZ);
+    if (!p)
+        return 0;
+    *(size_t*)p = sz;
+    ts->cur = ts->cur - old_sz + sz;
+    if (ts->cur > ts->peak)
+        ts->peak = ts->cur;
+    ts->allocs++;
+    return p + TRACK_HDR_SZ;
+}
+
+static void track_free(void* userdata, void* ptr)
+{
+    if (!ptr)
+        return;
+    struct track_state* ts = userdata;
+    unsigned char* base = (unsigned char*)ptr - TRACK_HDR_SZ;
+    ts->cur -= *(size_t*)base;
+    free(base);
+}
+
+/*-----------------------------------------------------------------
+ * Series
+ *-----------------------------------------------------------------*/
+typedef int(*scale_gen_fn)(const char* fpath, size_t n);
+typedef void*(*scale_load_fn)(const unsigned char* data, size_t sz);
+typedef void(*scale_delete_fn)(void* asset);
+
+struct scale_series {
+    const char* name;
+    const char* ext;
+    const char* unit;
+    size_t min;  /* First size */
+    size_t max;  /* Last size of a full run */
+    scale_gen_fn gen;
+    scale_load_fn load;
+    scale_delete_fn del;
+    const char* skip; /* Why the series cannot run, null if it can */
+};
+
+static int gen_ply_binary(const char* fpath, size_t n) { return gen_ply(fpath, n, 1); }
+static int gen_ply_ascii(const char* fpath, size_t n) { return gen_ply(fpath, n, 0); }
+static int gen_fbx_geoms(const char* fpath, size_t n) { return gen_fbx(fpath, n, 30); }
+static int gen_fbx_frames(const char* fpath, size_t n) { return gen_fbx(fpath, 1, n); }
+
+static void* load_obj(const unsigned char* data, size_t sz) { return model_from_obj(data, sz); }
+static void* load_ply(const unsigned char* data, size_t sz) { return model_from_ply(data, sz, 0); }
+static void* load_fbx(const unsigned char* data, size_t sz) { return model_from_fbx(data, sz); }
+static void* load_png(const unsigned char* data, size_t sz) { return image_from_png(data, sz); }
+static void* load_tiff(const unsigned char* data, size_t sz) { return image_from_tiff(data, sz); }
+static void* load_ogg(const unsigned char* data, size_t sz) { return sound_from_ogg(data, sz); }
+
+static void delete_model(void* asset) { model_delete(asset); }
+static void delete_image(void* asset) { image_delete(asset); }
+static void delete_sound(void* asset) { sound_delete(asset); }
+
+static struct scale_series series[] = {
+    {"obj",        "obj",  "triangles",  100000,   51200000, gen_obj,        load_obj,  delete_model, 0},
+    {"ply_binary", "ply",  "points",     100000,   51200000, gen_ply_binary, load_ply,  delete_model, 0},
+    {"ply_ascii",  "ply",  "points",     100000,   51200000, gen_ply_ascii,  load_ply,  delete_model,
+        "ascii ply bodies are not decoded by the ply loader"},
+    {"fbx_geoms",  "fbx",  "geometries", 64,       8192,     gen_fbx_geoms,  load_fbx,  delete_model, 0},
+    {"fbx_frames", "fbx",  "frames",     1000,     128000,   gen_fbx_frames, load_fbx,  delete_model, 0},
+    {"png",        "png",  "pixels",     1 << 20,  1 << 28,  gen_png,        load_png,  delete_image, 0},
+    {"tiff",       "tif",  "pixels",     1 << 20,  1 << 28,  gen_tiff,       load_tiff, delete_image, 0},
+    {"ogg",        "ogg",  "seconds",    15,       3840,     gen_ogg,        load_ogg,  delete_sound, 0}
+};
+#define NUM_SERIES (sizeof(series) / sizeof(series[0]))
+
+struct scale_sample {
+    size_t n;
+    int ok;
+    uint64_t file_bytes;
+    uint64_t gen_ns;
+    uint64_t load_ns;
+    uint64_t free_ns;
+    size_t peak_bytes;
+    uint64_t allocs;
+    uint64_t rss;
+};
+
+/* Generates, decodes and deletes a single input */
+static void scale_sample_run(struct scale_series* s, size_t n, const char* dir, int keep, struct scale_sample* out)
+{
+    memset(out, 0, sizeof(struct scale_sample));
+    out->n = n;
+
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/scale_%s_%lu.%s", dir, s->name, (unsigned long)n, s->ext);
+    uint64_t t0 = bench_now_ns();
+    int ok = s->gen(path, n);
+    out->gen_ns = bench_now_ns() - t0;
+    if (!ok) {
+        fprintf(stderr, "Could not generate %s\n", path);
+        remove(path);
+        return;
+    }
+
+    struct file_blob fb;
+    if (!file_blob_open(&fb, path, FILE_ACCESS_SEQUENTIAL)) {
+        fprintf(stderr, "Could not open %s\n", path);
+        if (!keep)
+            remove(path);
+        return;
+    }
+    out->file_bytes = fb.size;
+    /* Fault the input in so only decoding is timed */
+    volatile unsigned char sink = 0;
+    for (size_t i = 0; i < fb.size; i += 4096)
+        sink ^= fb.data[i];
+    (void)sink;
+
+    struct track_state ts;
+    memset(&ts, 0, sizeof(struct track_state));
+    struct asset_allocator track = {track_alloc, track_realloc, track_free, &ts};
+    asset_set_allocator(&track);
+    t0 = bench_now_ns();
+    void* asset = s->load(fb.data, fb.size);
+    out->load_ns = bench_now_ns() - t0;
+    out->peak_bytes = ts.peak;
+    out->allocs = ts.allocs;
+    out->rss = bench_peak_rss();
+    if (asset) {
+        t0 = bench_now_ns();
+        s->del(asset);
+        out->free_ns = bench_now_ns() - t0;
+        out->ok = 1;
+    } else {
+        const char* err = get_last_asset_load_error();
+        fprintf(stderr, "Could not load %s: %s\n", path, err ? err : "unknown error");
+    }
+    asset_set_allocator(0);
+
+    file_blob_close(&fb);
+    if (!keep)
+        remove(path);
+}
+
+/* Least squares slope of log(load time) over log(size) */
+static double scale_exponent(struct scale_sample* samples, size_t num)
+{
+    double sx = 0.0, sy = 0.0, sxx = 0.0, sxy = 0.0;
+    size_t cnt = 0;
+    for (size_t i = 0; i < num; ++i) {
+        if (!samples[i].ok || samples[i].load_ns == 0)
+            continue;
+        double x = log((double)samples[i].n);
+        double y = log((double)samples[i].load_ns);
+        sx += x; sy += y; sxx += x * x; sxy += x * y;
+        ++cnt;
+    }
+    double den = cnt * sxx - sx * sx;
+    if (cnt < 2 || den == 0.0)
+        return 0.0;
+    return (cnt * sxy - sx * sy) / den;
+}
+
+static void scale_series_report(FILE* f, struct scale_series* s, struct scale_sample* samples, size_t num)
+{
+    fprintf(f, "    \"%s\": {\"unit\": \"%s\"", s->name, s->unit);
+    if (s->skip) {
+        fprintf(f, ", \"skipped\": ");
+        bench_json_string(f, s->skip);
+        fprintf(f, "}");
+        return;
+    }
+    fprintf(f, ", \"exponent\": %.3f, \"samples\": [", scale_exponent(samples, num));
+    for (size_t i = 0; i < num; ++i) {
+        struct scale_sample* sm = samples + i;
+        double secs = (double)sm->load_ns * 1e-9;
+        fprintf(f, "%s\n      {\"n\": %lu, \"ok\": %s, \"file_bytes\": %llu, \"gen_seconds\": %.6f, "
+                   "\"load_seconds\": %.6f, \"free_seconds\": %.6f, \"mb_per_s\": %.3f, "
+                   "\"peak_asset_bytes\": %llu, \"allocs\": %llu, \"peak_rss_bytes\": %llu}",
+                i ? "," : "", (unsigned long)sm->n, sm->ok ? "true" : "false",
+                (unsigned long long)sm->file_bytes, (double)sm->gen_ns * 1e-9, secs, (double)sm->free_ns * 1e-9,
+                secs > 0.0 ? (double)sm->file_bytes / (1024.0 * 1024.0) / secs : 0.0,
+                (unsigned long long)sm->peak_bytes, (unsigned long long)sm->allocs, (unsigned long long)sm->rss);
+    }
+    fprintf(f, "\n    ]}");
+}
+
+/*-----------------------------------------------------------------
+ * Entrypoint
+ *-----------------------------------------------------------------*/
+static int series_selected(struct scale_series* s, int argc, char* argv[], int first_name)
+{
+    if (first_name >= argc)
+        return 1;
+    for (int i = first_name; i < argc; ++i)
+        if (strcmp(argv[i], s->name) == 0)
+            return 1;
+    return 0;
+}
+
+int scale_main(int argc, char* argv[])
+{
+    unsigned int steps = DEFAULT_STEPS;
+    int full = 0, keep = 0, first_name = argc;
+    const char* dir = ".";
+    const char* out_path = 0;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+            steps = (unsigned int)strtoul(argv[++i], 0, 10);
+        else if (strcmp(argv[i], "-f") == 0)
+            full = 1;
+        else if (strcmp(argv[i], "-k") == 0)
+            keep = 1;
+        else if (strcmp(argv[i], "-d") == 0 && i + 1 < argc)
+            dir = argv[++i];
+        else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+            out_path = argv[++i];
+        else if (argv[i][0] == '-') {
+            fprintf(stderr, "Usage: bench scale [-s steps] [-f] [-k] [-d dir] [-o output.json] [series...]\n");
+            return 1;
+        } else {
+            first_name = i;
+            break;
+        }
+    }
+    if (steps == 0)
+        steps = 1;
+
+    FILE* f = out_path ? fopen(out_path, "w") : stdout;
+    if (!f) {
+        fprintf(stderr, "Could not open %s\n", out_path);
+        f = stdout;
+    }
+    fprintf(f, "{\n  \"full\": %s,\n  \"series\": {\n", full ? "true" : "false");
+
+    int first = 1;
+    for (size_t i = 0; i < NUM_SERIES; ++i) {
+        struct scale_series* s = &series[i];
+        if (!series_selected(s, argc, argv, first_name))
+            continue;
+
+        /* Sizes double from min, up to max on full runs */
+        struct scale_sample samples[64];
+        size_t num = 0;
+        if (!s->skip) {
+            size_t n = s->min;
+            for (unsigned int k = 0; num < 64 && (full ? n <= s->max : k < steps); ++k, n *= 2) {
+                fprintf(stderr, "%s: %lu %s\n", s->name, (unsigned long)n, s->unit);
+                scale_sample_run(s, n, dir, keep, &samples[num++]);
+            }
+        }
+        fprintf(f, "%s", first ? "" : ",\n");
+        scale_series_report(f, s, samples, num);
+        fflush(f);
+        first = 0;
+    }
+
+    fprintf(f, "\n  }\n}\n");
+    if (f != stdout)
+        fclose(f);
+    return 0;
+}
@@ -140,14 +140,24 @@ static void print_animation_info(const char* filename, struct frameset* fset)
     printf(" Num frames: %lu\n", fset->num_frames);
 }
 
-static void upload_model_geom_data(const char* filename, const char* anm_filename, struct model_handle* model)
+static void print_load_stats()
 {
-    /* Parse file */
+    struct asset_stats st;
+    asset_stats_get(&st);
+    printf("Assets loaded: %lu (%lu KB read)\n", (unsigned long)st.assets_loaded, (unsigned long)(st.bytes_read / 1024));
+    for (int i = 0; i < ASSET_PHASE_COUNT; ++i)
+        printf(" %-12s %8.2f msec (%lu calls)\n", asset_phase_name(i), st.phase_ns[i] / 1e6, (unsigned long)st.phase_calls[i]);
+    printf(" Allocations: %lu, %lu KB\n\n", (unsigned long)st.num_allocs, (unsigned long)(st.bytes_allocated / 1024));
+}
+
+static void upload_model_geom_data(const char* filename, struct asset_future* mfut, const char* anm_filename, struct asset_future* afut, struct model_handle* model)
+{
+    /* Wait for background parse */
     clock_t t1 = clock();
-    struct model* m = model_from_file(filename);
+    struct model* m = asset_future_wait(mfut);
     clock_t t2 = clock();
     print_model_info(filename, m);
-    printf("Load time %lu msec\n\n", 1000 * (t2 - t1) / CLOCKS_PER_SEC);
+    printf("Wait time %lu msec\n\n", 1000 * (t2 - t1) / CLOCKS_PER_SEC);
 
     /* Allocate handle memory */
     model->num_meshes = m->num_meshes;
@@ -219,12 +229,12 @@ static void upload_model_geom_data(const char* filename, const char* anm_filenam
 
     /* Load animation file if given */
     if (anm_filename) {
-        /* Load and parse */
+        /* Wait for background parse and take ownership */
         t1 = clock();
-        struct frameset* fset = frameset_from_file(anm_filename);
+        struct frameset* fset = asset_future_take(afut);
         t2 = clock();
         print_animation_info(anm_filename, fset);
-        printf("Load time %lu msec\n\n", 1000 * (t2 - t1) / CLOCKS_PER_SEC);
+        printf("Wait time %lu msec\n\n", 1000 * (t2 - t1) / CLOCKS_PER_SEC);
         /* Override possible existing animation */
         if (model->fset)
             frameset_delete(model->fset);
@@ -232,10 +242,12 @@ static void upload_model_geom_data(const char* filename, const char* anm_filenam
     }
 
     /* Free model data */
-    model_delete(m);
+    asset_future_release(mfut);
+    if (afut)
+        asset_future_release(afut);
 }
 
-static unsigned int upload_texture(const char* filename)
+static unsigned int upload_texture(struct asset_future* fut)
 {
     unsigned int id;
     glGenTextures(1, &id);
@@ -243,7 +255,7 @@ static unsigned int upload_texture(const char* filename)
     glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-    struct image* im = image_from_file(filename);
+    struct image* im = asset_future_wait(fut);
     if (im->compression_type == 0) {
         glTexImage2D(
             GL_TEXTURE_2D, 0,
@@ -260,7 +272,7 @@ static unsigned int upload_texture(const char* filename)
             im->height,
             0, im->data_sz, im->data);
     }
-    image_delete(im);
+    asset_future_release(fut);
     return id;
 }
 
@@ -414,17 +426,29 @@ static void setup_data(struct game_context* ctx)
     vector_init(&ctx->gobjects, sizeof(struct game_object));
     /* Add all scene objects */
     size_t num_scene_objects = sizeof(scene_objects) / sizeof(scene_objects[0]);
+    /* Queue every load up front so parsing runs in the background while we upload */
+    struct {
+        struct asset_future* model;
+        struct asset_future* anim;
+        struct asset_future* diff_texs[10];
+    }* futs = calloc(num_scene_objects, sizeof(*futs));
+    for (size_t i = 0; i < num_scene_objects; ++i) {
+        futs[i].model = asset_load_async(ASSET_MODEL, scene_objects[i].model_loc, 0, 0, 0);
+        if (scene_objects[i].anim_loc)
+            futs[i].anim = asset_load_async(ASSET_FRAMESET, scene_objects[i].anim_loc, 0, 0, 0);
+        for (int j = 0; j < 10 && scene_objects[i].diff_tex_locs[j]; ++j)
+            futs[i].diff_texs[j] = asset_load_async(ASSET_IMAGE, scene_objects[i].diff_tex_locs[j], 0, 0, 0);
+    }
     for (size_t i = 0; i < num_scene_objects; ++i) {
         struct game_object go;
-        /* Load, parse and upload model */
-        upload_model_geom_data(scene_objects[i].model_loc, scene_objects[i].anim_loc, &go.model);
-        /* Load, parse and upload each texture */
+        /* Upload model once parsed */
+        upload_model_geom_data(scene_objects[i].model_loc, futs[i].model, scene_objects[i].anim_loc, futs[i].anim, &go.model);
+        /* Upload each texture once parsed */
         vector_init(&go.diff_textures, sizeof(GLuint));
         for (int j = 0; j < 10; ++j) {
-            const char* diff_tex_loc = scene_objects[i].diff_tex_locs[j];
-            if (!diff_tex_loc)
+            if (!futs[i].diff_texs[j])
                 break;
-            GLuint tex_id = upload_texture(diff_tex_loc);
+            GLuint tex_id = upload_texture(futs[i].diff_texs[j]);
             vector_append(&go.diff_textures, &tex_id);
         }
         memcpy(go.mat_refs, scene_objects[i].diff_tex_refs, 16 * sizeof(size_t));
@@ -442,6 +466,7 @@ static void setup_data(struct game_context* ctx)
         );
         vector_append(&ctx->gobjects, &go);
     }
+    free(futs);
 }
 
 static void game_visualize_normals_setup(struct game_context* ctx)
@@ -498,10 +523,12 @@ void game_init(struct game_context* ctx)
     ctx->cur_obj = 1;
 
     /* Load data from files into the GPU */
+    asset_stats_enable(1);
     timepoint_t t1 = millisecs();
     setup_data(ctx);
     timepoint_t t2 = millisecs();
     printf("Total time: %lu:%lu\n", (t2 - t1) / 1000, (t2 - t1) % 1000);
+    print_load_stats();
 
     /* Load shaders */
     ctx->prog = load_shader_from_files(
@@ -858,6 +885,9 @@ void game_shutdown(struct game_context* ctx)
     /* Delete main shader */
     glDeleteProgram(ctx->prog);
 
+    /* Stop background loaders before the file system goes away */
+    asset_async_shutdown();
+
     /* Deinit abstract file system */
     afs_deinit();
 
@@ -46,5 +46,7 @@ int afs_exists(const char* fname);
 long afs_file_length(const char* fname);
 /* Reads buf_sz bytes from file into memory buffer. Buffer must have allocated the buf_sz bytes */
 int afs_read_file_to_mem(const char* fname, unsigned char* buf, size_t buf_sz);
+unsigned char* afs_read_file(const char* fname, size_t* sz);
+const char* afs_real_dir(const char* fname);
 
 #endif /* ! _ABSTRACTFS_H_ */
@@ -0,0 +1,79 @@
+/*********************************************************************************************************************/
+/*                                                  /===-_---~~~~~~~~~------____                                     */
+/*                                                 |===-~___                _,-'                                     */
+/*                  -==\\                         `//~\\   ~~~~`---.___.-~~                                          */
+/*              ______-==|                         | |  \\           _-~`                                            */
+/*        __--~~~  ,-/-==\\                        | |   `\        ,'                                                */
+/*     _-~       /'    |  \\                      / /      \      /                                                  */
+/*   .'        /       |   \\                   /' /        \   /'                                                   */
+/*  /  ____  /         |    \`\.__/-~~ ~ \ _ _/'  /          \/'                                                     */
+/* /-'~    ~~~~~---__  |     ~-/~         ( )   /'        _--~`                                                      */
+/*                   \_|      /        _)   ;  ),   __--~~                                                           */
+/*                     '~~--_/      _-~/-  / \   '-~ \                                                               */
+/*                    {\__--_/}    / \\_>- )<__\      \                                                              */
+/*                    /'   (_/  _-~  | |__>--<__|      |                                                             */
+/*                   |0  0 _/) )-~     | |__>--<__|     |                                                            */
+/*                   / /~ ,_/       / /__>---<__/      |                                                             */
+/*                  o o _//        /-~_>---<__-~      /                                                              */
+/*                  (^(~          /~_>---<__-      _-~                                                               */
+/*                 ,/|           /__>--<__/     _-~                                                                  */
+/*              ,//('(          |__>--<__|     /                  .----_                                             */
+/*             ( ( '))          |__>--<__|    |                 /' _---_~\                                           */
+/*          `-)) )) (           |__>--<__|    |               /'  /     ~\`\                                         */
+/*         ,/,'//( (             \__>--<__\    \            /'  //        ||                                         */
+/*       ,( ( ((, ))              ~-__>--<_~-_  ~--____---~' _/'/        /'                                          */
+/*     `~/  )` ) ,/|                 ~-_~>--<_/-__       __-~ _/                                                     */
+/*   ._-~//( )/ )) `                    ~~-'_/_/ /~~~~~~~__--~                                                       */
+/*    ;'( ')/ ,)(                              ~~~~~~~~~~                                                            */
+/*   ' ') '( (/                                                                                                      */
+/*     '   '  `                                                                                                      */
+/*********************************************************************************************************************/
+#ifndef _ALLOCATOR_H_
+#define _ALLOCATOR_H_
+
+#include <stddef.h>
+
+/* Memory interface used for every buffer a loader hands out
+ * (models, meshes, images, sounds and their contents) */
+struct asset_allocator {
+    void* (*alloc)(void* userdata, size_t sz);
+    void* (*realloc)(void* userdata, void* ptr, size_t sz);
+    void (*free)(void* userdata, void* ptr);
+    void* userdata;
+};
+
+/* Sets the process wide allocator, null restores malloc/realloc/free.
+ * Must not be changed while loads are running */
+void asset_set_allocator(const struct asset_allocator* a);
+/* Overrides the process wide allocator on the calling thread only and returns
+ * the previous override (null if none). Passing null clears the override */
+const struct asset_allocator* asset_set_thread_allocator(const struct asset_allocator* a);
+/* Allocator in effect on the calling thread */
+const struct asset_allocator* asset_current_allocator();
+
+/* Allocation through the allocator in effect. Assets must be
+ * deleted while the allocator that created them is in effect */
+void* asset_malloc(size_t sz);
+void* asset_calloc(size_t num, size_t sz);
+void* asset_realloc(void* ptr, size_t sz);
+void asset_free(void* ptr);
+char* asset_strdup(const char* s);
+
+/* Bump allocator handing out memory from large blocks. Freeing is a no-op
+ * (except for the most recent allocation) and everything is released at once
+ * with reset or destroy. Not thread safe, use one arena per concurrent load */
+struct asset_arena;
+/* Block size 0 selects a default */
+struct asset_arena* asset_arena_create(size_t block_sz);
+void* asset_arena_alloc(struct asset_arena* a, size_t sz);
+/* Grows in place when ptr is the most recent allocation, copies otherwise */
+void* asset_arena_realloc(struct asset_arena* a, void* ptr, size_t sz);
+/* Releases all allocations, keeping the first block for reuse */
+void asset_arena_reset(struct asset_arena* a);
+void asset_arena_destroy(struct asset_arena* a);
+/* Bytes handed out since creation or last reset */
+size_t asset_arena_used(struct asset_arena* a);
+/* Allocator interface backed by the arena */
+struct asset_allocator asset_arena_allocator(struct asset_arena* a);
+
+#endif /* ! _ALLOCATOR_H_ */
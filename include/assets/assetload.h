@@ -39,6 +39,10 @@ extern "C" {
 #include "sound/soundload.h"
 #include "model/modelload.h"
 #include "shader/shaderload.h"
+#include "asyncload.h"
+#include "batchload.h"
+#include "allocator.h"
+#include "stats.h"
 #include "error.h"
 
 #ifdef __cplusplus
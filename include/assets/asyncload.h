@@ -0,0 +1,106 @@
+/*********************************************************************************************************************/
+/*                                                  /===-_---~~~~~~~~~------____                                     */
+/*                                                 |===-~___                _,-'                                     */
+/*                  -==\\                         `//~\\   ~~~~`---.___.-~~                                          */
+/*              ______-==|                         | |  \\           _-~`                                            */
+/*        __--~~~  ,-/-==\\                        | |   `\        ,'                                                */
+/*     _-~       /'    |  \\                      / /      \      /                                                  */
+/*   .'        /       |   \\                   /' /        \   /'                                                   */
+/*  /  ____  /         |    \`\.__/-~~ ~ \ _ _/'  /          \/'                                                     */
+/* /-'~    ~~~~~---__  |     ~-/~         ( )   /'        _--~`                                                      */
+/*                   \_|      /        _)   ;  ),   __--~~                                                           */
+/*                     '~~--_/      _-~/-  / \   '-~ \                                                               */
+/*                    {\__--_/}    / \\_>- )<__\      \                                                              */
+/*                    /'   (_/  _-~  | |__>--<__|      |                                                             */
+/*                   |0  0 _/) )-~     | |__>--<__|     |                                                            */
+/*                   / /~ ,_/       / /__>---<__/      |                                                             */
+/*                  o o _//        /-~_>---<__-~      /                                                              */
+/*                  (^(~          /~_>---<__-      _-~                                                               */
+/*                 ,/|           /__>--<__/     _-~                                                                  */
+/*              ,//('(          |__>--<__|     /                  .----_                                             */
+/*             ( ( '))          |__>--<__|    |                 /' _---_~\                                           */
+/*          `-)) )) (           |__>--<__|    |               /'  /     ~\`\                                         */
+/*         ,/,'//( (             \__>--<__\    \            /'  //        ||                                         */
+/*       ,( ( ((, ))              ~-__>--<_~-_  ~--____---~' _/'/        /'                                          */
+/*     `~/  )` ) ,/|                 ~-_~>--<_/-__       __-~ _/                                                     */
+/*   ._-~//( )/ )) `                    ~~-'_/_/ /~~~~~~~__--~                                                       */
+/*    ;'( ')/ ,)(                              ~~~~~~~~~~                                                            */
+/*   ' ') '( (/                                                                                                      */
+/*     '   '  `                                                                                                      */
+/*********************************************************************************************************************/
+#ifndef _ASYNCLOAD_H_
+#define _ASYNCLOAD_H_
+
+#include <stddef.h>
+#include "shader/shaderload.h"
+#include "model/vertexdecl.h"
+#include "allocator.h"
+#include "error.h"
+
+/* Kinds of assets the generic entry points can produce */
+enum asset_type {
+    ASSET_IMAGE = 0,    /* struct image* */
+    ASSET_MODEL,        /* struct model* */
+    ASSET_FRAMESET,     /* struct frameset* */
+    ASSET_SOUND,        /* struct sound* */
+    ASSET_SHADER        /* const char* preprocessed source */
+};
+
+/* Optional parameters for a load request */
+struct asset_load_opts {
+    /* Format hint overriding the file extension, may be null */
+    const char* hint;
+    /* Settings used for ASSET_SHADER loads, may be null for plain file loads.
+     * Copied on submission, its callbacks may be invoked from worker threads */
+    struct shader_load_settings* shader_settings;
+    /* Allocator for the returned asset, null for the one in effect. Must stay
+     * valid until the asset is deleted. Shader sources always use malloc */
+    const struct asset_allocator* allocator;
+    /* Non zero to return models as a single block (see model_pack) */
+    int pack_models;
+    /* Non zero to return models in their compact form (see model_quantize) */
+    int quantize_models;
+    /* Layout of the vertices of returned models, may be null for struct vertex.
+     * Copied on submission, quantization does not apply to declared layouts */
+    const struct vertex_decl* vertex_decl;
+};
+
+/* Parses given asset type from memory, hint selects the format loader */
+void* asset_from_mem_buf(enum asset_type type, const unsigned char* data, size_t sz, const char* hint);
+/* Same as above, honoring the allocator and packing options. Opts may be null */
+void* asset_decode(enum asset_type type, const unsigned char* data, size_t sz, const char* hint, const struct asset_load_opts* opts);
+/* Loads given asset synchronously. Opts may be null */
+void* asset_load(enum asset_type type, const char* path, const struct asset_load_opts* opts);
+/* Frees an asset returned by the generic load functions */
+void asset_delete(enum asset_type type, void* asset);
+
+/* Completion callback, invoked on the worker thread that decoded the asset.
+ * Asset is null when loading failed. Ownership stays with the future */
+typedef void(*asset_load_cb)(void* userdata, enum asset_type type, void* asset);
+
+/* Opaque handle to an in flight load */
+struct asset_future;
+
+/* Starts the worker pool with given number of threads (0 for one per core).
+ * Calling it is optional, the first async load starts a default pool */
+void asset_async_init(unsigned int num_threads);
+/* Waits for all queued loads and stops the worker pool */
+void asset_async_shutdown();
+
+/* Queues an asset load on the worker pool. Opts and callback may be null */
+struct asset_future* asset_load_async(enum asset_type type, const char* path, const struct asset_load_opts* opts, asset_load_cb cb, void* userdata);
+/* Returns non zero when the load has finished, never blocks */
+int asset_future_ready(struct asset_future* f);
+/* Blocks until the load finishes and returns the asset (null on failure).
+ * Runs queued loads meanwhile, so completion callbacks may wait on other futures */
+void* asset_future_wait(struct asset_future* f);
+/* Blocks until the load finishes and returns its status,
+ * optionally with the error message that the loading thread reported */
+enum asset_load_status asset_future_status(struct asset_future* f, const char** err);
+/* Takes the asset out of a finished future, the caller becomes its owner */
+void* asset_future_take(struct asset_future* f);
+/* Releases the handle. Waits for the load if still running and
+ * frees the asset unless it was taken out with asset_future_take */
+void asset_future_release(struct asset_future* f);
+
+#endif /* ! _ASYNCLOAD_H_ */
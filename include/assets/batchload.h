@@ -0,0 +1,82 @@
+/*********************************************************************************************************************/
+/*                                                  /===-_---~~~~~~~~~------____                                     */
+/*                                                 |===-~___                _,-'                                     */
+/*                  -==\\                         `//~\\   ~~~~`---.___.-~~                                          */
+/*              ______-==|                         | |  \\           _-~`                                            */
+/*        __--~~~  ,-/-==\\                        | |   `\        ,'                                                */
+/*     _-~       /'    |  \\                      / /      \      /                                                  */
+/*   .'        /       |   \\                   /' /        \   /'                                                   */
+/*  /  ____  /         |    \`\.__/-~~ ~ \ _ _/'  /          \/'                                                     */
+/* /-'~    ~~~~~---__  |     ~-/~         ( )   /'        _--~`                                                      */
+/*                   \_|      /        _)   ;  ),   __--~~                                                           */
+/*                     '~~--_/      _-~/-  / \   '-~ \                                                               */
+/*                    {\__--_/}    / \\_>- )<__\      \                                                              */
+/*                    /'   (_/  _-~  | |__>--<__|      |                                                             */
+/*                   |0  0 _/) )-~     | |__>--<__|     |                                                            */
+/*                   / /~ ,_/       / /__>---<__/      |                                                             */
+/*                  o o _//        /-~_>---<__-~      /                                                              */
+/*                  (^(~          /~_>---<__-      _-~                                                               */
+/*                 ,/|           /__>--<__/     _-~                                                                  */
+/*              ,//('(          |__>--<__|     /                  .----_                                             */
+/*             ( ( '))          |__>--<__|    |                 /' _---_~\                                           */
+/*          `-)) )) (           |__>--<__|    |               /'  /     ~\`\                                         */
+/*         ,/,'//( (             \__>--<__\    \            /'  //        ||                                         */
+/*       ,( ( ((, ))              ~-__>--<_~-_  ~--____---~' _/'/        /'                                          */
+/*     `~/  )` ) ,/|                 ~-_~>--<_/-__       __-~ _/                                                     */
+/*   ._-~//( )/ )) `                    ~~-'_/_/ /~~~~~~~__--~                                                       */
+/*    ;'( ')/ ,)(                              ~~~~~~~~~~                                                            */
+/*   ' ') '( (/                                                                                                      */
+/*     '   '  `                                                                                                      */
+/*********************************************************************************************************************/
+#ifndef _BATCHLOAD_H_
+#define _BATCHLOAD_H_
+
+#include <stddef.h>
+#include "asyncload.h"
+
+/* Per item outcome of a batch load */
+enum asset_batch_status {
+    ASSET_BATCH_PENDING = 0,
+    ASSET_BATCH_OK,
+    ASSET_BATCH_IO_ERROR,     /* File missing or unreadable */
+    ASSET_BATCH_DECODE_ERROR  /* File read but no loader accepted its contents */
+};
+
+/* Single entry of a batch, filled in by the caller, completed by the loader */
+struct asset_batch_item {
+    /* Input */
+    enum asset_type type;
+    const char* path;
+    const char* hint; /* Optional format hint, overrides the extension */
+    /* Output */
+    void* asset;      /* Owned by the caller after the batch returns */
+    enum asset_batch_status status;
+    char error[128];  /* Loader's error message when status is not ok */
+};
+
+/* Batch wide parameters */
+struct asset_batch_opts {
+    /* Upper bound of file bytes read but not yet decoded, 0 for default */
+    size_t max_inflight_bytes;
+    /* Settings used for ASSET_SHADER items, may be null */
+    struct shader_load_settings* shader_settings;
+    /* Allocator for the decoded assets, null for the one in effect.
+     * Called from several worker threads at once, so it must be thread safe */
+    const struct asset_allocator* allocator;
+    /* Non zero to return models as a single block (see model_pack) */
+    int pack_models;
+    /* Non zero to return models in their compact form (see model_quantize) */
+    int quantize_models;
+    /* Layout of the vertices of returned models, may be null (see asset_load_opts) */
+    const struct vertex_decl* vertex_decl;
+};
+
+/* Loads all items, reading files in storage order on the calling thread
+ * while decoding them on the worker pool. Opts may be null.
+ * Returns the number of items loaded successfully */
+size_t asset_batch_load(struct asset_batch_item* items, size_t num_items, const struct asset_batch_opts* opts);
+/* Frees the assets of all loaded items, the allocator
+ * they were loaded with must be in effect */
+void asset_batch_free(struct asset_batch_item* items, size_t num_items);
+
+#endif /* ! _BATCHLOAD_H_ */
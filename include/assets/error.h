@@ -31,9 +31,22 @@
 #ifndef _ASSET_LOAD_ERROR_
 #define _ASSET_LOAD_ERROR_
 
-/* Retrieves and sets the last asset load error string
- * from a statically allocated buffer */
+/* Outcome of the last load operation */
+enum asset_load_status {
+    ASSET_LOAD_OK = 0,
+    ASSET_LOAD_IO_ERROR,       /* File missing or unreadable */
+    ASSET_LOAD_UNKNOWN_FORMAT, /* No loader for the given hint */
+    ASSET_LOAD_INVALID_DATA    /* Loader rejected the contents */
+};
+
+/* Retrieves and sets the last asset load error string and status.
+ * Both are kept per thread, so loads running concurrently on
+ * different threads never see each other's errors */
 const char* get_last_asset_load_error();
 void set_last_asset_load_error(const char*);
+enum asset_load_status get_last_asset_load_status();
+void set_last_asset_load_status(enum asset_load_status st, const char* err);
+/* Resets calling thread's status to ASSET_LOAD_OK, done by every public load entry point */
+void clear_last_asset_load_error();
 
 #endif // ! _ASSET_LOAD_ERROR_
@@ -37,4 +37,27 @@ long filesize(const char* filepath);
 /* Reads file to preallocated buffer */
 int read_file_to_mem(const char* filename, unsigned char* buf, size_t buf_sz);
 
+/* Identifies where a native file lives (device and file id), used to
+ * order batches of reads by storage locality. Returns 0 on error */
+int file_storage_key(const char* fpath, unsigned long long* dev, unsigned long long* id);
+
+/* Access pattern hint passed to the OS for mapped files */
+enum file_access_hint {
+    FILE_ACCESS_SEQUENTIAL = 0,
+    FILE_ACCESS_RANDOM
+};
+
+/* Read only view of a whole file's contents.
+ * Backed by a memory mapping when the file lives on the native filesystem,
+ * or by a heap copy when it is served through the abstract filesystem */
+struct file_blob {
+    const unsigned char* data;
+    size_t size;
+    int mapped;
+};
+/* Opens the file once and exposes its contents. Returns 0 on error */
+int file_blob_open(struct file_blob* fb, const char* fpath, enum file_access_hint hint);
+/* Releases the view, unmapping or freeing its contents */
+void file_blob_close(struct file_blob* fb);
+
 #endif // ! _FILELOAD_H_
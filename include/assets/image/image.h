@@ -42,6 +42,26 @@ struct image {
     size_t data_sz;
 };
 
+/* Image file formats */
+enum image_format {
+    IMAGE_FORMAT_UNKNOWN = 0,
+    IMAGE_FORMAT_PNG,
+    IMAGE_FORMAT_JPEG,
+    IMAGE_FORMAT_TGA,
+    IMAGE_FORMAT_TIFF,
+    IMAGE_FORMAT_KTX
+};
+
+/* Image description read from the file header, values
+ * match the struct image that a full load would produce */
+struct image_info {
+    enum image_format format;
+    int width;
+    int height;
+    int channels;
+    int compression_type;
+};
+
 struct image* image_blank(int width, int height, int channels);
 void image_delete(struct image* i);
 
@@ -36,6 +36,11 @@
 /* Public API functions */
 struct image* image_from_mem_buf(const unsigned char* data, size_t sz, const char* hint);
 struct image* image_from_file(const char* fpath);
+/* Reads only the header of the image, returns non zero on success */
+int image_info_from_mem_buf(const unsigned char* data, size_t sz, const char* hint, struct image_info* info);
+int image_info_from_file(const char* fpath, struct image_info* info);
+/* Detects the format by its magic bytes, falling back to the hint for formats without one */
+enum image_format image_format_detect(const unsigned char* data, size_t sz, const char* hint);
 
 /* Internal loaders */
 struct image* image_from_jpeg(const unsigned char* data, size_t sz);
@@ -43,5 +48,10 @@ struct image* image_from_png(const unsigned char* data, size_t sz);
 struct image* image_from_tga(const unsigned char* data, size_t sz);
 struct image* image_from_tiff(const unsigned char* data, size_t sz);
 struct image* image_from_ktx(const unsigned char* data, size_t sz);
+int image_info_from_jpeg(const unsigned char* data, size_t sz, struct image_info* info);
+int image_info_from_png(const unsigned char* data, size_t sz, struct image_info* info);
+int image_info_from_tga(const unsigned char* data, size_t sz, struct image_info* info);
+int image_info_from_tiff(const unsigned char* data, size_t sz, struct image_info* info);
+int image_info_from_ktx(const unsigned char* data, size_t sz, struct image_info* info);
 
 #endif /* ! _IMAGELOAD_H_ */
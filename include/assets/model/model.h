@@ -33,6 +33,7 @@
 
 #include <stddef.h>
 #include <stdint.h>
+#include "vertexdecl.h"
 
 /* Frame */
 struct frame {
@@ -46,6 +47,30 @@ struct frame {
     size_t num_joints;
 };
 
+/* Quantized mesh data (see model_quantize) */
+struct mesh_quant {
+    /* 24 byte vertices */
+    struct qvertex {
+        uint16_t position[4]; /* Unorm over the mesh bounds, w is 1 when the
+                                 binormal is opposite to cross(normal, tangent) */
+        int16_t normal[2];    /* Octahedral snorm */
+        int16_t tangent[2];   /* Octahedral snorm */
+        uint16_t uvs[2];      /* Unorm over the mesh uv bounds */
+        uint8_t color[4];     /* Unorm */
+    }* vertices;
+    /* 8 byte weights, null when the mesh has none or bone ids do not fit 8 bits */
+    struct qvertex_weight {
+        uint8_t bone_ids[4];
+        uint8_t bone_weights[4]; /* Unorm, summing to 255 */
+    }* weights;
+    /* 16 bit indices of the mesh and its lods, null when some index does not fit */
+    uint16_t* indices;
+    uint16_t** lod_indices;
+    /* Dequantization, value = offset + q / 65535 * scale */
+    float pos_offset[3], pos_scale[3];
+    float uv_offset[2], uv_scale[2];
+};
+
 /* Model */
 struct model {
     /* Meshes */
@@ -64,9 +89,23 @@ struct model {
             float bone_weights[4];
         }* weights;
         size_t num_verts;
+        /* Vertex streams in a caller declared layout (see vertex_decl),
+         * vertices and weights are null when these are set */
+        struct vertex_stream {
+            void* data;
+            uint32_t stride;
+        } streams[VERTEX_MAX_STREAMS];
         /* Indices */
         uint32_t* indices;
         size_t num_indices;
+        /* Reduced index buffers over the same vertices, finest first */
+        struct mesh_lod {
+            uint32_t* indices;
+            size_t num_indices;
+        }* lods;
+        size_t num_lods;
+        /* Quantized form, replaces the data above that it holds */
+        struct mesh_quant* quant;
         /* Material index */
         size_t mat_index; /* Relative to the parent mesh group */
         /* Mesh group */
@@ -93,13 +132,46 @@ struct model {
         const char* name;
     }** mesh_groups;
     size_t num_mesh_groups;
+
+    /* Set when the model and all of its data live in a single block (see model_pack) */
+    size_t packed_size;
+    const void* packed_base; /* Address the block was laid out at */
+};
+
+/* Model file formats */
+enum model_format {
+    MODEL_FORMAT_UNKNOWN = 0,
+    MODEL_FORMAT_OBJ,
+    MODEL_FORMAT_FBX,
+    MODEL_FORMAT_PLY,
+    MODEL_FORMAT_IQM,
+    MODEL_FORMAT_MDL
+};
+
+/* Model description read from the file header. Counts the
+ * format does not store up front (obj, fbx) are left zero */
+struct model_info {
+    enum model_format format;
+    size_t num_meshes;
+    size_t num_verts;   /* Total over all meshes */
+    size_t num_indices; /* Total over all meshes */
+    size_t num_joints;
+    size_t num_frames;
 };
 
 struct model* model_new();
 void model_delete(struct model*);
+/* Copies the model and everything it references into one allocation
+ * of packed_size bytes, released as a whole by model_delete */
+struct model* model_pack(const struct model* m);
+/* Rebases the internal pointers of a packed model that was moved to
+ * another address as a whole (memcpy, read back from a cache file) */
+void model_relocate(struct model* m);
 
 struct mesh* mesh_new();
 void mesh_delete(struct mesh*);
+/* Trims the vertex, weight and index buffers to their used counts */
+void mesh_shrink_to_fit(struct mesh*);
 
 struct mesh_group* mesh_group_new();
 void mesh_group_delete(struct mesh_group*);
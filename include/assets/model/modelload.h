@@ -34,19 +34,72 @@
 #include "model.h"
 #include <stddef.h>
 
+/* Counts of a mesh, for sizing the buffers it is decoded into */
+struct mesh_extent {
+    size_t num_verts;
+    size_t num_indices;
+};
+
+/* Caller memory a mesh is decoded into, null streams are skipped */
+struct mesh_dest {
+    void* streams[VERTEX_MAX_STREAMS]; /* Declared stride times max_verts bytes each */
+    uint32_t* indices;
+    size_t max_verts;
+    size_t max_indices;
+};
+
 /* Public API functions */
 struct model* model_from_mem_buf(const unsigned char* data, size_t sz, const char* hint);
 struct model* model_from_file(const char* fpath);
+/* Same as above, with vertices written into mesh->streams as declared.
+ * Formats that support it skip reading the attributes left out */
+struct model* model_from_mem_buf_decl(const unsigned char* data, size_t sz, const char* hint, const struct vertex_decl* decl);
+struct model* model_from_file_decl(const char* fpath, const struct vertex_decl* decl);
+/* Two phase decoding into caller memory (mapped staging buffers, reserved arenas).
+ * First gets the counts of up to max_meshes meshes, returning the number of meshes
+ * or 0 on failure. Formats without per mesh counts in their header (obj, fbx)
+ * are parsed in full for them, ply only has its face lists walked */
+size_t model_extents_from_mem_buf(const unsigned char* data, size_t sz, const char* hint, struct mesh_extent* extents, size_t max_meshes);
+/* Then decodes the vertices as declared and the indices of mesh i into dests[i].
+ * The returned model holds everything else, its vertex and index pointers are null.
+ * Fails when there are fewer destinations than meshes or one is too small */
+struct model* model_decode_into(const unsigned char* data, size_t sz, const char* hint, const struct vertex_decl* decl, const struct mesh_dest* dests, size_t num_dests);
+/* Reads only the header of the model, returns non zero on success */
+int model_info_from_mem_buf(const unsigned char* data, size_t sz, const char* hint, struct model_info* info);
+int model_info_from_file(const char* fpath, struct model_info* info);
+/* Detects the format by its magic bytes, falling back to the hint for formats without one */
+enum model_format model_format_detect(const unsigned char* data, size_t sz, const char* hint);
 struct frameset* frameset_from_mem_buf(const unsigned char* data, size_t sz, const char* hint);
 struct frameset* frameset_from_file(const char* fpath);
 
 /* Internal loaders */
 struct model* model_from_obj(const unsigned char* data, size_t sz);
 struct model* model_from_fbx(const unsigned char* data, size_t sz);
-struct model* model_from_ply(const unsigned char* data, size_t sz);
-struct model* model_from_iqm(const unsigned char* data, size_t sz);
-struct model* model_from_mdl(const unsigned char* data, size_t sz);
+/* Where loaders write mesh data, struct vertex arrays when there is no declaration */
+struct model_output {
+    const struct vertex_decl* decl;
+    const struct mesh_dest* dests; /* May be null */
+    size_t num_dests;
+};
+/* Sets up the declared streams of mesh i, in its destination when it fits */
+void model_output_streams(const struct model_output* out, size_t mesh_idx, struct mesh* m);
+/* Same for m->num_indices indices */
+void model_output_indices(const struct model_output* out, size_t mesh_idx, struct mesh* m);
+/* Zeroes the declared attributes a loader did not write, given as a mask of (1 << attrib) */
+void model_output_clear_missing(const struct model_output* out, struct mesh* m, unsigned int written);
+/* Loaders taking an output may return meshes still in struct vertex form,
+ * the declaration is applied to those afterwards */
+struct model* model_from_ply(const unsigned char* data, size_t sz, const struct model_output* out);
+struct model* model_from_iqm(const unsigned char* data, size_t sz, const struct model_output* out);
+struct model* model_from_mdl(const unsigned char* data, size_t sz, const struct model_output* out);
 struct frameset* frameset_from_fbx(const unsigned char* data, size_t sz);
 struct frameset* frameset_from_anm(const unsigned char* data, size_t sz);
+int model_info_from_fbx(const unsigned char* data, size_t sz, struct model_info* info);
+int model_info_from_ply(const unsigned char* data, size_t sz, struct model_info* info);
+int model_info_from_iqm(const unsigned char* data, size_t sz, struct model_info* info);
+int model_info_from_mdl(const unsigned char* data, size_t sz, struct model_info* info);
+size_t model_extents_from_ply(const unsigned char* data, size_t sz, struct mesh_extent* extents, size_t max_meshes);
+size_t model_extents_from_iqm(const unsigned char* data, size_t sz, struct mesh_extent* extents, size_t max_meshes);
+size_t model_extents_from_mdl(const unsigned char* data, size_t sz, struct mesh_extent* extents, size_t max_meshes);
 
 #endif /* ! _MODELLOAD_H_ */
@@ -37,10 +37,30 @@ void mesh_generate_normals(struct mesh* m);
 void mesh_generate_tangents(struct mesh* m);
 void mesh_generate_orthagonal_tangents(struct mesh* m);
 void mesh_generate_texcoords_cylinder(struct mesh* m);
+/* Reorders triangles for post transform vertex cache reuse,
+ * dropping triangles that repeat a vertex */
+void mesh_optimize_vertex_cache(struct mesh* m);
+/* Reorders vertices in order of first use by the index buffer,
+ * dropping vertices no triangle refers to */
+void mesh_optimize_vertex_fetch(struct mesh* m);
+/* Builds reduced index buffers over the mesh vertices, one per ratio of
+ * the triangle count, replacing any existing levels. Borders, attribute
+ * seams and dominant bones are preserved, so levels may keep more
+ * triangles than asked for */
+void mesh_generate_lods(struct mesh* m, const float* ratios, size_t num_ratios);
+/* Converts the mesh to its compact form in mesh->quant, freeing the full
+ * precision vertices, weights and indices it replaces. Meant as the last
+ * step, postprocessing needs the full precision data */
+void mesh_quantize(struct mesh* m);
 
 void model_generate_normals(struct model* m);
 void model_generate_tangents(struct model* m);
 void model_generate_orthagonal_tangents(struct model* m);
 void model_generate_texcoords_cylinder(struct model* m);
+void model_optimize_vertex_cache(struct model* m);
+void model_optimize_vertex_fetch(struct model* m);
+/* Levels of all meshes are simplified in parallel on the thread pool */
+void model_generate_lods(struct model* m, const float* ratios, size_t num_ratios);
+void model_quantize(struct model* m);
 
 #endif /* ! _POSTPROCESS_H_ */
@@ -0,0 +1,108 @@
+/*********************************************************************************************************************/
+/*                                                  /===-_---~~~~~~~~~------____                                     */
+/*                                                 |===-~___                _,-'                                     */
+/*                  -==\\                         `//~\\   ~~~~`---.___.-~~                                          */
+/*              ______-==|                         | |  \\           _-~`                                            */
+/*        __--~~~  ,-/-==\\                        | |   `\        ,'                                                */
+/*     _-~       /'    |  \\                      / /      \      /                                                  */
+/*   .'        /       |   \\                   /' /        \   /'                                                   */
+/*  /  ____  /         |    \`\.__/-~~ ~ \ _ _/'  /          \/'                                                     */
+/* /-'~    ~~~~~---__  |     ~-/~         ( )   /'        _--~`                                                      */
+/*                   \_|      /        _)   ;  ),   __--~~                                                           */
+/*                     '~~--_/      _-~/-  / \   '-~ \                                                               */
+/*                    {\__--_/}    / \\_>- )<__\      \                                                              */
+/*                    /'   (_/  _-~  | |__>--<__|      |                                                             */
+/*                   |0  0 _/) )-~     | |__>--<__|     |                                                            */
+/*                   / /~ ,_/       / /__>---<__/      |                                                             */
+/*                  o o _//        /-~_>---<__-~      /                                                              */
+/*                  (^(~          /~_>---<__-      _-~                                                               */
+/*                 ,/|           /__>--<__/     _-~                                                                  */
+/*              ,//('(          |__>--<__|     /                  .----_                                             */
+/*             ( ( '))          |__>--<__|    |                 /' _---_~\                                           */
+/*          `-)) )) (           |__>--<__|    |               /'  /     ~\`\                                         */
+/*         ,/,'//( (             \__>--<__\    \            /'  //        ||                                         */
+/*       ,( ( ((, ))              ~-__>--<_~-_  ~--____---~' _/'/        /'                                          */
+/*     `~/  )` ) ,/|                 ~-_~>--<_/-__       __-~ _/                                                     */
+/*   ._-~//( )/ )) `                    ~~-'_/_/ /~~~~~~~__--~                                                       */
+/*    ;'( ')/ ,)(                              ~~~~~~~~~~                                                            */
+/*   ' ') '( (/                                                                                                      */
+/*     '   '  `                                                                                                      */
+/*********************************************************************************************************************/
+#ifndef _VERTEXDECL_H_
+#define _VERTEXDECL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define VERTEX_MAX_STREAMS 4
+
+/* Vertex attributes, with their fixed component counts */
+enum vertex_attrib {
+    VERTEX_POSITION = 0, /* 3 */
+    VERTEX_NORMAL,       /* 3 */
+    VERTEX_TANGENT,      /* 3 */
+    VERTEX_BINORMAL,     /* 3 */
+    VERTEX_COLOR,        /* 4 */
+    VERTEX_UV,           /* 2 */
+    VERTEX_BONE_IDS,     /* 4 */
+    VERTEX_BONE_WEIGHTS, /* 4 */
+    VERTEX_ATTRIB_COUNT
+};
+
+/* Component formats */
+enum vertex_format {
+    VERTEX_FMT_F32 = 0,
+    VERTEX_FMT_F16,
+    VERTEX_FMT_UNORM16,
+    VERTEX_FMT_SNORM16,
+    VERTEX_FMT_UNORM8,
+    VERTEX_FMT_SNORM8,
+    VERTEX_FMT_U32,
+    VERTEX_FMT_U16,
+    VERTEX_FMT_U8,
+    VERTEX_FORMAT_COUNT
+};
+
+/* Placement of an attribute inside its stream */
+struct vertex_element {
+    enum vertex_attrib attrib;
+    enum vertex_format format;
+    uint32_t stream;
+    uint32_t offset;
+};
+
+/* Vertex declaration, attributes placed in the same stream are
+ * interleaved, ones given streams of their own are separate arrays */
+struct vertex_decl {
+    struct vertex_element elems[VERTEX_ATTRIB_COUNT];
+    uint32_t num_elems;
+    uint32_t strides[VERTEX_MAX_STREAMS];
+    uint32_t num_streams;
+};
+
+struct mesh;
+struct model;
+
+void vertex_decl_init(struct vertex_decl* d);
+/* Appends the attribute at the end of the given stream, 4 byte aligned.
+ * Returns non zero on success, zero for repeated attributes, bad formats or bad streams */
+int vertex_decl_add(struct vertex_decl* d, enum vertex_attrib attrib, enum vertex_format fmt, uint32_t stream);
+/* Element of the attribute, null when the declaration leaves it out */
+const struct vertex_element* vertex_decl_find(const struct vertex_decl* d, enum vertex_attrib attrib);
+size_t vertex_format_size(enum vertex_format fmt);
+unsigned int vertex_attrib_num_comps(enum vertex_attrib attrib);
+/* Converts and stores the components of an attribute at dst */
+void vertex_element_write(const struct vertex_element* e, void* dst, const float* v);
+void vertex_element_write_uint(const struct vertex_element* e, void* dst, const uint32_t* v);
+
+/* Writes the vertices and weights of the mesh as declared into the given streams,
+ * num_verts times the declared stride bytes each. Null streams are skipped */
+void mesh_write_vertex_streams(const struct mesh* m, const struct vertex_decl* d, void* const* streams);
+/* Allocates zeroed mesh->streams for mesh->num_verts vertices as declared */
+void mesh_alloc_vertex_streams(struct mesh* m, const struct vertex_decl* d);
+/* Moves the vertices and weights of the mesh into mesh->streams laid out
+ * as declared, dropping attributes the declaration leaves out */
+void mesh_apply_vertex_decl(struct mesh* m, const struct vertex_decl* d);
+void model_apply_vertex_decl(struct model* m, const struct vertex_decl* d);
+
+#endif /* ! _VERTEXDECL_H_ */
@@ -41,6 +41,25 @@ struct sound {
     unsigned char* data;
 };
 
+/* Sound file formats */
+enum sound_format {
+    SOUND_FORMAT_UNKNOWN = 0,
+    SOUND_FORMAT_WAV,
+    SOUND_FORMAT_OGG
+};
+
+/* Sound description read from the file headers, values
+ * match the struct sound that a full load would produce */
+struct sound_info {
+    enum sound_format format;
+    short channels;
+    short bits_per_sample;
+    int samplerate;
+    size_t num_samples; /* Per channel */
+    size_t data_sz;     /* Decoded pcm size */
+    float duration;     /* In seconds */
+};
+
 void sound_delete(struct sound*);
 
 #endif // ! _SOUND_H_
@@ -35,8 +35,15 @@
 
 struct sound* sound_from_mem_buf(const unsigned char* data, size_t sz, const char* hint);
 struct sound* sound_from_file(const char* fpath);
+/* Reads only the headers of the sound, returns non zero on success */
+int sound_info_from_mem_buf(const unsigned char* data, size_t sz, const char* hint, struct sound_info* info);
+int sound_info_from_file(const char* fpath, struct sound_info* info);
+/* Detects the format by its magic bytes, falling back to the hint */
+enum sound_format sound_format_detect(const unsigned char* data, size_t sz, const char* hint);
 
 struct sound* sound_from_ogg(const unsigned char* data, size_t sz);
 struct sound* sound_from_wav(const unsigned char* data, size_t sz);
+int sound_info_from_ogg(const unsigned char* data, size_t sz, struct sound_info* info);
+int sound_info_from_wav(const unsigned char* data, size_t sz, struct sound_info* info);
 
 #endif // ! _SOUNDLOAD_H_
@@ -0,0 +1,74 @@
+/*********************************************************************************************************************/
+/*                                                  /===-_---~~~~~~~~~------____                                     */
+/*                                                 |===-~___                _,-'                                     */
+/*                  -==\\                         `//~\\   ~~~~`---.___.-~~                                          */
+/*              ______-==|                         | |  \\           _-~`                                            */
+/*        __--~~~  ,-/-==\\                        | |   `\        ,'                                                */
+/*     _-~       /'    |  \\                      / /      \      /                                                  */
+/*   .'        /       |   \\                   /' /        \   /'                                                   */
+/*  /  ____  /         |    \`\.__/-~~ ~ \ _ _/'  /          \/'                                                     */
+/* /-'~    ~~~~~---__  |     ~-/~         ( )   /'        _--~`                                                      */
+/*                   \_|      /        _)   ;  ),   __--~~                                                           */
+/*                     '~~--_/      _-~/-  / \   '-~ \                                                               */
+/*                    {\__--_/}    / \\_>- )<__\      \                                                              */
+/*                    /'   (_/  _-~  | |__>--<__|      |                                                             */
+/*                   |0  0 _/) )-~     | |__>--<__|     |                                                            */
+/*                   / /~ ,_/       / /__>---<__/      |                                                             */
+/*                  o o _//        /-~_>---<__-~      /                                                              */
+/*                  (^(~          /~_>---<__-      _-~                                                               */
+/*                 ,/|           /__>--<__/     _-~                                                                  */
+/*              ,//('(          |__>--<__|     /                  .----_                                             */
+/*             ( ( '))          |__>--<__|    |                 /' _---_~\                                           */
+/*          `-)) )) (           |__>--<__|    |               /'  /     ~\`\                                         */
+/*         ,/,'//( (             \__>--<__\    \            /'  //        ||                                         */
+/*       ,( ( ((, ))              ~-__>--<_~-_  ~--____---~' _/'/        /'                                          */
+/*     `~/  )` ) ,/|                 ~-_~>--<_/-__       __-~ _/                                                     */
+/*   ._-~//( )/ )) `                    ~~-'_/_/ /~~~~~~~__--~                                                       */
+/*    ;'( ')/ ,)(                              ~~~~~~~~~~                                                            */
+/*   ' ') '( (/                                                                                                      */
+/*     '   '  `                                                                                                      */
+/*********************************************************************************************************************/
+#ifndef _ASSET_STATS_H_
+#define _ASSET_STATS_H_
+
+#include <stdint.h>
+
+/* Load phases timed by the built-in instrumentation. Phases nest
+ * (e.g. decompress runs inside parse), times are exclusive of nested ones */
+enum asset_phase {
+    ASSET_PHASE_READ = 0,    /* Opening and mapping or reading files */
+    ASSET_PHASE_DECOMPRESS,  /* Inflating compressed payloads (fbx arrays) */
+    ASSET_PHASE_PARSE,       /* Format decoding */
+    ASSET_PHASE_WELD,        /* Building and deduplicating mesh vertices */
+    ASSET_PHASE_POSTPROCESS, /* Normal and tangent generation, mesh optimization */
+    ASSET_PHASE_FREE,        /* Deleting assets */
+    ASSET_PHASE_COUNT
+};
+
+/* Counters summed over all threads */
+struct asset_stats {
+    uint64_t phase_ns[ASSET_PHASE_COUNT];
+    uint64_t phase_calls[ASSET_PHASE_COUNT];
+    uint64_t assets_loaded;
+    uint64_t bytes_read;
+    uint64_t bytes_allocated; /* Requested through the asset allocator */
+    uint64_t num_allocs;      /* Reallocations included */
+    uint64_t num_frees;
+};
+
+/* Instrumentation is off by default, when off each hook costs a single branch */
+void asset_stats_enable(int enable);
+int asset_stats_enabled();
+void asset_stats_get(struct asset_stats* st);
+void asset_stats_reset();
+const char* asset_phase_name(enum asset_phase ph);
+
+/* Records every timed phase as an event (enables stats too),
+ * start discards events recorded by a previous session */
+void asset_trace_start();
+void asset_trace_stop();
+/* Writes recorded events in Chrome trace event format (chrome://tracing,
+ * Perfetto). Returns non zero on success */
+int asset_trace_write(const char* fpath);
+
+#endif /* ! _ASSET_STATS_H_ */
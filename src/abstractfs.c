@@ -47,3 +47,29 @@ int afs_read_file_to_mem(const char* fname, unsigned char* buf, size_t buf_sz)
     PHYSFS_close(fp);
     return 1;
 }
+
+unsigned char* afs_read_file(const char* fname, size_t* sz)
+{
+    PHYSFS_File* fp = PHYSFS_openRead(fname);
+    if (!fp)
+        return 0;
+    PHYSFS_sint64 flen = PHYSFS_fileLength(fp);
+    if (flen < 0) {
+        PHYSFS_close(fp);
+        return 0;
+    }
+    unsigned char* buf = malloc(flen ? flen : 1);
+    PHYSFS_sint64 rd = PHYSFS_read(fp, buf, 1, flen);
+    PHYSFS_close(fp);
+    if (rd != flen) {
+        free(buf);
+        return 0;
+    }
+    *sz = flen;
+    return buf;
+}
+
+const char* afs_real_dir(const char* fname)
+{
+    return PHYSFS_getRealDir(fname);
+}
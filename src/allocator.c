@@ -0,0 +1,359 @@
+/*********************************************************************************************************************/
+/*                                                  /===-_---~~~~~~~~~------____                                     */
+/*                                                 |===-~___                _,-'                                     */
+/*                  -==\\                         `//~\\   ~~~~`---.___.-~~                                          */
+/*              ______-==|                         | |  \\           _-~`                                            */
+/*        __--~~~  ,-/-==\\                        | |   `\        ,'                                                */
+/*     _-~       /'    |  \\                      / /      \      /                                                  */
+/*   .'        /       |   \\                   /' /        \   /'                                                   */
+/*  /  ____  /         |    \`\.__/-~~ ~ \ _ _/'  /          \/'                                                     */
+/* /-'~    ~~~~~---__  |     ~-/~         ( )   /'        _--~`                                                      */
+/*                   \_|      /        _)   ;  ),   __--~~                                                           */
+/*                     '~~--_/      _-~/-  / \   '-~ \                                                               */
+/*                    {\__--_/}    / \\_>- )<__\      \                                                              */
+/*                    /'   (_/  _-~  | |__>--<__|      |                                                             */
+/*                   |0  0 _/) )-~     | |__>--<__|     |                                                            */
+/*                   / /~ ,_/       / /__>---<__/      |                                                             */
+/*                  o o _//        /-~_>---<__-~      /                                                              */
+/*                  (^(~          /~_>---<__-      _-~                                                               */
+/*                 ,/|           /__>--<__/     _-~                                                                  */
+/*              ,//('(          |__>--<__|     /                  .----_                                             */
+/*             ( ( '))          |__>--<__|    |                 /' _---_~\                                           */
+/*          `-)) )) (           |__>--<__|    |               /'  /     ~\`\                                         */
+/*         ,/,'//( (             \__>--<__\    \            /'  //        ||                                         */
+/*       ,( ( ((, ))              ~-__>--<_~-_  ~--____---~' _/'/        /'                                          */
+/*     `~/  )` ) ,/|                 ~-_~>--<_/-__       __-~ _/                                                     */
+/*   ._-~//( )/ )) `                    ~~-'_/_/ /~~~~~~~__--~                                                       */
+/*    ;'( ')/ ,)(                              ~~~~~~~~~~                                                            */
+/*   ' ') '( (/                                                                                                      */
+/*     '   '  `                                                                                                      */
+/*********************************************************************************************************************/
+#include "assets/allocator.h"
+#include <stdlib.h>
+#include <string.h>
+#include "thread.h"
+#include "stats.h"
+
+/*-----------------------------------------------------------------
+ * Allocator selection
+ *-----------------------------------------------------------------*/
+static void* default_alloc(void* userdata, size_t sz)
+{
+    (void) userdata;
+    return malloc(sz);
+}
+
+static void* default_realloc(void* userdata, void* ptr, size_t sz)
+{
+    (void) userdata;
+    return realloc(ptr, sz);
+}
+
+static void default_free(void* userdata, void* ptr)
+{
+    (void) userdata;
+    free(ptr);
+}
+
+static struct asset_allocator global_allocator = {
+    default_alloc,
+    default_realloc,
+    default_free,
+    0
+};
+
+static thread_local_var const struct asset_allocator* thread_allocator;
+
+void asset_set_allocator(const struct asset_allocator* a)
+{
+    if (a) {
+        global_allocator = *a;
+    } else {
+        global_allocator.alloc = default_alloc;
+        global_allocator.realloc = default_realloc;
+        global_allocator.free = default_free;
+        global_allocator.userdata = 0;
+    }
+}
+
+const struct asset_allocator* asset_set_thread_allocator(const struct asset_allocator* a)
+{
+    const struct asset_allocator* prev = thread_allocator;
+    thread_allocator = a;
+    return prev;
+}
+
+const struct asset_allocator* asset_current_allocator()
+{
+    return thread_allocator ? thread_allocator : &global_allocator;
+}
+
+void* asset_malloc(size_t sz)
+{
+    const struct asset_allocator* a = asset_current_allocator();
+    stats_count_alloc(sz);
+    return a->alloc(a->userdata, sz);
+}
+
+void* asset_calloc(size_t num, size_t sz)
+{
+    void* p = asset_malloc(num * sz);
+    if (p)
+        memset(p, 0, num * sz);
+    return p;
+}
+
+void* asset_realloc(void* ptr, size_t sz)
+{
+    const struct asset_allocator* a = asset_current_allocator();
+    stats_count_alloc(sz);
+    return a->realloc(a->userdata, ptr, sz);
+}
+
+void asset_free(void* ptr)
+{
+    if (!ptr)
+        return;
+    const struct asset_allocator* a = asset_current_allocator();
+    stats_count_free();
+    a->free(a->userdata, ptr);
+}
+
+char* asset_strdup(const char* s)
+{
+    size_t len = strlen(s) + 1;
+    char* d = asset_malloc(len);
+    memcpy(d, s, len);
+    return d;
+}
+
+/*-----------------------------------------------------------------
+ * Arena
+ *-----------------------------------------------------------------*/
+#define ARENA_ALIGN 16
+#define ARENA_DEFAULT_BLOCK_SZ (1024 * 1024)
+#define arena_align_up(x) (((x) + (ARENA_ALIGN - 1)) & ~(size_t)(ARENA_ALIGN - 1))
+
+/* Every allocation is preceded by a header holding its size, so realloc can copy */
+#define ARENA_HDR_SZ ARENA_ALIGN
+
+struct arena_block {
+    struct arena_block* prev;
+    size_t cap;
+    size_t top;
+    /* Payload follows, aligned */
+};
+#define ARENA_BLOCK_HDR_SZ arena_align_up(sizeof(struct arena_block))
+#define arena_block_data(b) ((unsigned char*)(b) + ARENA_BLOCK_HDR_SZ)
+
+struct asset_arena {
+    struct arena_block* cur;
+    size_t block_sz;
+    size_t used;
+    /* Most recent allocation, can grow or be freed in place */
+    unsigned char* last;
+    /* Most recent oversized allocation and its dedicated block */
+    unsigned char* big_last;
+    struct arena_block* big_block;
+};
+
+static struct arena_block* arena_block_new(size_t cap, struct arena_block* prev)
+{
+    struct arena_block* b = malloc(ARENA_BLOCK_HDR_SZ + cap);
+    if (!b)
+        return 0;
+    b->prev = prev;
+    b->cap = cap;
+    b->top = 0;
+    return b;
+}
+
+struct asset_arena* asset_arena_create(size_t block_sz)
+{
+    struct asset_arena* a = calloc(1, sizeof(struct asset_arena));
+    a->block_sz = block_sz ? arena_align_up(block_sz) : ARENA_DEFAULT_BLOCK_SZ;
+    a->cur = arena_block_new(a->block_sz, 0);
+    return a;
+}
+
+/* Places an oversized allocation alone in a block of given capacity */
+static void* arena_alloc_big(struct asset_arena* a, size_t sz, size_t cap)
+{
+    /* Oversized requests get a dedicated block behind the current one,
+     * which keeps serving the smaller requests that follow. Tracked as
+     * big_last, so realloc can grow it within the block capacity */
+    size_t need = ARENA_HDR_SZ + arena_align_up(sz);
+    struct arena_block* b = arena_block_new(cap, a->cur->prev);
+    if (!b)
+        return 0;
+    a->cur->prev = b;
+    unsigned char* hdr = arena_block_data(b);
+    *(size_t*)hdr = sz;
+    b->top = need;
+    a->used += sz;
+    a->big_last = hdr + ARENA_HDR_SZ;
+    a->big_block = b;
+    return a->big_last;
+}
+
+/* Unlinks and frees a dedicated block, which is never the current one */
+static void arena_block_unlink(struct asset_arena* a, struct arena_block* b)
+{
+    struct arena_block** link = &a->cur->prev;
+    while (*link != b)
+        link = &(*link)->prev;
+    *link = b->prev;
+    free(b);
+}
+
+void* asset_arena_alloc(struct asset_arena* a, size_t sz)
+{
+    size_t need = ARENA_HDR_SZ + arena_align_up(sz);
+    struct arena_block* b = a->cur;
+    if (need > a->block_sz)
+        return arena_alloc_big(a, sz, need);
+    if (b->top + need > b->cap) {
+        b = arena_block_new(a->block_sz, a->cur);
+        if (!b)
+            return 0;
+        a->cur = b;
+    }
+    unsigned char* hdr = arena_block_data(b) + b->top;
+    *(size_t*)hdr = sz;
+    b->top += need;
+    a->used += sz;
+    a->last = hdr + ARENA_HDR_SZ;
+    return a->last;
+}
+
+static size_t arena_alloc_size(void* ptr)
+{
+    return *(size_t*)((unsigned char*)ptr - ARENA_HDR_SZ);
+}
+
+void* asset_arena_realloc(struct asset_arena* a, void* ptr, size_t sz)
+{
+    if (!ptr)
+        return asset_arena_alloc(a, sz);
+
+    size_t old_sz = arena_alloc_size(ptr);
+    if (ptr == a->big_last) {
+        /* Dedicated blocks grow in place up to their capacity,
+         * then move to a block with geometric slack */
+        struct arena_block* b = a->big_block;
+        size_t need = ARENA_HDR_SZ + arena_align_up(sz);
+        if (need <= b->cap) {
+            b->top = need;
+            *(size_t*)((unsigned char*)ptr - ARENA_HDR_SZ) = sz;
+            a->used = a->used - old_sz + sz;
+            return ptr;
+        }
+        void* nptr = arena_alloc_big(a, sz, need + need / 2);
+        if (!nptr)
+            return 0;
+        memcpy(nptr, ptr, old_sz);
+        /* Old block held nothing else */
+        a->used -= old_sz;
+        arena_block_unlink(a, b);
+        return nptr;
+    }
+    if (ptr == a->last) {
+        /* Grow or shrink the top allocation in place when it fits */
+        struct arena_block* b = a->cur;
+        size_t ofs = (unsigned char*)ptr - arena_block_data(b);
+        if (ofs + arena_align_up(sz) <= b->cap) {
+            b->top = ofs + arena_align_up(sz);
+            *(size_t*)((unsigned char*)ptr - ARENA_HDR_SZ) = sz;
+            a->used = a->used - old_sz + sz;
+            return ptr;
+        }
+    }
+    if (sz <= old_sz)
+        return ptr;
+
+    void* nptr = asset_arena_alloc(a, sz);
+    if (nptr) {
+        memcpy(nptr, ptr, old_sz);
+        /* Moving into a dedicated block leaves ptr on top of cur, give its space back */
+        if (ptr == a->last) {
+            a->cur->top = (unsigned char*)ptr - ARENA_HDR_SZ - arena_block_data(a->cur);
+            a->used -= old_sz;
+            a->last = 0;
+        }
+    }
+    return nptr;
+}
+
+static void arena_free(struct asset_arena* a, void* ptr)
+{
+    /* Only the most recent allocation, or the most recent oversized one, can be given back */
+    if (ptr && ptr == a->big_last) {
+        a->used -= arena_alloc_size(ptr);
+        arena_block_unlink(a, a->big_block);
+        a->big_last = 0;
+        a->big_block = 0;
+    } else if (ptr && ptr == a->last) {
+        struct arena_block* b = a->cur;
+        b->top = (unsigned char*)ptr - ARENA_HDR_SZ - arena_block_data(b);
+        a->used -= arena_alloc_size(ptr);
+        a->last = 0;
+    }
+}
+
+void asset_arena_reset(struct asset_arena* a)
+{
+    /* Keep the oldest block */
+    struct arena_block* b = a->cur;
+    while (b->prev) {
+        struct arena_block* prev = b->prev;
+        free(b);
+        b = prev;
+    }
+    b->top = 0;
+    a->cur = b;
+    a->used = 0;
+    a->last = 0;
+    a->big_last = 0;
+    a->big_block = 0;
+}
+
+void asset_arena_destroy(struct asset_arena* a)
+{
+    struct arena_block* b = a->cur;
+    while (b) {
+        struct arena_block* prev = b->prev;
+        free(b);
+        b = prev;
+    }
+    free(a);
+}
+
+size_t asset_arena_used(struct asset_arena* a)
+{
+    return a->used;
+}
+
+static void* arena_alloc_cb(void* userdata, size_t sz)
+{
+    return asset_arena_alloc(userdata, sz);
+}
+
+static void* arena_realloc_cb(void* userdata, void* ptr, size_t sz)
+{
+    return asset_arena_realloc(userdata, ptr, sz);
+}
+
+static void arena_free_cb(void* userdata, void* ptr)
+{
+    arena_free(userdata, ptr);
+}
+
+struct asset_allocator asset_arena_allocator(struct asset_arena* a)
+{
+    struct asset_allocator al;
+    al.alloc = arena_alloc_cb;
+    al.realloc = arena_realloc_cb;
+    al.free = arena_free_cb;
+    al.userdata = a;
+    return al;
+}
@@ -0,0 +1,324 @@
+/*********************************************************************************************************************/
+/*                                                  /===-_---~~~~~~~~~------____                                     */
+/*                                                 |===-~___                _,-'                                     */
+/*                  -==\\                         `//~\\   ~~~~`---.___.-~~                                          */
+/*              ______-==|                         | |  \\           _-~`                                            */
+/*        __--~~~  ,-/-==\\                        | |   `\        ,'                                                */
+/*     _-~       /'    |  \\                      / /      \      /                                                  */
+/*   .'        /       |   \\                   /' /        \   /'                                                   */
+/*  /  ____  /         |    \`\.__/-~~ ~ \ _ _/'  /          \/'                                                     */
+/* /-'~    ~~~~~---__  |     ~-/~         ( )   /'        _--~`                                                      */
+/*                   \_|      /        _)   ;  ),   __--~~                                                           */
+/*                     '~~--_/      _-~/-  / \   '-~ \                                                               */
+/*                    {\__--_/}    / \\_>- )<__\      \                                                              */
+/*                    /'   (_/  _-~  | |__>--<__|      |                                                             */
+/*                   |0  0 _/) )-~     | |__>--<__|     |                                                            */
+/*                   / /~ ,_/       / /__>---<__/      |                                                             */
+/*                  o o _//        /-~_>---<__-~      /                                                              */
+/*                  (^(~          /~_>---<__-      _-~                                                               */
+/*                 ,/|           /__>--<__/     _-~                                                                  */
+/*              ,//('(          |__>--<__|     /                  .----_                                             */
+/*             ( ( '))          |__>--<__|    |                 /' _---_~\                                           */
+/*          `-)) )) (           |__>--<__|    |               /'  /     ~\`\                                         */
+/*         ,/,'//( (             \__>--<__\    \            /'  //        ||                                         */
+/*       ,( ( ((, ))              ~-__>--<_~-_  ~--____---~' _/'/        /'                                          */
+/*     `~/  )` ) ,/|                 ~-_~>--<_/-__       __-~ _/                                                     */
+/*   ._-~//( )/ )) `                    ~~-'_/_/ /~~~~~~~__--~                                                       */
+/*    ;'( ')/ ,)(                              ~~~~~~~~~~                                                            */
+/*   ' ') '( (/                                                                                                      */
+/*     '   '  `                                                                                                      */
+/*********************************************************************************************************************/
+#include "assets/asyncload.h"
+#include <stdlib.h>
+#include <string.h>
+#include "assets/fileload.h"
+#include "assets/error.h"
+#include "assets/image/imageload.h"
+#include "assets/model/modelload.h"
+#include "assets/model/postprocess.h"
+#include "assets/sound/soundload.h"
+#include "threadpool.h"
+#include "util.h"
+
+/*-----------------------------------------------------------------
+ * Synchronous dispatch
+ *-----------------------------------------------------------------*/
+static void* decode_mem_buf(enum asset_type type, const unsigned char* data, size_t sz, const char* hint, const struct vertex_decl* decl)
+{
+    void* asset = 0;
+    switch (type) {
+        case ASSET_IMAGE:
+            asset = image_from_mem_buf(data, sz, hint);
+            break;
+        case ASSET_MODEL:
+            asset = model_from_mem_buf_decl(data, sz, hint, decl);
+            break;
+        case ASSET_FRAMESET:
+            asset = frameset_from_mem_buf(data, sz, hint);
+            break;
+        case ASSET_SOUND:
+            asset = sound_from_mem_buf(data, sz, hint);
+            break;
+        default:
+            set_last_asset_load_status(ASSET_LOAD_UNKNOWN_FORMAT, "Unsupported asset type");
+            return 0;
+    }
+    /* Not every loader explains its failures */
+    if (!asset && get_last_asset_load_status() == ASSET_LOAD_OK)
+        set_last_asset_load_error("Invalid asset data");
+    return asset;
+}
+
+void* asset_from_mem_buf(enum asset_type type, const unsigned char* data, size_t sz, const char* hint)
+{
+    return decode_mem_buf(type, data, sz, hint, 0);
+}
+
+void* asset_decode(enum asset_type type, const unsigned char* data, size_t sz, const char* hint, const struct asset_load_opts* opts)
+{
+    const struct asset_allocator* alloc = opts ? opts->allocator : 0;
+    const struct vertex_decl* decl = opts ? opts->vertex_decl : 0;
+    const struct asset_allocator* prev_alloc = 0;
+    if (alloc)
+        prev_alloc = asset_set_thread_allocator(alloc);
+
+    void* asset = 0;
+    if (type == ASSET_MODEL && opts && opts->pack_models) {
+        /* Build the scattered model in a scratch arena, then copy it into one block */
+        struct asset_arena* scratch = asset_arena_create(0);
+        struct asset_allocator scratch_alloc = asset_arena_allocator(scratch);
+        const struct asset_allocator* outer_alloc = asset_set_thread_allocator(&scratch_alloc);
+        struct model* m = decode_mem_buf(type, data, sz, hint, decl);
+        if (m && opts->quantize_models)
+            model_quantize(m);
+        asset_set_thread_allocator(outer_alloc);
+        if (m)
+            asset = model_pack(m);
+        asset_arena_destroy(scratch);
+    } else {
+        asset = decode_mem_buf(type, data, sz, hint, decl);
+        if (asset && type == ASSET_MODEL && opts && opts->quantize_models)
+            model_quantize(asset);
+    }
+
+    if (alloc)
+        asset_set_thread_allocator(prev_alloc);
+    return asset;
+}
+
+void* asset_load(enum asset_type type, const char* path, const struct asset_load_opts* opts)
+{
+    if (type == ASSET_SHADER) {
+        struct shader_load_settings settings;
+        if (opts && opts->shader_settings) {
+            settings = *opts->shader_settings;
+        } else {
+            memset(&settings, 0, sizeof(settings));
+            settings.load_type = SHADER_LOAD_FILE;
+        }
+        clear_last_asset_load_error();
+        const char* src = shader_load(path, &settings);
+        if (!src)
+            set_last_asset_load_status(ASSET_LOAD_IO_ERROR, "Could not load shader");
+        return (void*)src;
+    }
+
+    /* Map file contents */
+    struct file_blob fb;
+    if (!file_blob_open(&fb, path, FILE_ACCESS_SEQUENTIAL)) {
+        set_last_asset_load_status(ASSET_LOAD_IO_ERROR, "Could not open file");
+        return 0;
+    }
+
+    /* Parse asset data from memory */
+    const char* hint = opts && opts->hint ? opts->hint : get_filename_ext(path);
+    void* asset = asset_decode(type, fb.data, fb.size, hint, opts);
+    file_blob_close(&fb);
+    return asset;
+}
+
+void asset_delete(enum asset_type type, void* asset)
+{
+    if (!asset)
+        return;
+    switch (type) {
+        case ASSET_IMAGE:
+            image_delete(asset);
+            break;
+        case ASSET_MODEL:
+            model_delete(asset);
+            break;
+        case ASSET_FRAMESET:
+            frameset_delete(asset);
+            break;
+        case ASSET_SOUND:
+            sound_delete(asset);
+            break;
+        case ASSET_SHADER:
+            free(asset);
+            break;
+    }
+}
+
+/*-----------------------------------------------------------------
+ * Futures
+ *-----------------------------------------------------------------*/
+struct asset_future {
+    enum asset_type type;
+    char* path;
+    char* hint;
+    struct shader_load_settings shader_settings;
+    int has_shader_settings;
+    const struct asset_allocator* allocator;
+    int pack_models;
+    int quantize_models;
+    struct vertex_decl vertex_decl;
+    int has_vertex_decl;
+    asset_load_cb cb;
+    void* userdata;
+    void* asset;
+    enum asset_load_status status;
+    char error[256];
+    /* Completion state */
+    mutex_t mtx;
+    cond_t done_cond;
+    int done;
+    /* Shared by the caller handle and the queued task */
+    int refs;
+};
+
+static void asset_future_unref(struct asset_future* f)
+{
+    mutex_lock(&f->mtx);
+    int refs = --f->refs;
+    mutex_unlock(&f->mtx);
+    if (refs)
+        return;
+
+    /* Untaken asset goes back to the allocator it came from */
+    const struct asset_allocator* prev_alloc = 0;
+    if (f->allocator)
+        prev_alloc = asset_set_thread_allocator(f->allocator);
+    asset_delete(f->type, f->asset);
+    if (f->allocator)
+        asset_set_thread_allocator(prev_alloc);
+    free(f->path);
+    free(f->hint);
+    cond_destroy(&f->done_cond);
+    mutex_destroy(&f->mtx);
+    free(f);
+}
+
+static void asset_load_task(void* arg)
+{
+    struct asset_future* f = arg;
+
+    /* Rebuild options from the copies held by the future */
+    struct asset_load_opts opts;
+    opts.hint = f->hint;
+    opts.shader_settings = f->has_shader_settings ? &f->shader_settings : 0;
+    opts.allocator = f->allocator;
+    opts.pack_models = f->pack_models;
+    opts.quantize_models = f->quantize_models;
+    opts.vertex_decl = f->has_vertex_decl ? &f->vertex_decl : 0;
+    void* asset = asset_load(f->type, f->path, &opts);
+    f->status = get_last_asset_load_status();
+    strncpy(f->error, get_last_asset_load_error(), sizeof(f->error) - 1);
+
+    /* Notify before publishing so the callback runs ahead of any waiter */
+    if (f->cb)
+        f->cb(f->userdata, f->type, asset);
+
+    mutex_lock(&f->mtx);
+    f->asset = asset;
+    f->done = 1;
+    cond_broadcast(&f->done_cond);
+    mutex_unlock(&f->mtx);
+    asset_future_unref(f);
+}
+
+void asset_async_init(unsigned int num_threads)
+{
+    tp_start(num_threads);
+}
+
+void asset_async_shutdown()
+{
+    tp_stop();
+}
+
+struct asset_future* asset_load_async(enum asset_type type, const char* path, const struct asset_load_opts* opts, asset_load_cb cb, void* userdata)
+{
+    struct asset_future* f = calloc(1, sizeof(struct asset_future));
+    f->type = type;
+    f->path = strdup(path);
+    if (opts && opts->hint)
+        f->hint = strdup(opts->hint);
+    if (opts && opts->shader_settings) {
+        f->shader_settings = *opts->shader_settings;
+        f->has_shader_settings = 1;
+    }
+    if (opts) {
+        f->allocator = opts->allocator;
+        f->pack_models = opts->pack_models;
+        f->quantize_models = opts->quantize_models;
+    }
+    if (opts && opts->vertex_decl) {
+        f->vertex_decl = *opts->vertex_decl;
+        f->has_vertex_decl = 1;
+    }
+    f->cb = cb;
+    f->userdata = userdata;
+    mutex_init(&f->mtx);
+    cond_init(&f->done_cond);
+    f->refs = 2;
+
+    tp_ensure_started();
+    tp_submit(0, asset_load_task, f);
+    return f;
+}
+
+int asset_future_ready(struct asset_future* f)
+{
+    mutex_lock(&f->mtx);
+    int done = f->done;
+    mutex_unlock(&f->mtx);
+    return done;
+}
+
+void* asset_future_wait(struct asset_future* f)
+{
+    /* Help with queued work first, the load may sit behind the calling
+     * worker (a completion callback waiting on another future) */
+    while (!asset_future_ready(f) && tp_run_one())
+        ;
+    mutex_lock(&f->mtx);
+    while (!f->done)
+        cond_wait(&f->done_cond, &f->mtx);
+    void* asset = f->asset;
+    mutex_unlock(&f->mtx);
+    return asset;
+}
+
+enum asset_load_status asset_future_status(struct asset_future* f, const char** err)
+{
+    asset_future_wait(f);
+    if (err)
+        *err = f->error;
+    return f->status;
+}
+
+void* asset_future_take(struct asset_future* f)
+{
+    void* asset = asset_future_wait(f);
+    mutex_lock(&f->mtx);
+    f->asset = 0;
+    mutex_unlock(&f->mtx);
+    return asset;
+}
+
+void asset_future_release(struct asset_future* f)
+{
+    asset_future_wait(f);
+    asset_future_unref(f);
+}
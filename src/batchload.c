@@ -0,0 +1,210 @@
+/*********************************************************************************************************************/
+/*                                                  /===-_---~~~~~~~~~------____                                     */
+/*                                                 |===-~___                _,-'                                     */
+/*                  -==\\                         `//~\\   ~~~~`---.___.-~~                                          */
+/*              ______-==|                         | |  \\           _-~`                                            */
+/*        __--~~~  ,-/-==\\                        | |   `\        ,'                                                */
+/*     _-~       /'    |  \\                      / /      \      /                                                  */
+/*   .'        /       |   \\                   /' /        \   /'                                                   */
+/*  /  ____  /         |    \`\.__/-~~ ~ \ _ _/'  /          \/'                                                     */
+/* /-'~    ~~~~~---__  |     ~-/~         ( )   /'        _--~`                                                      */
+/*                   \_|      /        _)   ;  ),   __--~~                                                           */
+/*                     '~~--_/      _-~/-  / \   '-~ \                                                               */
+/*                    {\__--_/}    / \\_>- )<__\      \                                                              */
+/*                    /'   (_/  _-~  | |__>--<__|      |                                                             */
+/*                   |0  0 _/) )-~     | |__>--<__|     |                                                            */
+/*                   / /~ ,_/       / /__>---<__/      |                                                             */
+/*                  o o _//        /-~_>---<__-~      /                                                              */
+/*                  (^(~          /~_>---<__-      _-~                                                               */
+/*                 ,/|           /__>--<__/     _-~                                                                  */
+/*              ,//('(          |__>--<__|     /                  .----_                                             */
+/*             ( ( '))          |__>--<__|    |                 /' _---_~\                                           */
+/*          `-)) )) (           |__>--<__|    |               /'  /     ~\`\                                         */
+/*         ,/,'//( (             \__>--<__\    \            /'  //        ||                                         */
+/*       ,( ( ((, ))              ~-__>--<_~-_  ~--____---~' _/'/        /'                                          */
+/*     `~/  )` ) ,/|                 ~-_~>--<_/-__       __-~ _/                                                     */
+/*   ._-~//( )/ )) `                    ~~-'_/_/ /~~~~~~~__--~                                                       */
+/*    ;'( ')/ ,)(                              ~~~~~~~~~~                                                            */
+/*   ' ') '( (/                                                                                                      */
+/*     '   '  `                                                                                                      */
+/*********************************************************************************************************************/
+#include "assets/batchload.h"
+#include <stdlib.h>
+#include <string.h>
+#include "assets/abstractfs.h"
+#include "assets/fileload.h"
+#include "assets/error.h"
+#include "threadpool.h"
+#include "stats.h"
+#include "util.h"
+
+#define BATCH_DEFAULT_MAX_INFLIGHT (256 * 1024 * 1024)
+
+struct batch_context {
+    const struct asset_batch_opts* opts;
+    /* Read bytes waiting to be decoded */
+    mutex_t mtx;
+    cond_t drained;
+    size_t inflight;
+};
+
+struct batch_entry {
+    struct asset_batch_item* item;
+    struct batch_context* ctx;
+    struct file_blob fb;
+    /* Storage order key */
+    const char* container;
+    unsigned long long dev;
+    unsigned long long id;
+};
+
+static int batch_entry_cmp(const void* a, const void* b)
+{
+    const struct batch_entry* e1 = a;
+    const struct batch_entry* e2 = b;
+    /* Archive members group by archive, then by name */
+    if (e1->container != e2->container) {
+        if (!e1->container || !e2->container)
+            return e1->container ? 1 : -1;
+        int c = strcmp(e1->container, e2->container);
+        if (c)
+            return c;
+    }
+    if (e1->dev != e2->dev)
+        return e1->dev < e2->dev ? -1 : 1;
+    if (e1->id != e2->id)
+        return e1->id < e2->id ? -1 : 1;
+    return strcmp(e1->item->path, e2->item->path);
+}
+
+static void batch_decode_task(void* arg)
+{
+    struct batch_entry* e = arg;
+    struct asset_batch_item* item = e->item;
+
+    const char* hint = item->hint ? item->hint : get_filename_ext(item->path);
+    /* Decoded away from the reader, so name the item for trace events */
+    stats_set_label(item->path);
+    struct asset_load_opts lopts;
+    memset(&lopts, 0, sizeof(lopts));
+    if (e->ctx->opts) {
+        lopts.allocator = e->ctx->opts->allocator;
+        lopts.pack_models = e->ctx->opts->pack_models;
+        lopts.quantize_models = e->ctx->opts->quantize_models;
+        lopts.vertex_decl = e->ctx->opts->vertex_decl;
+    }
+    item->asset = asset_decode(item->type, e->fb.data, e->fb.size, hint, &lopts);
+    item->status = item->asset ? ASSET_BATCH_OK : ASSET_BATCH_DECODE_ERROR;
+    if (!item->asset)
+        strncpy(item->error, get_last_asset_load_error(), sizeof(item->error) - 1);
+
+    /* Give the budget back to the reader */
+    size_t sz = e->fb.size;
+    file_blob_close(&e->fb);
+    mutex_lock(&e->ctx->mtx);
+    e->ctx->inflight -= sz;
+    cond_signal(&e->ctx->drained);
+    mutex_unlock(&e->ctx->mtx);
+}
+
+static void batch_shader_task(void* arg)
+{
+    struct batch_entry* e = arg;
+    struct asset_batch_item* item = e->item;
+
+    /* Shaders resolve their own includes, so they bypass the reader */
+    struct asset_load_opts lopts;
+    lopts.hint = item->hint;
+    lopts.shader_settings = e->ctx->opts ? e->ctx->opts->shader_settings : 0;
+    lopts.allocator = 0;
+    lopts.pack_models = 0;
+    lopts.quantize_models = 0;
+    lopts.vertex_decl = 0;
+    item->asset = asset_load(item->type, item->path, &lopts);
+    item->status = item->asset ? ASSET_BATCH_OK : ASSET_BATCH_IO_ERROR;
+    if (!item->asset)
+        strncpy(item->error, get_last_asset_load_error(), sizeof(item->error) - 1);
+}
+
+size_t asset_batch_load(struct asset_batch_item* items, size_t num_items, const struct asset_batch_opts* opts)
+{
+    struct batch_context ctx;
+    ctx.opts = opts;
+    ctx.inflight = 0;
+    mutex_init(&ctx.mtx);
+    cond_init(&ctx.drained);
+    size_t max_inflight = opts && opts->max_inflight_bytes ? opts->max_inflight_bytes : BATCH_DEFAULT_MAX_INFLIGHT;
+
+    /* Gather storage locations and order reads by them */
+    int use_afs = afs_initialized();
+    struct batch_entry* entries = calloc(num_items, sizeof(struct batch_entry));
+    for (size_t i = 0; i < num_items; ++i) {
+        struct batch_entry* e = entries + i;
+        e->item = items + i;
+        e->ctx = &ctx;
+        e->item->asset = 0;
+        e->item->status = ASSET_BATCH_PENDING;
+        e->item->error[0] = '\0';
+        if (use_afs)
+            e->container = afs_real_dir(e->item->path);
+        else
+            file_storage_key(e->item->path, &e->dev, &e->id);
+    }
+    qsort(entries, num_items, sizeof(struct batch_entry), batch_entry_cmp);
+
+    /* Read in order on this thread, decode on the pool */
+    tp_ensure_started();
+    struct tp_group grp;
+    tp_group_init(&grp);
+    for (size_t i = 0; i < num_items; ++i) {
+        struct batch_entry* e = entries + i;
+        if (e->item->type == ASSET_SHADER) {
+            tp_submit(&grp, batch_shader_task, e);
+            continue;
+        }
+
+        /* Throttle while too much read data awaits decoding, helping with it meanwhile */
+        for (;;) {
+            mutex_lock(&ctx.mtx);
+            int over = ctx.inflight && ctx.inflight >= max_inflight;
+            mutex_unlock(&ctx.mtx);
+            if (!over)
+                break;
+            if (tp_run_one())
+                continue;
+            mutex_lock(&ctx.mtx);
+            if (ctx.inflight && ctx.inflight >= max_inflight)
+                cond_wait(&ctx.drained, &ctx.mtx);
+            mutex_unlock(&ctx.mtx);
+        }
+
+        if (!file_blob_open(&e->fb, e->item->path, FILE_ACCESS_SEQUENTIAL)) {
+            e->item->status = ASSET_BATCH_IO_ERROR;
+            strcpy(e->item->error, "Could not open file");
+            continue;
+        }
+        mutex_lock(&ctx.mtx);
+        ctx.inflight += e->fb.size;
+        mutex_unlock(&ctx.mtx);
+        tp_submit(&grp, batch_decode_task, e);
+    }
+    tp_group_wait(&grp);
+
+    size_t num_ok = 0;
+    for (size_t i = 0; i < num_items; ++i)
+        num_ok += items[i].status == ASSET_BATCH_OK;
+
+    free(entries);
+    cond_destroy(&ctx.drained);
+    mutex_destroy(&ctx.mtx);
+    return num_ok;
+}
+
+void asset_batch_free(struct asset_batch_item* items, size_t num_items)
+{
+    for (size_t i = 0; i < num_items; ++i) {
+        asset_delete(items[i].type, items[i].asset);
+        items[i].asset = 0;
+        items[i].status = ASSET_BATCH_PENDING;
+    }
+}
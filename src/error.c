@@ -1,12 +1,29 @@
 #include "assets/error.h"
 #include <string.h>
+#include "thread.h"
 
-static char* load_err_buf[256];
+static thread_local_var char load_err_buf[256];
+static thread_local_var enum asset_load_status load_status;
 
 const char* get_last_asset_load_error() {
-    return (const char*) load_err_buf;
+    return load_err_buf;
 }
 
 void set_last_asset_load_error(const char* err) {
-    strncpy((char*)load_err_buf, err, sizeof(load_err_buf));
+    set_last_asset_load_status(ASSET_LOAD_INVALID_DATA, err);
+}
+
+enum asset_load_status get_last_asset_load_status() {
+    return load_status;
+}
+
+void set_last_asset_load_status(enum asset_load_status st, const char* err) {
+    load_status = st;
+    strncpy(load_err_buf, err, sizeof(load_err_buf) - 1);
+    load_err_buf[sizeof(load_err_buf) - 1] = '\0';
+}
+
+void clear_last_asset_load_error() {
+    load_status = ASSET_LOAD_OK;
+    load_err_buf[0] = '\0';
 }
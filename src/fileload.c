@@ -1,6 +1,18 @@
 #include "assets/fileload.h"
 #include <stdio.h>
+#include <stdlib.h>
+#include <plat.h>
 #include <assets/abstractfs.h>
+#include "stats.h"
+#ifdef OS_WINDOWS
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 static long stdio_filesize(const char* filepath)
 {
@@ -55,3 +67,160 @@ int read_file_to_mem(const char* fname, unsigned char* buf, size_t buf_sz)
     else
         return stdio_read_file_to_mem(fname, buf, buf_sz);
 }
+
+/*-----------------------------------------------------------------
+ * File blobs
+ *-----------------------------------------------------------------*/
+#ifdef OS_WINDOWS
+int file_storage_key(const char* fpath, unsigned long long* dev, unsigned long long* id)
+{
+    HANDLE f = CreateFileA(fpath, 0, FILE_SHARE_READ, 0, OPEN_EXISTING, 0, 0);
+    if (f == INVALID_HANDLE_VALUE)
+        return 0;
+    BY_HANDLE_FILE_INFORMATION fi;
+    int ok = GetFileInformationByHandle(f, &fi);
+    CloseHandle(f);
+    if (!ok)
+        return 0;
+    *dev = fi.dwVolumeSerialNumber;
+    *id = ((unsigned long long)fi.nFileIndexHigh << 32) | fi.nFileIndexLow;
+    return 1;
+}
+
+static int native_file_blob_open(struct file_blob* fb, const char* fpath, enum file_access_hint hint)
+{
+    DWORD flags = hint == FILE_ACCESS_RANDOM ? FILE_FLAG_RANDOM_ACCESS : FILE_FLAG_SEQUENTIAL_SCAN;
+    HANDLE f = CreateFileA(fpath, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, flags, 0);
+    if (f == INVALID_HANDLE_VALUE)
+        return 0;
+
+    LARGE_INTEGER fsz;
+    if (!GetFileSizeEx(f, &fsz)) {
+        CloseHandle(f);
+        return 0;
+    }
+    fb->size = (size_t)fsz.QuadPart;
+
+    /* Empty files cannot be mapped */
+    if (fb->size == 0) {
+        CloseHandle(f);
+        return 1;
+    }
+
+    /* The view keeps the mapping alive, so both handles can be closed right away */
+    HANDLE fm = CreateFileMappingA(f, 0, PAGE_READONLY, 0, 0, 0);
+    CloseHandle(f);
+    if (!fm)
+        return 0;
+    fb->data = MapViewOfFile(fm, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(fm);
+    if (!fb->data)
+        return 0;
+    fb->mapped = 1;
+    return 1;
+}
+
+static void native_file_blob_unmap(struct file_blob* fb)
+{
+    UnmapViewOfFile((void*)fb->data);
+}
+#else
+int file_storage_key(const char* fpath, unsigned long long* dev, unsigned long long* id)
+{
+    struct stat st;
+    if (stat(fpath, &st) == -1)
+        return 0;
+    *dev = st.st_dev;
+    *id = st.st_ino;
+    return 1;
+}
+
+static int native_file_blob_open(struct file_blob* fb, const char* fpath, enum file_access_hint hint)
+{
+    int fd = open(fpath, O_RDONLY);
+    if (fd == -1)
+        return 0;
+
+    struct stat st;
+    if (fstat(fd, &st) == -1 || !S_ISREG(st.st_mode)) {
+        close(fd);
+        return 0;
+    }
+    fb->size = st.st_size;
+
+    /* Empty files cannot be mapped */
+    if (fb->size == 0) {
+        close(fd);
+        return 1;
+    }
+
+    void* p = mmap(0, fb->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (p == MAP_FAILED) {
+        /* Fallback to a plain read through the already open descriptor */
+        unsigned char* buf = malloc(fb->size);
+        size_t rd = 0;
+        while (buf && rd < fb->size) {
+            ssize_t r = read(fd, buf + rd, fb->size - rd);
+            if (r <= 0)
+                break;
+            rd += r;
+        }
+        close(fd);
+        if (rd != fb->size) {
+            free(buf);
+            return 0;
+        }
+        fb->data = buf;
+        return 1;
+    }
+    close(fd);
+
+    /* Let the kernel know how the parser is going to walk the data */
+    madvise(p, fb->size, hint == FILE_ACCESS_RANDOM ? MADV_RANDOM : MADV_SEQUENTIAL);
+    /* Prefetch only when the whole file is going to be read */
+    if (hint == FILE_ACCESS_SEQUENTIAL)
+        madvise(p, fb->size, MADV_WILLNEED);
+    fb->data = p;
+    fb->mapped = 1;
+    return 1;
+}
+
+static void native_file_blob_unmap(struct file_blob* fb)
+{
+    munmap((void*)fb->data, fb->size);
+}
+#endif
+
+int file_blob_open(struct file_blob* fb, const char* fpath, enum file_access_hint hint)
+{
+    fb->data = 0;
+    fb->size = 0;
+    fb->mapped = 0;
+    stats_set_label(fpath);
+    uint64_t t0 = stats_phase_begin();
+
+    /* Archives served by the abstract filesystem cannot be mapped */
+    int ok;
+    if (afs_initialized()) {
+        fb->data = afs_read_file(fpath, &fb->size);
+        ok = fb->data != 0;
+    } else {
+        ok = native_file_blob_open(fb, fpath, hint);
+    }
+
+    stats_phase_end(ASSET_PHASE_READ, t0);
+    if (ok)
+        stats_count_read(fb->size);
+    return ok;
+}
+
+void file_blob_close(struct file_blob* fb)
+{
+    if (fb->mapped)
+        native_file_blob_unmap(fb);
+    else
+        free((void*)fb->data);
+    fb->data = 0;
+    fb->size = 0;
+    fb->mapped = 0;
+}
@@ -1,18 +1,22 @@
 #include "assets/image/image.h"
+#include "assets/allocator.h"
+#include "../stats.h"
 #include <stdlib.h>
 
 struct image* image_blank(int width, int height, int channels) {
-    struct image* i = malloc(sizeof(struct image));
+    struct image* i = asset_malloc(sizeof(struct image));
     i->width = width;
     i->height = height;
     i->channels = channels;
     i->compression_type = 0;
     i->data_sz = width * height * channels * sizeof(unsigned char);
-    i->data = malloc(i->data_sz);
+    i->data = asset_malloc(i->data_sz);
     return i;
 }
 
 void image_delete(struct image* i) {
-    free(i->data);
-    free(i);
+    uint64_t t0 = stats_phase_begin();
+    asset_free(i->data);
+    asset_free(i);
+    stats_phase_end(ASSET_PHASE_FREE, t0);
 }
@@ -1,40 +1,131 @@
 #include "assets/image/imageload.h"
 #include "assets/fileload.h"
+#include "assets/error.h"
 #include "../util.h"
+#include "../stats.h"
 #include <stdlib.h>
 #include <string.h>
 
+enum image_format image_format_detect(const unsigned char* data, size_t sz, const char* hint)
+{
+    /* Magic bytes */
+    static const unsigned char png_sig[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    static const unsigned char ktx_sig[12] = { 0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n' };
+    if (sz >= sizeof(png_sig) && memcmp(data, png_sig, sizeof(png_sig)) == 0)
+        return IMAGE_FORMAT_PNG;
+    if (sz >= 3 && data[0] == 0xFF && data[1] == 0xD8 && data[2] == 0xFF)
+        return IMAGE_FORMAT_JPEG;
+    if (sz >= 4 && (memcmp(data, "II*\0", 4) == 0 || memcmp(data, "MM\0*", 4) == 0))
+        return IMAGE_FORMAT_TIFF;
+    if (sz >= sizeof(ktx_sig) && memcmp(data, ktx_sig, sizeof(ktx_sig)) == 0)
+        return IMAGE_FORMAT_KTX;
+
+    /* Formats without a signature (tga) or damaged
+     * files are left to the loader the hint selects */
+    if (!hint)
+        return IMAGE_FORMAT_UNKNOWN;
+    if (strcmpi(hint, "png") == 0)
+        return IMAGE_FORMAT_PNG;
+    else if (strcmpi(hint, "jpg") == 0 || strcmpi(hint, "jpeg") == 0)
+        return IMAGE_FORMAT_JPEG;
+    else if (strcmpi(hint, "tif") == 0 || strcmpi(hint, "tiff") == 0)
+        return IMAGE_FORMAT_TIFF;
+    else if (strcmpi(hint, "tga") == 0)
+        return IMAGE_FORMAT_TGA;
+    else if (strcmpi(hint, "ktx") == 0)
+        return IMAGE_FORMAT_KTX;
+    return IMAGE_FORMAT_UNKNOWN;
+}
+
 struct image* image_from_mem_buf(const unsigned char* data, size_t sz, const char* hint) {
-    if(strcmpi(hint, "png") == 0) {
-        return image_from_png(data, sz);
-    } else if (strcmpi(hint, "jpg") == 0 || strcmpi(hint, "jpeg") == 0) {
-        return image_from_jpeg(data, sz);
-    } else if (strcmpi(hint, "tif") == 0 || strcmpi(hint, "tiff") == 0) {
-        return image_from_tiff(data, sz);
-    } else if (strcmpi(hint, "tga") == 0) {
-        return image_from_tga(data, sz);
-    } else if (strcmpi(hint, "ktx") == 0) {
-        return image_from_ktx(data, sz);
+    clear_last_asset_load_error();
+    uint64_t t0 = stats_phase_begin();
+    struct image* im = 0;
+    switch (image_format_detect(data, sz, hint)) {
+        case IMAGE_FORMAT_PNG:
+            im = image_from_png(data, sz);
+            break;
+        case IMAGE_FORMAT_JPEG:
+            im = image_from_jpeg(data, sz);
+            break;
+        case IMAGE_FORMAT_TIFF:
+            im = image_from_tiff(data, sz);
+            break;
+        case IMAGE_FORMAT_TGA:
+            im = image_from_tga(data, sz);
+            break;
+        case IMAGE_FORMAT_KTX:
+            im = image_from_ktx(data, sz);
+            break;
+        default:
+            /* No image parser found */
+            set_last_asset_load_status(ASSET_LOAD_UNKNOWN_FORMAT, "Unknown image format");
+            break;
+    }
+    stats_phase_end(ASSET_PHASE_PARSE, t0);
+    if (im)
+        stats_count_asset();
+    return im;
+}
+
+int image_info_from_mem_buf(const unsigned char* data, size_t sz, const char* hint, struct image_info* info) {
+    clear_last_asset_load_error();
+    memset(info, 0, sizeof(*info));
+    info->format = image_format_detect(data, sz, hint);
+    int ok = 0;
+    switch (info->format) {
+        case IMAGE_FORMAT_PNG:
+            ok = image_info_from_png(data, sz, info);
+            break;
+        case IMAGE_FORMAT_JPEG:
+            ok = image_info_from_jpeg(data, sz, info);
+            break;
+        case IMAGE_FORMAT_TIFF:
+            ok = image_info_from_tiff(data, sz, info);
+            break;
+        case IMAGE_FORMAT_TGA:
+            ok = image_info_from_tga(data, sz, info);
+            break;
+        case IMAGE_FORMAT_KTX:
+            ok = image_info_from_ktx(data, sz, info);
+            break;
+        default:
+            set_last_asset_load_status(ASSET_LOAD_UNKNOWN_FORMAT, "Unknown image format");
+            return 0;
     }
-    /* No image parser found */
-    return 0;
+    if (!ok && get_last_asset_load_status() == ASSET_LOAD_OK)
+        set_last_asset_load_error("Invalid image header");
+    return ok;
 }
 
 struct image* image_from_file(const char* fpath) {
-    /* Check file for existence */
-    long filesz = filesize(fpath);
-    if (filesz == -1)
+    /* Map file contents */
+    struct file_blob fb;
+    if (!file_blob_open(&fb, fpath, FILE_ACCESS_SEQUENTIAL)) {
+        set_last_asset_load_status(ASSET_LOAD_IO_ERROR, "Could not open file");
         return 0;
-
-    /* Gather file contents */
-    unsigned char* data_buf = malloc(filesz);
-    read_file_to_mem(fpath, data_buf, filesz);
+    }
 
     /* Parse image data from memory */
     const char* ext = get_filename_ext(fpath);
-    struct image* im = image_from_mem_buf(data_buf, filesz, ext);
-    free(data_buf);
+    struct image* im = image_from_mem_buf(fb.data, fb.size, ext);
+    file_blob_close(&fb);
 
     /* Return parsed image */
     return im;
 }
+
+int image_info_from_file(const char* fpath, struct image_info* info) {
+    /* Map file contents, only the header pages are touched */
+    struct file_blob fb;
+    if (!file_blob_open(&fb, fpath, FILE_ACCESS_RANDOM)) {
+        set_last_asset_load_status(ASSET_LOAD_IO_ERROR, "Could not open file");
+        return 0;
+    }
+
+    /* Parse image header from memory */
+    const char* ext = get_filename_ext(fpath);
+    int ok = image_info_from_mem_buf(fb.data, fb.size, ext, info);
+    file_blob_close(&fb);
+    return ok;
+}
@@ -1,15 +1,48 @@
 #include "assets/image/imageload.h"
 #include "assets/error.h"
 #include <stdio.h>
+#include <setjmp.h>
 #include "jpeglib.h"
 
+/* Error manager that reports through the asset load error instead of exiting */
+struct jpeg_error_ctx {
+    struct jpeg_error_mgr pub;
+    jmp_buf jb;
+};
+
+static void jpeg_error_exit_cb(j_common_ptr cinfo)
+{
+    struct jpeg_error_ctx* ectx = (struct jpeg_error_ctx*) cinfo->err;
+    char msg[JMSG_LENGTH_MAX];
+    (*cinfo->err->format_message)(cinfo, msg);
+    set_last_asset_load_error(msg);
+    longjmp(ectx->jb, 1);
+}
+
+static void jpeg_output_message_cb(j_common_ptr cinfo)
+{
+    /* Drop warnings instead of printing them to stderr */
+    (void) cinfo;
+}
+
 struct image* image_from_jpeg(const unsigned char* data, size_t sz) {
     /* Create decompress struct */
     struct jpeg_decompress_struct cinfo;
 
     /* Set the error handling mechanism */
-    struct jpeg_error_mgr err_mgr;
-    cinfo.err = jpeg_std_error(&err_mgr);
+    struct jpeg_error_ctx err_ctx;
+    cinfo.err = jpeg_std_error(&err_ctx.pub);
+    err_ctx.pub.error_exit = jpeg_error_exit_cb;
+    err_ctx.pub.output_message = jpeg_output_message_cb;
+
+    /* Image to be returned, volatile as it is read after a longjmp */
+    struct image* volatile im = 0;
+    if (setjmp(err_ctx.jb)) {
+        jpeg_destroy_decompress(&cinfo);
+        if (im)
+            image_delete(im);
+        return 0;
+    }
 
     /* Initialize decompression object */
     jpeg_create_decompress(&cinfo);
@@ -31,7 +64,7 @@ struct image* image_from_jpeg(const unsigned char* data, size_t sz) {
     int pixel_size = cinfo.output_components;
 
     /* Allocate and fill the image object */
-    struct image* im = image_blank(width, height, pixel_size);
+    im = image_blank(width, height, pixel_size);
 
     /* Read by lines */
     unsigned char* bufp = im->data;
@@ -50,3 +83,31 @@ struct image* image_from_jpeg(const unsigned char* data, size_t sz) {
     /* Return loaded image */
     return im;
 }
+
+int image_info_from_jpeg(const unsigned char* data, size_t sz, struct image_info* info) {
+    struct jpeg_decompress_struct cinfo;
+    struct jpeg_error_ctx err_ctx;
+    cinfo.err = jpeg_std_error(&err_ctx.pub);
+    err_ctx.pub.error_exit = jpeg_error_exit_cb;
+    err_ctx.pub.output_message = jpeg_output_message_cb;
+    if (setjmp(err_ctx.jb)) {
+        jpeg_destroy_decompress(&cinfo);
+        return 0;
+    }
+
+    /* Read markers up to SOF and compute output dimensions without decoding */
+    jpeg_create_decompress(&cinfo);
+    jpeg_mem_src(&cinfo, (unsigned char*) data, sz);
+    if (!jpeg_read_header(&cinfo, TRUE)) {
+        jpeg_destroy_decompress(&cinfo);
+        set_last_asset_load_error("Incorrect jpeg header");
+        return 0;
+    }
+    jpeg_calc_output_dimensions(&cinfo);
+    info->width = cinfo.output_width;
+    info->height = cinfo.output_height;
+    info->channels = cinfo.output_components;
+    info->compression_type = 0;
+    jpeg_destroy_decompress(&cinfo);
+    return 1;
+}
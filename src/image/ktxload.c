@@ -1,5 +1,6 @@
 #include "assets/image/imageload.h"
 #include "assets/error.h"
+#include "assets/allocator.h"
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
@@ -243,18 +244,18 @@ struct image* image_from_ktx(const unsigned char* data, size_t sz)
 
     /* Create image */
     const int level = 0; /* Load base mipmap */
-    struct image* im = calloc(1, sizeof(struct image));
+    struct image* im = asset_calloc(1, sizeof(struct image));
     im->width = (h->pixel_width  >> level);
     im->height = (h->pixel_height >> level);
     im->channels = h->gl_format == GL_RGB ? 3 : 4;
     if (h->gl_type != 0) {
         im->compression_type = 0;
         im->data_sz = im->width * im->height * im->channels * sizeof(unsigned char);
-        im->data = calloc(1, im->data_sz);
+        im->data = asset_calloc(1, im->data_sz);
     } else {
         im->compression_type = h->gl_internal_format;
         im->data_sz = image_size;
-        im->data = calloc(1, im->data_sz);
+        im->data = asset_calloc(1, im->data_sz);
     }
 
     /* Copy image data */
@@ -262,3 +263,21 @@ struct image* image_from_ktx(const unsigned char* data, size_t sz)
 
     return im;
 }
+
+int image_info_from_ktx(const unsigned char* data, size_t sz, struct image_info* info)
+{
+    const struct ktx_header* h = (const struct ktx_header*)data;
+    if (sz < sizeof(struct ktx_header) || !is_ktx(data)) {
+        set_last_asset_load_error("Ktx identifier mismatch");
+        return 0;
+    }
+    if (h->endianness != 0x04030201) {
+        set_last_asset_load_error("Mismatching endianness!");
+        return 0;
+    }
+    info->width = h->pixel_width;
+    info->height = h->pixel_height;
+    info->channels = h->gl_format == GL_RGB ? 3 : 4;
+    info->compression_type = h->gl_type != 0 ? 0 : (int)h->gl_internal_format;
+    return 1;
+}
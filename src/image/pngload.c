@@ -2,6 +2,7 @@
 #include "assets/error.h"
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
 #include <assert.h>
 #include <png.h>
 
@@ -14,8 +15,22 @@ struct png_read_callback_data {
 /* Custom read function for reading from memory buffer */
 void png_read_callback_fn(png_struct* png, png_byte* data, png_size_t length) {
     struct png_read_callback_data* cbdata = (struct png_read_callback_data*) png_get_io_ptr(png);
+    if (length > cbdata->sz)
+        png_error(png, "Unexpected end of png data");
     memcpy(data, cbdata->src_buf, length);
     cbdata->src_buf += length;
+    cbdata->sz -= length;
+}
+
+static void png_error_callback_fn(png_struct* png, const char* msg) {
+    set_last_asset_load_error(msg);
+    png_longjmp(png, 1);
+}
+
+static void png_warning_callback_fn(png_struct* png, const char* msg) {
+    /* Drop warnings instead of printing them to stderr */
+    (void) png;
+    (void) msg;
 }
 
 struct image* image_from_png(const unsigned char* data, size_t sz) {
@@ -26,10 +41,21 @@ struct image* image_from_png(const unsigned char* data, size_t sz) {
     }
 
     /* Allocate needed structures */
-    png_struct* png = png_create_read_struct(PNG_LIBPNG_VER_STRING, 0, 0, 0);
+    png_struct* png = png_create_read_struct(PNG_LIBPNG_VER_STRING, 0, png_error_callback_fn, png_warning_callback_fn);
     png_info* info = png_create_info_struct(png);
     png_info* end_info = png_create_info_struct(png);
 
+    /* Image to be returned, volatile as it is read after a longjmp */
+    struct image* volatile im = 0;
+    png_byte** volatile row_ptrs = 0;
+    if (setjmp(png_jmpbuf(png))) {
+        free(row_ptrs);
+        if (im)
+            image_delete(im);
+        png_destroy_read_struct(&png, &info, &end_info);
+        return 0;
+    }
+
     /* Register custom reader function */
     struct png_read_callback_data cbdata;
     cbdata.src_buf = (unsigned char*)data;
@@ -79,11 +105,11 @@ struct image* image_from_png(const unsigned char* data, size_t sz) {
     int channels = png_get_channels(png, info);
     assert(channels == 4);
 
-    /* Image to be returned */
-    struct image* im = image_blank(width, height, channels);
+    /* Allocate the image */
+    im = image_blank(width, height, channels);
 
     /* Read by row */
-    png_byte** row_ptrs = malloc(height * sizeof(png_byte*));
+    row_ptrs = malloc(height * sizeof(png_byte*));
     const size_t stride = png_get_rowbytes(png, info);
     for (int i = 0; i < height; ++i) {
         int q = (height - i - 1) * stride;
@@ -98,3 +124,25 @@ struct image* image_from_png(const unsigned char* data, size_t sz) {
     /* Return read image */
     return im;
 }
+
+int image_info_from_png(const unsigned char* data, size_t sz, struct image_info* info) {
+    /* Signature followed by the IHDR chunk: length, type, width, height, ... */
+    if (sz < 8 + 8 + 13 || png_sig_cmp(data, 0, 8) || memcmp(data + 12, "IHDR", 4) != 0) {
+        set_last_asset_load_error("Incorrect png header");
+        return 0;
+    }
+    const unsigned char* ihdr = data + 16;
+    uint32_t width  = ((uint32_t)ihdr[0] << 24) | (ihdr[1] << 16) | (ihdr[2] << 8) | ihdr[3];
+    uint32_t height = ((uint32_t)ihdr[4] << 24) | (ihdr[5] << 16) | (ihdr[6] << 8) | ihdr[7];
+    /* The format caps dimensions at 2^31 - 1 */
+    if (width > INT32_MAX || height > INT32_MAX) {
+        set_last_asset_load_error("Incorrect png header");
+        return 0;
+    }
+    info->width  = (int)width;
+    info->height = (int)height;
+    /* The loader expands every color type to 8 bit RGBA */
+    info->channels = 4;
+    info->compression_type = 0;
+    return 1;
+}
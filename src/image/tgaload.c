@@ -150,3 +150,28 @@ struct image* image_from_tga(const unsigned char* data, size_t sz) {
     /* Return loaded image */
     return im;
 }
+
+int image_info_from_tga(const unsigned char* data, size_t sz, struct image_info* info) {
+    if (sz < 18)
+        return 0;
+
+    /* Parse the fields the loader relies on */
+    struct tga_header header;
+    memset(&header, 0, sizeof(struct tga_header));
+    unsigned char* begin = (unsigned char*)data;
+    parse_field(data_type_code, 2)
+    parse_field(width, 12)
+    parse_field(height, 14)
+    parse_field(bits_per_pixel, 16)
+
+    /* Same guard as the loader */
+    if (header.data_type_code != TGA_DATA_TYPE_RGB
+     && header.data_type_code != TGA_DATA_TYPE_RLE_RGB)
+        return 0;
+
+    info->width = header.width;
+    info->height = header.height;
+    info->channels = header.bits_per_pixel / 8;
+    info->compression_type = 0;
+    return 1;
+}
@@ -1,4 +1,6 @@
 #include "assets/image/imageload.h"
+#include "assets/error.h"
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
@@ -16,7 +18,9 @@ tsize_t tiff_read_cb(thandle_t handle, tdata_t buf, tsize_t sz)
     struct tiff_callback_data* cbdata = (struct tiff_callback_data*) handle;
     /* Read sz data to buf from cbdata->src */
     tsize_t available = (cbdata->src + cbdata->size) - cbdata->cur_pos;
-    assert(sz <= available);
+    /* Short read on truncated data, libtiff reports it as an error */
+    if (sz > available)
+        sz = available > 0 ? available : 0;
     memcpy(buf, cbdata->cur_pos, sz);
     cbdata->cur_pos += sz;
     return sz;
@@ -66,11 +70,22 @@ static void tiff_warn_handler(thandle_t th, const char* module, const char* fmt,
     (void) args;
 }
 
+static void tiff_error_handler(thandle_t th, const char* module, const char* fmt, va_list args)
+{
+    (void) th;
+    (void) module;
+    char msg[256];
+    vsnprintf(msg, sizeof(msg), fmt, args);
+    set_last_asset_load_error(msg);
+}
+
 struct image* image_from_tiff(const unsigned char* data, size_t sz)
 {
-    /* Set warning handler */
+    /* Set warning and error handlers */
     TIFFSetWarningHandler(0); /* Remove default first */
     TIFFSetWarningHandlerExt(tiff_warn_handler);
+    TIFFSetErrorHandler(0);
+    TIFFSetErrorHandlerExt(tiff_error_handler);
 
     /* Fill read callback info */
     struct tiff_callback_data cbdata;
@@ -88,6 +103,8 @@ struct image* image_from_tiff(const unsigned char* data, size_t sz)
         tiff_close_cb,
         tiff_sz_cb,
         0, 0);
+    if (!tif)
+        return 0;
 
     int width;
     int height;
@@ -95,8 +112,49 @@ struct image* image_from_tiff(const unsigned char* data, size_t sz)
     TIFFGetField(tif, TIFFTAG_IMAGELENGTH, &height);
 
     struct image* im = image_blank(width, height, 4);
-    TIFFReadRGBAImage(tif, width, height, (uint32*)im->data, 0);
+    if (!TIFFReadRGBAImage(tif, width, height, (uint32*)im->data, 0)) {
+        image_delete(im);
+        im = 0;
+    }
 
     TIFFClose(tif);
     return im;
 }
+
+int image_info_from_tiff(const unsigned char* data, size_t sz, struct image_info* info)
+{
+    TIFFSetWarningHandler(0);
+    TIFFSetWarningHandlerExt(tiff_warn_handler);
+    TIFFSetErrorHandler(0);
+    TIFFSetErrorHandlerExt(tiff_error_handler);
+
+    struct tiff_callback_data cbdata;
+    cbdata.src = (unsigned char*) data;
+    cbdata.cur_pos = cbdata.src;
+    cbdata.size = sz;
+
+    /* Opening reads the header and the first directory only */
+    TIFF* tif = TIFFClientOpen(
+        "MemBuf", "rm",
+        (thandle_t)&cbdata,
+        tiff_read_cb,
+        tiff_write_cb,
+        tiff_seek_cb,
+        tiff_close_cb,
+        tiff_sz_cb,
+        0, 0);
+    if (!tif)
+        return 0;
+
+    uint32_t width = 0, height = 0;
+    TIFFGetField(tif, TIFFTAG_IMAGEWIDTH, &width);
+    TIFFGetField(tif, TIFFTAG_IMAGELENGTH, &height);
+    TIFFClose(tif);
+
+    info->width = width;
+    info->height = height;
+    /* The loader always decodes to RGBA */
+    info->channels = 4;
+    info->compression_type = 0;
+    return 1;
+}
@@ -4,6 +4,9 @@
 #include <string.h>
 #include <assert.h>
 #include <zlib.h>
+#include "assets/allocator.h"
+#include "../stats.h"
+#include "../threadpool.h"
 
 /*-----------------------------------------------------------------
  * Helpers
@@ -170,11 +173,32 @@ void fbx_record_pretty_print(struct fbx_record* rec, int depth)
     }
 }
 
+/* FNV-1a */
+static uint32_t fbx_name_hash(const char* name, size_t len)
+{
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; ++i) {
+        h ^= (unsigned char)name[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
 struct fbx_record* fbx_find_subrecord_with_name(struct fbx_record* rec, const char* name)
 {
+    uint32_t h = fbx_name_hash(name, strlen(name));
+    if (rec->index) {
+        struct fbx_child_index* idx = rec->index;
+        for (uint32_t i = h & idx->mask; idx->slots[i].name; i = (i + 1) & idx->mask) {
+            struct fbx_child_slot* sl = idx->slots + i;
+            if (sl->hash == h && strcmp(sl->name, name) == 0)
+                return sl->first;
+        }
+        return 0;
+    }
     struct fbx_record* r = rec->subrecords;
     while (r) {
-        if (strcmp(r->name, name) == 0) {
+        if (r->name_hash == h && strcmp(r->name, name) == 0) {
             return r;
         }
         r = r->next;
@@ -184,9 +208,12 @@ struct fbx_record* fbx_find_subrecord_with_name(struct fbx_record* rec, const ch
 
 struct fbx_record* fbx_find_sibling_with_name(struct fbx_record* rec, const char* name)
 {
+    if (strcmp(rec->name, name) == 0)
+        return rec->next_same;
+    uint32_t h = fbx_name_hash(name, strlen(name));
     struct fbx_record* r = rec->next;
     while (r) {
-        if (strcmp(r->name, name) == 0) {
+        if (r->name_hash == h && strcmp(r->name, name) == 0) {
             return r;
         }
         r = r->next;
@@ -199,6 +226,7 @@ struct fbx_record* fbx_find_sibling_with_name(struct fbx_record* rec, const char
  *-----------------------------------------------------------------*/
 static int fbx_array_decompress(const void* src, int srclen, void* dst, int dstlen)
 {
+    uint64_t t0 = stats_phase_begin();
     int err = -1, ret = -1;
     z_stream strm;
     memset(&strm, 0, sizeof(strm));
@@ -220,9 +248,47 @@ static int fbx_array_decompress(const void* src, int srclen, void* dst, int dstl
     }
 
     inflateEnd(&strm);
+    stats_phase_end(ASSET_PHASE_DECOMPRESS, t0);
     return ret; /* -1 or len of input */
 }
 
+static void fbx_property_inflate(struct fbx_property* prop)
+{
+    if (fbx_array_decompress(prop->enc_data, prop->enc_len, prop->data.p, prop->length) != (int)prop->length)
+        memset(prop->data.p, 0, prop->length);
+    prop->enc_data = 0;
+}
+
+void* fbx_property_array(struct fbx_property* prop)
+{
+    if (prop->enc_data)
+        fbx_property_inflate(prop);
+    return prop->data.p;
+}
+
+static void fbx_inflate_task(void* arg, size_t begin, size_t end)
+{
+    struct fbx_property** props = arg;
+    for (size_t i = begin; i < end; ++i)
+        if (props[i] && props[i]->enc_data)
+            fbx_property_inflate(props[i]);
+}
+
+/* Below this much deflated data inflation stays on the calling thread */
+#define FBX_PARALLEL_INFLATE_MIN_SZ (256 * 1024)
+
+void fbx_inflate_properties(struct fbx_property** props, size_t num_props)
+{
+    size_t total = 0;
+    for (size_t i = 0; i < num_props; ++i)
+        if (props[i] && props[i]->enc_data)
+            total += props[i]->enc_len;
+    if (total >= FBX_PARALLEL_INFLATE_MIN_SZ)
+        tp_ensure_started();
+    /* Destinations are reserved at parse time, so workers never allocate */
+    tp_parallel_for(num_props, 1, fbx_inflate_task, props);
+}
+
 /*-----------------------------------------------------------------
  * Parsing
  *-----------------------------------------------------------------*/
@@ -244,8 +310,67 @@ int fbx_read_header(struct parser_state* ps, struct fbx_file* fbx)
     return 0;
 }
 
-static struct fbx_property fbx_read_property(struct parser_state* ps)
+/* Parse time state, the interned name table lives only while reading */
+struct fbx_reader {
+    struct parser_state* ps;
+    struct asset_arena* arena;
+    struct fbx_atom {
+        const char* name;
+        uint32_t hash;
+    }* atoms;
+    uint32_t atoms_mask;
+    uint32_t num_atoms;
+    /* Reused while linking the subrecords of each record */
+    struct fbx_link_slot {
+        const char* name;
+        uint32_t hash;
+        struct fbx_record* first;
+        struct fbx_record* last;
+    }* links;
+    uint32_t links_cap;
+};
+
+static void fbx_atoms_insert(struct fbx_atom* atoms, uint32_t mask, struct fbx_atom a)
+{
+    uint32_t i = a.hash & mask;
+    while (atoms[i].name)
+        i = (i + 1) & mask;
+    atoms[i] = a;
+}
+
+/* Returns the shared arena copy of given name */
+static const char* fbx_intern(struct fbx_reader* rd, const char* name, size_t len, uint32_t hash)
 {
+    for (uint32_t i = hash & rd->atoms_mask; rd->atoms[i].name; i = (i + 1) & rd->atoms_mask) {
+        const char* a = rd->atoms[i].name;
+        if (rd->atoms[i].hash == hash && strncmp(a, name, len) == 0 && a[len] == 0)
+            return a;
+    }
+
+    /* Keep load factor at most one half */
+    if ((rd->num_atoms + 1) * 2 > rd->atoms_mask + 1) {
+        uint32_t nmask = rd->atoms_mask * 2 + 1;
+        struct fbx_atom* natoms = calloc(nmask + 1, sizeof(struct fbx_atom));
+        for (uint32_t i = 0; i <= rd->atoms_mask; ++i)
+            if (rd->atoms[i].name)
+                fbx_atoms_insert(natoms, nmask, rd->atoms[i]);
+        free(rd->atoms);
+        rd->atoms = natoms;
+        rd->atoms_mask = nmask;
+    }
+
+    char* a = asset_arena_alloc(rd->arena, len + 1);
+    memcpy(a, name, len);
+    a[len] = 0;
+    struct fbx_atom atom = { a, hash };
+    fbx_atoms_insert(rd->atoms, rd->atoms_mask, atom);
+    ++rd->num_atoms;
+    return a;
+}
+
+static struct fbx_property fbx_read_property(struct fbx_reader* rd)
+{
+    struct parser_state* ps = rd->ps;
     /* Read type */
     char tcode = *((char*)ps->cur);
     iterfw(sizeof(char));
@@ -305,10 +430,12 @@ static struct fbx_property fbx_read_property(struct parser_state* ps)
                 prop.length = fbx_pt_size(pt, arr_len);
                 prop.enc_arr = 0;
             } else {
-                prop.length = fbx_pt_size(pt, arr_len);;
-                prop.data.p = malloc(prop.length);
-                fbx_array_decompress(ps->cur, clen, prop.data.p, prop.length);
+                /* Only reserve the destination, inflation is deferred to first access */
+                prop.length = fbx_pt_size(pt, arr_len);
+                prop.data.p = asset_arena_alloc(rd->arena, prop.length);
                 prop.enc_arr = 1;
+                prop.enc_data = ps->cur;
+                prop.enc_len = clen;
                 /* Early return (different iterfw size) */
                 iterfw(clen);
                 return prop;
@@ -332,52 +459,112 @@ static struct fbx_property fbx_read_property(struct parser_state* ps)
     return prop;
 }
 
-static void fbx_record_init(struct fbx_record* fbxr)
+/* Padding block at end of each record */
+static unsigned char fbx_record_padding_block[13] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+
+/* Checks the name of the record starting at cur without reading it */
+static int fbx_record_name_in(const unsigned char* cur, const char* const* names)
 {
-    memset(fbxr, 0, sizeof(struct fbx_record));
+    uint8_t name_len = cur[3 * sizeof(uint32_t)];
+    const char* name = (const char*)cur + 3 * sizeof(uint32_t) + sizeof(uint8_t);
+    for (; *names; ++names)
+        if (strncmp(*names, name, name_len) == 0 && (*names)[name_len] == 0)
+            return 1;
+    return 0;
 }
 
-static void fbx_property_destroy(struct fbx_property* p)
+/* Jumps over the record starting at cur and all of its subrecords */
+static void fbx_skip_record(struct parser_state* ps)
 {
-    if ((p->type == fbx_pt_float_arr
-         || p->type == fbx_pt_double_arr
-         || p->type == fbx_pt_long_arr
-         || p->type == fbx_pt_int_arr
-         || p->type == fbx_pt_bool_arr) && p->enc_arr) {
-        free(p->data.p);
-    }
+    uint32_t end_off = *((uint32_t*)ps->cur);
+    ps->cur = (unsigned char*) ps->data + end_off;
 }
 
-void fbx_record_destroy(struct fbx_record* fbxr)
+/* Below this many subrecords lookups scan the list */
+#define FBX_INDEX_MIN_CHILDREN 8
+
+static struct fbx_record* fbx_record_alloc(struct fbx_reader* rd, uint32_t num_props)
 {
-    struct fbx_record* n = fbxr->subrecords;
-    while (n) {
-        struct fbx_record* next = n->next;
-        fbx_record_destroy(n);
-        n = next;
-    }
-    for (uint32_t i = 0; i < fbxr->num_props; ++i)
-        fbx_property_destroy(fbxr->properties + i);
-    free(fbxr->properties);
-    free(fbxr->name);
-    free(fbxr);
+    /* Record and its properties in one block */
+    struct fbx_record* rec = asset_arena_alloc(rd->arena, sizeof(struct fbx_record) + num_props * sizeof(struct fbx_property));
+    memset(rec, 0, sizeof(struct fbx_record));
+    rec->num_props = num_props;
+    rec->properties = (struct fbx_property*)(rec + 1);
+    return rec;
 }
 
-/* Padding block at end of each record */
-static unsigned char fbx_record_padding_block[13] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+/* Chains equally named subrecords in list order and indexes long lists by name */
+static void fbx_link_subrecords(struct fbx_reader* rd, struct fbx_record* rec, uint32_t num_children)
+{
+    if (num_children < FBX_INDEX_MIN_CHILDREN) {
+        /* Interned names compare by pointer */
+        for (struct fbx_record* r = rec->subrecords; r; r = r->next) {
+            struct fbx_record* s = r->next;
+            while (s && s->name != r->name)
+                s = s->next;
+            r->next_same = s;
+        }
+        return;
+    }
+
+    /* Gather first and last record of every name */
+    uint32_t cap = 1;
+    while (cap < num_children * 2)
+        cap <<= 1;
+    if (cap > rd->links_cap) {
+        free(rd->links);
+        rd->links = malloc(cap * sizeof(struct fbx_link_slot));
+        rd->links_cap = cap;
+    }
+    struct fbx_link_slot* links = rd->links;
+    memset(links, 0, cap * sizeof(struct fbx_link_slot));
+    uint32_t num_names = 0;
+    for (struct fbx_record* r = rec->subrecords; r; r = r->next) {
+        uint32_t i = r->name_hash & (cap - 1);
+        while (links[i].name && links[i].name != r->name)
+            i = (i + 1) & (cap - 1);
+        if (!links[i].name) {
+            links[i].name = r->name;
+            links[i].hash = r->name_hash;
+            links[i].first = r;
+            ++num_names;
+        } else {
+            links[i].last->next_same = r;
+        }
+        links[i].last = r;
+    }
+
+    /* Compact into the index kept with the document */
+    uint32_t icap = 1;
+    while (icap < num_names * 2)
+        icap <<= 1;
+    struct fbx_child_index* idx = asset_arena_alloc(rd->arena, sizeof(struct fbx_child_index) + icap * sizeof(struct fbx_child_slot));
+    idx->slots = (struct fbx_child_slot*)(idx + 1);
+    idx->mask = icap - 1;
+    memset(idx->slots, 0, icap * sizeof(struct fbx_child_slot));
+    for (uint32_t l = 0; l < cap; ++l) {
+        if (!links[l].name)
+            continue;
+        uint32_t i = links[l].hash & idx->mask;
+        while (idx->slots[i].name)
+            i = (i + 1) & idx->mask;
+        idx->slots[i].name = links[l].name;
+        idx->slots[i].hash = links[l].hash;
+        idx->slots[i].first = links[l].first;
+    }
+    rec->index = idx;
+}
 
-static struct fbx_record* fbx_read_record(struct parser_state* ps)
+static struct fbx_record* fbx_read_record(struct fbx_reader* rd, const char* const* keep)
 {
+    struct parser_state* ps = rd->ps;
+
     /* End Offset */
     uint32_t end_off = *((uint32_t*)ps->cur);
     iterfw(sizeof(uint32_t));
     if (end_off == 0)
         return 0;
 
-    /* Allocate record */
-    struct fbx_record* rec = malloc(sizeof(struct fbx_record));
-    fbx_record_init(rec);
-
     /* Properties */
     uint32_t num_props = *((uint32_t*)ps->cur); /* Num Properties */
     iterfw(sizeof(uint32_t));
@@ -385,33 +572,39 @@ static struct fbx_record* fbx_read_record(struct parser_state* ps)
     (void) prop_list_len;
     iterfw(sizeof(uint32_t));
 
+    /* Allocate record */
+    struct fbx_record* rec = fbx_record_alloc(rd, num_props);
+
     /* Name */
     uint8_t name_len = *((uint8_t*)ps->cur);
     iterfw(sizeof(uint8_t));
-    char* name = (char*) ps->cur;
+    const char* name = (const char*) ps->cur;
     iterfw(name_len);
-
-    rec->name = malloc(name_len * sizeof(char) + 1);
-    memcpy(rec->name, name, name_len);
-    rec->name[name_len] = 0;
+    rec->name_hash = fbx_name_hash(name, name_len);
+    rec->name = fbx_intern(rd, name, name_len, rec->name_hash);
 
     /* Read properties */
-    rec->num_props = num_props;
-    rec->properties = malloc(num_props * sizeof(struct fbx_property));
     for (unsigned int i = 0; i < num_props; ++i) {
-        struct fbx_property prop = fbx_read_property(ps);
+        struct fbx_property prop = fbx_read_property(rd);
         rec->properties[i] = prop;
     }
 
     /* If space remains till next entry it probably is a nested record */
     if (ps->cur < ps->data + end_off) {
+        uint32_t num_children = 0;
         while (ps->cur < ps->data + end_off - 13) {
-            struct fbx_record* sr = fbx_read_record(ps);
+            if (keep && !fbx_record_name_in(ps->cur, keep)) {
+                fbx_skip_record(ps);
+                continue;
+            }
+            struct fbx_record* sr = fbx_read_record(rd, 0);
             sr->next = rec->subrecords;
             rec->subrecords = sr;
+            ++num_children;
         }
         assert(memcmp(fbx_record_padding_block, ps->cur, 13) == 0 && "Padding block mismatch");
         ps->cur += 13;
+        fbx_link_subrecords(rd, rec, num_children);
     }
 
     /* Check for future possible errors */
@@ -422,19 +615,49 @@ static struct fbx_record* fbx_read_record(struct parser_state* ps)
     return rec;
 }
 
-struct fbx_record* fbx_read_root_record(struct parser_state* ps)
+static const char* const fbx_objects_name[] = { "Objects", 0 };
+
+struct fbx_record* fbx_read_root_record(struct parser_state* ps, struct fbx_file* fbx, const struct fbx_record_filter* filter)
 {
-    struct fbx_record* r = malloc(sizeof(struct fbx_record));
-    fbx_record_init(r);
-    r->name = malloc(5 * sizeof(char));
-    memcpy(r->name, "Root", 5);
-    struct fbx_record* sr = 0;
-    do {
-        sr = fbx_read_record(ps);
+    struct fbx_reader rd;
+    memset(&rd, 0, sizeof(rd));
+    rd.ps = ps;
+    rd.arena = asset_arena_create(0);
+    rd.atoms_mask = 255;
+    rd.atoms = calloc(rd.atoms_mask + 1, sizeof(struct fbx_atom));
+
+    struct fbx_record* r = fbx_record_alloc(&rd, 0);
+    r->name_hash = fbx_name_hash("Root", 4);
+    r->name = fbx_intern(&rd, "Root", 4, r->name_hash);
+    uint32_t num_children = 0;
+    for (;;) {
+        /* The null record closing the list has no name and is never skipped */
+        int is_null = *((uint32_t*)ps->cur) == 0;
+        if (filter && filter->top_level && !is_null && !fbx_record_name_in(ps->cur, filter->top_level)) {
+            fbx_skip_record(ps);
+            continue;
+        }
+        const char* const* keep = filter && !is_null && fbx_record_name_in(ps->cur, fbx_objects_name) ? filter->objects : 0;
+        struct fbx_record* sr = fbx_read_record(&rd, keep);
         if (!sr)
             break;
         sr->next = r->subrecords;
         r->subrecords = sr;
-    } while (sr);
+        ++num_children;
+    }
+    fbx_link_subrecords(&rd, r, num_children);
+
+    free(rd.atoms);
+    free(rd.links);
+    fbx->arena = rd.arena;
+    fbx->root = r;
     return r;
 }
+
+void fbx_file_destroy(struct fbx_file* fbx)
+{
+    if (fbx->arena)
+        asset_arena_destroy(fbx->arena);
+    fbx->arena = 0;
+    fbx->root = 0;
+}
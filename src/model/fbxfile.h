@@ -34,6 +34,8 @@
 #include <stdlib.h>
 #include <stdint.h>
 
+struct asset_arena;
+
 /*------------------------------------------*
  * Node Record Format                       |
  *------------------------------------------*
@@ -123,35 +125,65 @@ struct fbx_property {
     } data;
     uint32_t length;
     /* Indicates that current property was an encoded array,
-     * and that additional heap memory was allocated for its
-     * decoded data that must be freed later */
+     * decoded into the document arena */
     int enc_arr;
+    /* Deflated source of an encoded array still pending inflation,
+     * access the data through fbx_property_array until then */
+    const unsigned char* enc_data;
+    uint32_t enc_len;
+};
+
+/* Subrecords of a record by name */
+struct fbx_child_index {
+    struct fbx_child_slot {
+        const char* name;
+        uint32_t hash;
+        struct fbx_record* first;
+    }* slots;
+    uint32_t mask;
 };
 
 /* FBX Record */
 struct fbx_record {
-    char* name;
-    struct fbx_property* properties; /* Array of properties */
+    const char* name;                /* Interned, equal names share the pointer */
+    uint32_t name_hash;
     uint32_t num_props;
+    struct fbx_property* properties; /* Array of properties */
     struct fbx_record* subrecords;   /* Linked list of subrecords */
     struct fbx_record* next;         /* Next record in list */
+    struct fbx_record* next_same;    /* Next record in list with the same name */
+    struct fbx_child_index* index;   /* Null for short subrecord lists */
 };
 
 /* FBX File */
 struct fbx_file {
     unsigned int version;
     struct fbx_record* root;
+    struct asset_arena* arena; /* Backs the whole record tree */
+};
+
+/* Selects the records to parse, the rest are skipped whole by their end offset.
+ * Name lists are null terminated, a null list keeps every record of its level */
+struct fbx_record_filter {
+    const char* const* top_level; /* Children of the root */
+    const char* const* objects;   /* Children of the Objects record */
 };
 
 /*-----------------------------------------------------------------
  * Functions
  *-----------------------------------------------------------------*/
 int fbx_read_header(struct parser_state* ps, struct fbx_file* fbx);
-struct fbx_record* fbx_read_root_record(struct parser_state* ps);
-void fbx_record_destroy(struct fbx_record* fbxr);
+/* Reads the records passing filter, or all of them if null, into fbx->root allocated from fbx->arena */
+struct fbx_record* fbx_read_root_record(struct parser_state* ps, struct fbx_file* fbx, const struct fbx_record_filter* filter);
+/* Releases the record tree in one go */
+void fbx_file_destroy(struct fbx_file* fbx);
 struct fbx_record* fbx_find_subrecord_with_name(struct fbx_record* rec, const char* name);
 struct fbx_record* fbx_find_sibling_with_name(struct fbx_record* rec, const char* name);
 size_t fbx_pt_unit_size(enum fbx_pt pt);
+/* Array data of a property, encoded arrays are inflated on first access */
+void* fbx_property_array(struct fbx_property* prop);
+/* Inflates the given array properties in parallel, each may appear only once */
+void fbx_inflate_properties(struct fbx_property** props, size_t num_props);
 void fbx_record_print(struct fbx_record* rec, int depth);
 void fbx_record_pretty_print(struct fbx_record* rec, int depth);
 
@@ -1,5 +1,11 @@
 #include "assets/model/model.h"
+#include "assets/error.h"
+#include "assets/allocator.h"
+#include "assets/model/postprocess.h"
 #include "fbxfile.h"
+#include "weld.h"
+#include "../stats.h"
+#include "../threadpool.h"
 #define _DEBUG
 #include <stdlib.h>
 #include <string.h>
@@ -128,18 +134,18 @@ static inline int fbx_find_geom_props(struct fbx_record* geom, struct fbx_geom_p
     struct fbx_property* mats_mapping    = fbx_find_layer_property(geom, "LayerElementMaterial", "MappingInformationType");
 
     /* Store data */
-    gprops->verts.dp     = verts ? verts->data.dp : 0;
+    gprops->verts.dp     = verts ? fbx_property_array(verts) : 0;
     gprops->vu_sz        = fbx_pt_unit_size(verts->type);
-    gprops->indices      = indices->data.ip;
+    gprops->indices      = fbx_property_array(indices);
     gprops->num_indices  = indices->length / fbx_pt_unit_size(indices->type);
-    gprops->norms        = norms->data.dp;
+    gprops->norms        = fbx_property_array(norms);
     gprops->nm_mapping   = fbx_find_prop_mapping_type(norms_mapping);
     gprops->nm_reference = fbx_find_prop_reference_type(norms_reference);
-    gprops->uvs          = uvs ? uvs->data.dp : 0;
-    gprops->uv_idxs      = uv_idxs ? uv_idxs->data.ip : 0;
-    gprops->tangs        = tangents ? tangents->data.dp : 0;
-    gprops->bitangs      = binormals ? binormals->data.dp : 0;
-    gprops->mats         = mats ? mats->data.ip : 0;
+    gprops->uvs          = uvs ? fbx_property_array(uvs) : 0;
+    gprops->uv_idxs      = uv_idxs ? fbx_property_array(uv_idxs) : 0;
+    gprops->tangs        = tangents ? fbx_property_array(tangents) : 0;
+    gprops->bitangs      = binormals ? fbx_property_array(binormals) : 0;
+    gprops->mats         = mats ? fbx_property_array(mats) : 0;
     gprops->mt_mapping   = mats ? fbx_find_prop_mapping_type(mats_mapping) : MT_INVALID;
 
     return 0;
@@ -171,19 +177,6 @@ static inline void fbx_cpy_fa(float* dst, void* src, size_t len, size_t unit_sz)
     }
 }
 
-static size_t vertex_hash(hm_ptr key)
-{
-    struct vertex* v = (struct vertex*)hm_pcast(key);
-    return (size_t)((uint32_t)v->position[0]
-                  ^ (uint32_t)v->position[1]
-                  ^ (uint32_t)v->position[2]);
-}
-
-static int vertex_eql(hm_ptr k1, hm_ptr k2)
-{
-    return memcmp(hm_pcast(k1), hm_pcast(k2), sizeof(struct vertex)) == 0; /* Compare obj vertex index triplets */
-}
-
 static struct mesh* fbx_read_mesh(struct fbx_record* geom, int* indice_offset, int* tot_pols, int* mat_id, struct hashmap* vw_index)
 {
     /* Find needed data from geometry record */
@@ -199,19 +192,21 @@ static struct mesh* fbx_read_mesh(struct fbx_record* geom, int* indice_offset, i
     int stored_indices = gp.num_indices;
     int last_material = -1, cur_material = -1;
 
-    /* Allocate top limit */
-    mesh->vertices = realloc(mesh->vertices, stored_indices * sizeof(struct vertex));
-    /* TODO: Add capacity counter to avoid possible overflows */
-    mesh->indices = realloc(mesh->indices, stored_indices * 2 * sizeof(uint32_t));
-    memset(mesh->vertices, 0, stored_indices * sizeof(struct vertex));
+    /* Unique vertices are bounded by the remaining polygon vertices,
+     * indices grow when polygons with more than 3 vertices are split */
+    size_t max_verts = stored_indices - *indice_offset;
+    size_t idx_cap = max_verts + 2;
+    mesh->vertices = asset_realloc(mesh->vertices, max_verts * sizeof(struct vertex));
+    mesh->indices = asset_realloc(mesh->indices, idx_cap * sizeof(uint32_t));
     if (vw_index) {
-        mesh->weights = realloc(mesh->weights, stored_indices * sizeof(struct vertex_weight));
-        memset(mesh->weights, 0, stored_indices * sizeof(struct vertex_weight));
+        mesh->weights = asset_realloc(mesh->weights, max_verts * sizeof(struct vertex_weight));
+        memset(mesh->weights, 0, max_verts * sizeof(struct vertex_weight));
     }
 
-    /* Used to find and reuse indices of already stored vertices */
-    struct hashmap stored_vertices;
-    hashmap_init(&stored_vertices, vertex_hash, vertex_eql);
+    /* Used to find and reuse indices of already stored vertices,
+     * unique vertices are placed directly in the vertex array */
+    struct welder stored_vertices;
+    welder_init(&stored_vertices, max_verts, sizeof(struct vertex), mesh->vertices);
 
     /* Populate mesh */
     int fc = 0; /* Counter of vertices in running face */
@@ -270,26 +265,27 @@ static struct mesh* fbx_read_mesh(struct fbx_record* geom, int* indice_offset, i
         if (gp.uvs)
             fbx_cpy_fa(tv.uvs, gp.uvs + uv_ind * 2, 2, gp.vu_sz);
 
+        /* Room for this indice and a possible additional fan face */
+        if (mesh->num_indices + 3 > idx_cap) {
+            idx_cap *= 2;
+            mesh->indices = asset_realloc(mesh->indices, idx_cap * sizeof(uint32_t));
+        }
+
         /* Check if current vertex is already stored */
-        hm_ptr* stored_indice = hashmap_get(&stored_vertices, hm_cast(&tv));
-        if (stored_indice) {
-            mesh->indices[mesh->num_indices] = *(uint32_t*)stored_indice;
-        } else {
+        int is_new;
+        uint32_t nidx = welder_weld(&stored_vertices, &tv, &is_new);
+        /* Set indice */
+        mesh->indices[mesh->num_indices] = nidx;
+        if (is_new) {
             ++mesh->num_verts;
-            /* Store new vertice */
-            uint32_t nidx = mesh->num_verts - 1;
-            memcpy(mesh->vertices + nidx, &tv, sizeof(struct vertex));
-            /* Set indice */
-            mesh->indices[mesh->num_indices] = nidx;
-            /* Store vertex ptr to lookup table */
-            hashmap_put(&stored_vertices, hm_cast(mesh->vertices + nidx), hm_cast(nidx));
             /* Fill parallel vertex weight array with given vertex weights */
             if (vw_index) {
                 hm_ptr* p = hashmap_get(vw_index, pos_ind);
                 if (p) {
                     struct vertex_weight* tvw = mesh->weights + nidx;
                     struct vector* wlist = hm_pcast(*p);
-                    for (int i = 0; i < 4; ++i) {
+                    size_t num_weights = wlist->size < 4 ? wlist->size : 4;
+                    for (size_t i = 0; i < num_weights; ++i) {
                         struct fbx_vertex_weight* fbw = vector_at(wlist, i);
                         tvw->bone_ids[i] = fbw->bone_index;
                         tvw->bone_weights[i] = fbw->bone_weight;
@@ -320,146 +316,154 @@ static struct mesh* fbx_read_mesh(struct fbx_record* geom, int* indice_offset, i
     *indice_offset = -1;
 cleanup:
     *mat_id = cur_material;
-    hashmap_destroy(&stored_vertices);
+    welder_destroy(&stored_vertices);
+    mesh_shrink_to_fit(mesh);
     return mesh;
 }
 
 /*-----------------------------------------------------------------
  * Connections Index
  *-----------------------------------------------------------------*/
-struct fbx_conns_idx { struct hashmap index; struct hashmap rev_index; struct hashmap desc_index; };
+/* Connections of one direction in compressed sparse row form,
+ * neighbours of dense node n are ids[offsets[n]..offsets[n + 1]) */
+struct fbx_conn_adj {
+    int64_t* ids;      /* Neighbour ids, single allocation with offsets */
+    uint32_t* offsets; /* num_nodes + 1 entries */
+};
+
+struct fbx_conns_idx {
+    int64_t* node_ids;  /* Sorted distinct ids, position is the dense index */
+    uint32_t num_nodes;
+    struct fbx_conn_adj fw;  /* Child to parents */
+    struct fbx_conn_adj rev; /* Parent to children */
+    const char** descs; /* Connection description by dense child index */
+};
+
+/* Contiguous neighbour ids of a node */
+struct fbx_id_list { const int64_t* ids; size_t size; };
 
 static size_t id_hash(hm_ptr key) { return (size_t)key; }
 static int id_eql(hm_ptr k1, hm_ptr k2) { return k1 == k2; }
 
-static void fbx_build_connections_fw_index(struct fbx_record* connections, struct fbx_conns_idx* cidx)
+static int id_cmp(const void* a, const void* b)
 {
-    /* Allocate internal hashmap resources */
-    hashmap_init(&cidx->index, id_hash, id_eql);
-
-    /* Iterate through full connections list */
-    struct fbx_record* c = connections->subrecords;
-    while (c) {
-        int64_t child_id = c->properties[1].data.l;
-        int64_t parnt_id = c->properties[2].data.l;
-        /* Check if parent list exists, if not create a new one */
-        hm_ptr* p = hashmap_get(&cidx->index, child_id);
-        struct vector* plist = 0;
-        if (!p) {
-            plist = malloc(sizeof(struct vector));
-            vector_init(plist, sizeof(int64_t));
-            hashmap_put(&cidx->index, child_id, hm_cast(plist));
-        } else {
-            plist = (struct vector*)*p;
-        }
-        /* Put current pair */
-        vector_append(plist, &parnt_id);
-        /* Next */
-        c = c->next;
-    }
+    int64_t x = *(const int64_t*)a, y = *(const int64_t*)b;
+    return x < y ? -1 : x > y;
 }
 
-static void fbx_build_connections_rev_index(struct fbx_record* connections, struct fbx_conns_idx* cidx)
+/* Dense index of given id, or -1 if it takes part in no connection */
+static int64_t fbx_conn_node(struct fbx_conns_idx* cidx, int64_t id)
 {
-    /* Allocate internal hashmap resources */
-    hashmap_init(&cidx->rev_index, id_hash, id_eql);
-
-    /* Iterate through full connections list */
-    struct fbx_record* c = connections->subrecords;
-    while (c) {
-        int64_t child_id = c->properties[1].data.l;
-        int64_t parnt_id = c->properties[2].data.l;
-        /* Check if parent list exists, if not create a new one */
-        hm_ptr* p = hashmap_get(&cidx->rev_index, parnt_id);
-        struct vector* clist;
-        if (!p) {
-            clist = malloc(sizeof(struct vector));
-            vector_init(clist, sizeof(int64_t));
-            hashmap_put(&cidx->rev_index, parnt_id, hm_cast(clist));
-        } else {
-            clist = (struct vector*)*p;
-        }
-        /* Put current pair */
-        vector_append(clist, &child_id);
-        /* Next */
-        c = c->next;
+    size_t lo = 0, hi = cidx->num_nodes;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (cidx->node_ids[mid] < id)
+            lo = mid + 1;
+        else
+            hi = mid;
     }
+    return lo < cidx->num_nodes && cidx->node_ids[lo] == id ? (int64_t)lo : -1;
 }
 
-static void fbx_build_connections_desc_index(struct fbx_record* connections, struct fbx_conns_idx* cidx)
+/* Fills adjacency from edges given as (from, to) dense index pairs, keeping list order per node */
+static void fbx_build_conn_adj(struct fbx_conn_adj* adj, const struct fbx_conns_idx* cidx, const uint32_t* from, const uint32_t* to, size_t num_edges)
 {
-    /* Allocate internal hashmap resources */
-    hashmap_init(&cidx->desc_index, id_hash, id_eql);
-
-    /* Iterate through full connections list */
-    struct fbx_record* c = connections->subrecords;
-    while (c) {
-        int64_t child_id = c->properties[1].data.l;
-        const char* desc = 0;
-        if (c->num_props >= 4)
-            desc = c->properties[3].data.str;
-        hashmap_put(&cidx->desc_index, child_id, hm_cast(desc));
-        /* Next */
-        c = c->next;
-    }
+    size_t ids_sz = num_edges * sizeof(int64_t);
+    adj->ids = malloc(ids_sz + (cidx->num_nodes + 1) * sizeof(uint32_t));
+    adj->offsets = (uint32_t*)((unsigned char*)adj->ids + ids_sz);
+    memset(adj->offsets, 0, (cidx->num_nodes + 1) * sizeof(uint32_t));
+    for (size_t e = 0; e < num_edges; ++e)
+        ++adj->offsets[from[e] + 1];
+    for (uint32_t n = 0; n < cidx->num_nodes; ++n)
+        adj->offsets[n + 1] += adj->offsets[n];
+    /* Place with a running cursor per node, then shift the offsets back */
+    for (size_t e = 0; e < num_edges; ++e)
+        adj->ids[adj->offsets[from[e]]++] = cidx->node_ids[to[e]];
+    for (uint32_t n = cidx->num_nodes; n > 0; --n)
+        adj->offsets[n] = adj->offsets[n - 1];
+    adj->offsets[0] = 0;
 }
 
 static void fbx_build_connections_index(struct fbx_record* connections, struct fbx_conns_idx* cidx)
 {
-    fbx_build_connections_fw_index(connections, cidx);
-    fbx_build_connections_rev_index(connections, cidx);
-    fbx_build_connections_desc_index(connections, cidx);
-}
+    memset(cidx, 0, sizeof(struct fbx_conns_idx));
 
-static void id_free_iter_fn(hm_ptr key, hm_ptr value)
-{
-    (void)key;
-    struct vector* v = (struct vector*)hm_pcast(value);
-    vector_destroy(v);
-    free(v);
+    /* Gather every id taking part in a connection */
+    size_t num_conns = 0;
+    for (struct fbx_record* c = connections->subrecords; c; c = c->next)
+        ++num_conns;
+    if (num_conns == 0)
+        return;
+    int64_t* ids = malloc(2 * num_conns * sizeof(int64_t));
+    size_t n = 0;
+    for (struct fbx_record* c = connections->subrecords; c; c = c->next) {
+        ids[n++] = c->properties[1].data.l;
+        ids[n++] = c->properties[2].data.l;
+    }
+
+    /* Dense remap, sorted so lookups are a binary search */
+    qsort(ids, n, sizeof(int64_t), id_cmp);
+    size_t num_nodes = 0;
+    for (size_t i = 0; i < n; ++i)
+        if (num_nodes == 0 || ids[num_nodes - 1] != ids[i])
+            ids[num_nodes++] = ids[i];
+    cidx->node_ids = realloc(ids, num_nodes * sizeof(int64_t));
+    cidx->num_nodes = num_nodes;
+
+    /* Edges and descriptions, in connection list order */
+    uint32_t* childs = malloc(2 * num_conns * sizeof(uint32_t));
+    uint32_t* parnts = childs + num_conns;
+    cidx->descs = calloc(num_nodes + 1, sizeof(const char*));
+    size_t e = 0;
+    for (struct fbx_record* c = connections->subrecords; c; c = c->next, ++e) {
+        childs[e] = (uint32_t)fbx_conn_node(cidx, c->properties[1].data.l);
+        parnts[e] = (uint32_t)fbx_conn_node(cidx, c->properties[2].data.l);
+        cidx->descs[childs[e]] = c->num_props >= 4 ? c->properties[3].data.str : 0;
+    }
+    fbx_build_conn_adj(&cidx->fw, cidx, childs, parnts, num_conns);
+    fbx_build_conn_adj(&cidx->rev, cidx, parnts, childs, num_conns);
+    free(childs);
 }
 
 static void fbx_destroy_connections_index(struct fbx_conns_idx* cidx)
 {
-    /* Destroy description index */
-    hashmap_destroy(&cidx->desc_index);
-    /* Destroy forward index */
-    hashmap_iter(&cidx->index, id_free_iter_fn);
-    hashmap_destroy(&cidx->index);
-    /* Destroy reverse index */
-    hashmap_iter(&cidx->rev_index, id_free_iter_fn);
-    hashmap_destroy(&cidx->rev_index);
+    free(cidx->descs);
+    free(cidx->fw.ids);
+    free(cidx->rev.ids);
+    free(cidx->node_ids);
 }
 
-static int64_t fbx_get_first_connection_id(struct fbx_conns_idx* cidx, int64_t id)
+static struct fbx_id_list fbx_get_connection_ids(struct fbx_conns_idx* cidx, struct fbx_conn_adj* adj, int64_t id)
 {
-    int64_t pid = -1;
-    hm_ptr* p = hashmap_get(&cidx->index, id);
-    if (p) {
-        struct vector* par_list = (struct vector*)hm_pcast(*p);
-        pid = *(int64_t*)vector_at(par_list, 0);
+    struct fbx_id_list list = { 0, 0 };
+    int64_t n = fbx_conn_node(cidx, id);
+    if (n != -1) {
+        list.ids = adj->ids + adj->offsets[n];
+        list.size = adj->offsets[n + 1] - adj->offsets[n];
     }
-    return pid;
+    return list;
 }
 
-static struct vector* fbx_get_connection_ids(struct hashmap* index, int64_t id)
+static struct fbx_id_list fbx_get_parent_ids(struct fbx_conns_idx* cidx, int64_t id)
 {
-    hm_ptr* p = hashmap_get(index, id);
-    if (p) {
-        struct vector* list = (struct vector*)hm_pcast(*p);
-        return list;
-    }
-    return 0;
+    return fbx_get_connection_ids(cidx, &cidx->fw, id);
+}
+
+static struct fbx_id_list fbx_get_child_ids(struct fbx_conns_idx* cidx, int64_t id)
+{
+    return fbx_get_connection_ids(cidx, &cidx->rev, id);
+}
+
+static int64_t fbx_get_first_connection_id(struct fbx_conns_idx* cidx, int64_t id)
+{
+    struct fbx_id_list par_list = fbx_get_parent_ids(cidx, id);
+    return par_list.size ? par_list.ids[0] : -1;
 }
 
 static const char* fbx_get_connection_desc(struct fbx_conns_idx* cidx, int64_t id)
 {
-    hm_ptr* p = hashmap_get(&cidx->desc_index, id);
-    if (p) {
-        const char* desc = hm_pcast(*p);
-        return desc;
-    }
-    return 0;
+    int64_t n = fbx_conn_node(cidx, id);
+    return n != -1 ? cidx->descs[n] : 0;
 }
 
 /*-----------------------------------------------------------------
@@ -610,10 +614,10 @@ static int fbx_read_transform(struct fbx_indexes* indexes, int64_t mdl_id, mat4*
     while(cur_id) {
         /* Loop through parents */
         int found_parent_id = 0;
-        struct vector* par_list = fbx_get_connection_ids(&indexes->cidx.index, cur_id);
-        for (size_t i = 0; i < par_list->size; ++i) {
+        struct fbx_id_list par_list = fbx_get_parent_ids(&indexes->cidx, cur_id);
+        for (size_t i = 0; i < par_list.size; ++i) {
             /* Check if parent id is a model id */
-            int64_t cpid = *(int64_t*)vector_at(par_list, i);
+            int64_t cpid = par_list.ids[i];
             struct fbx_record* mdl = fbx_find_object_type_with_id(&indexes->objs_idx, model_node_name, cpid);
             if (mdl) {
                 vector_append(&chain, &cpid);
@@ -684,11 +688,11 @@ static int fbx_read_acn_transform(struct fbx_indexes* indexes, int64_t mdl_id, f
 {
     const char* acn_node_name = "AnimationCurveNode";
     /* Get child ids for current model node */
-    struct vector* acn_chld_node_ids = fbx_get_connection_ids(&indexes->cidx.rev_index, mdl_id);
+    struct fbx_id_list acn_chld_node_ids = fbx_get_child_ids(&indexes->cidx, mdl_id);
     /* Search which of them are the animation curve nodes we want */
     int filled = 0;
-    for (size_t i = 0; i < acn_chld_node_ids->size; ++i) {
-        int64_t chld_id = *(int64_t*)vector_at(acn_chld_node_ids, i);
+    for (size_t i = 0; i < acn_chld_node_ids.size; ++i) {
+        int64_t chld_id = acn_chld_node_ids.ids[i];
         struct fbx_record* rec = fbx_find_object_type_with_id(&indexes->objs_idx, acn_node_name, chld_id);
         if (!rec)
             continue;
@@ -738,13 +742,13 @@ static void fbx_build_vertex_weights_index(struct fbx_record* geom, struct fbx_r
 {
     const char* deformer_node_name = "Deformer";
     /* Search Deformer child tagged with "Skin" */
-    struct vector* geom_chld_ids = fbx_get_connection_ids(&indexes->cidx.rev_index, geom->properties[0].data.l);
-    if (!geom_chld_ids)
+    struct fbx_id_list geom_chld_ids = fbx_get_child_ids(&indexes->cidx, geom->properties[0].data.l);
+    if (!geom_chld_ids.size)
         return;
     /* Search for skin node id */
     int64_t geom_chld_id = -1;
-    for (size_t i = 0; i < geom_chld_ids->size; ++i) {
-        int64_t chld_id = *(int64_t*)vector_at(geom_chld_ids, i);
+    for (size_t i = 0; i < geom_chld_ids.size; ++i) {
+        int64_t chld_id = geom_chld_ids.ids[i];
         struct fbx_record* skin_node = fbx_find_object_type_with_id(&indexes->objs_idx, deformer_node_name, chld_id);
         if (skin_node && strncmp("Skin", skin_node->properties[2].data.str, 4) == 0) {
             geom_chld_id = chld_id;
@@ -757,17 +761,17 @@ static void fbx_build_vertex_weights_index(struct fbx_record* geom, struct fbx_r
     *weight_index = malloc(sizeof(struct hashmap));
     hashmap_init(*weight_index, id_hash, id_eql);
     /* Get Deformer::Skin's childs */
-    struct vector* skin_chld_ids = fbx_get_connection_ids(&indexes->cidx.rev_index, geom_chld_id);
-    for (size_t i = 0; i < skin_chld_ids->size; ++i) {
-        int64_t skin_chld_id = *(int64_t*)vector_at(skin_chld_ids, i);
+    struct fbx_id_list skin_chld_ids = fbx_get_child_ids(&indexes->cidx, geom_chld_id);
+    for (size_t i = 0; i < skin_chld_ids.size; ++i) {
+        int64_t skin_chld_id = skin_chld_ids.ids[i];
         struct fbx_record* cluster_node = fbx_find_object_type_with_id(&indexes->objs_idx, deformer_node_name, skin_chld_id);
         /* Check if current Deformer node is tagged with "Cluster" */
         if (cluster_node && strncmp("Cluster", cluster_node->properties[2].data.str, 7) == 0) {
             /* Get refering node */
-            struct vector* cluster_chld_ids = fbx_get_connection_ids(&indexes->cidx.rev_index, skin_chld_id);
+            struct fbx_id_list cluster_chld_ids = fbx_get_child_ids(&indexes->cidx, skin_chld_id);
             struct fbx_record* ref_bone = 0;
-            for (size_t i = 0; i < cluster_chld_ids->size; ++i) {
-                int64_t clust_chld_id = *(int64_t*)vector_at(cluster_chld_ids, i);
+            for (size_t i = 0; i < cluster_chld_ids.size; ++i) {
+                int64_t clust_chld_id = cluster_chld_ids.ids[i];
                 struct fbx_record* model_node = fbx_find_object_type_with_id(&indexes->objs_idx, "Model", clust_chld_id);
                 if (model_node) {
                     ref_bone = model_node;
@@ -779,21 +783,17 @@ static void fbx_build_vertex_weights_index(struct fbx_record* geom, struct fbx_r
                 /* Get referring bone index */
                 int joint_index = fbx_joint_index(objs, ref_bone->properties[0].data.l);
                 /* Search for weight and index lists */
-                struct fbx_record* r = cluster_node->subrecords;
-                struct fbx_property* weights = 0, *indexes = 0;
-                while (r) {
-                    if (strncmp("Weights", r->name, 7) == 0) {
-                        weights = r->properties + 0;
-                    } else if (strncmp("Indexes", r->name, 7) == 0) {
-                        indexes = r->properties + 0;
-                    }
-                    r = r->next;
-                }
+                struct fbx_record* wrec = fbx_find_subrecord_with_name(cluster_node, "Weights");
+                struct fbx_record* irec = fbx_find_subrecord_with_name(cluster_node, "Indexes");
+                struct fbx_property* weights = wrec ? wrec->properties + 0 : 0;
+                struct fbx_property* indexes = irec ? irec->properties + 0 : 0;
                 /* If both exist fill vertex weight hashmap with data */
                 if (weights && indexes) {
+                    const int32_t* idx_data = fbx_property_array(indexes);
+                    const double* w_data = fbx_property_array(weights);
                     for (unsigned int i = 0; i < indexes->length / fbx_pt_unit_size(indexes->type); ++i) {
-                        int64_t idx = indexes->data.ip[i];
-                        double w = weights->data.dp[i];
+                        int64_t idx = idx_data[i];
+                        double w = w_data[i];
                         /* Check if weight list exists, if not create a new one */
                         hm_ptr* p = hashmap_get(*weight_index, idx);
                         struct vector* wlist = 0;
@@ -843,11 +843,11 @@ static void fbx_find_materials_for_model(struct fbx_record* objs, struct fbx_con
     while (mat) {
         int64_t mat_id = mat->properties[0].data.l;
         /* Check if given model uses current material */
-        struct vector* par_list = fbx_get_connection_ids(&cidx->index, mat_id);
-        if (par_list) {
+        struct fbx_id_list par_list = fbx_get_parent_ids(cidx, mat_id);
+        if (par_list.size) {
             /* Search model id in material's parent list */
-            for (size_t i = 0; i < par_list->size; ++i) {
-                int64_t pid = *(int64_t*)vector_at(par_list, i);
+            for (size_t i = 0; i < par_list.size; ++i) {
+                int64_t pid = par_list.ids[i];
                 if (pid == mdl_id) {
                     vector_append(mat_ids, &mat_id);
                     break;
@@ -881,9 +881,9 @@ static struct model* fbx_read_model(struct fbx_record* obj, struct fbx_indexes*
 
         /* Create and append mesh group for current Model node */
         struct mesh_group* mgroup = mesh_group_new();
-        mgroup->name = strdup(mdl_node->properties[1].data.str);
+        mgroup->name = asset_strdup(mdl_node->properties[1].data.str);
         model->num_mesh_groups++;
-        model->mesh_groups = realloc(model->mesh_groups, model->num_mesh_groups * sizeof(struct mesh_group*));
+        model->mesh_groups = asset_realloc(model->mesh_groups, model->num_mesh_groups * sizeof(struct mesh_group*));
         model->mesh_groups[model->num_mesh_groups - 1] = mgroup;
 
         /* Create a list with the material ids */
@@ -903,13 +903,18 @@ static struct model* fbx_read_model(struct fbx_record* obj, struct fbx_indexes*
         int tot_pols = 0; /* Counter of polygons encountered so far */
         do {
             int mat_idx = -1;
+            uint64_t t0 = stats_phase_begin();
             struct mesh* nm = fbx_read_mesh(geom, &indice_offset, &tot_pols, &mat_idx, vw_index);
+            stats_phase_end(ASSET_PHASE_WELD, t0);
             if (nm) {
+                /* Reorder for post transform cache and vertex fetch locality */
+                mesh_optimize_vertex_cache(nm);
+                mesh_optimize_vertex_fetch(nm);
                 /* Assign group index */
                 nm->mgroup_idx = model->num_mesh_groups - 1;
                 /* Append new mesh */
                 model->num_meshes++;
-                model->meshes = realloc(model->meshes, model->num_meshes * sizeof(struct mesh*));
+                model->meshes = asset_realloc(model->meshes, model->num_meshes * sizeof(struct mesh*));
                 model->meshes[model->num_meshes - 1] = nm;
                 /* Check if a transform matrix is available and transform if appropriate */
                 if (mdl_node) {
@@ -997,13 +1002,13 @@ static int fbx_joint_index(struct fbx_record* objs, int64_t jnt_id)
 static int fbx_joint_parent_index(struct fbx_record* objs, struct fbx_indexes* indexes, int64_t child_id)
 {
     /* Get parent connection id */
-    struct vector* par_list = fbx_get_connection_ids(&indexes->cidx.index, child_id);
+    struct fbx_id_list par_list = fbx_get_parent_ids(&indexes->cidx, child_id);
     int64_t par_id = -1;
     int par_ofs = -1;
-    if (par_list) {
-        for (size_t i = 0; i < par_list->size; ++i) {
+    if (par_list.size) {
+        for (size_t i = 0; i < par_list.size; ++i) {
             /* Check if current parent id is a joint */
-            int64_t cpid = *(int64_t*)vector_at(par_list, i);
+            int64_t cpid = par_list.ids[i];
             struct fbx_record* mdl = fbx_find_object_type_with_id(&indexes->objs_idx, "Model", cpid);
             if (mdl) {
                 const char* type = mdl->properties[2].data.str;
@@ -1031,10 +1036,10 @@ static struct skeleton* fbx_read_skeleton(struct fbx_record* objs, struct fbx_in
     /* Joints */
     struct skeleton* skel = skeleton_new();
     skel->rest_pose->num_joints = jcount;
-    skel->rest_pose->joints = realloc(skel->rest_pose->joints, skel->rest_pose->num_joints * sizeof(struct joint));
+    skel->rest_pose->joints = asset_realloc(skel->rest_pose->joints, skel->rest_pose->num_joints * sizeof(struct joint));
     memset(skel->rest_pose->joints, 0, skel->rest_pose->num_joints * sizeof(struct joint));
     /* Joint names */
-    skel->joint_names = realloc(skel->joint_names, skel->rest_pose->num_joints * sizeof(char*));
+    skel->joint_names = asset_realloc(skel->joint_names, skel->rest_pose->num_joints * sizeof(char*));
     memset(skel->joint_names, 0, skel->rest_pose->num_joints * sizeof(char*));
     //printf("Num joints: %u\n", jcount);
 
@@ -1049,7 +1054,7 @@ static struct skeleton* fbx_read_skeleton(struct fbx_record* objs, struct fbx_in
             /* Copy joint name */
             const char* name = mdl->properties[1].data.str;
             size_t name_sz = strlen(name) * sizeof(char);
-            skel->joint_names[cur_joint_idx] = malloc(name_sz + 1);
+            skel->joint_names[cur_joint_idx] = asset_malloc(name_sz + 1);
             memcpy(skel->joint_names[cur_joint_idx], name, name_sz);
             *(skel->joint_names[cur_joint_idx] + name_sz) = 0;
             /* Set joint parent */
@@ -1278,18 +1283,13 @@ static int fbx_find_num_frames(struct fbx_record* objs)
     /* Iterate through all AnimationCurve object nodes */
     struct fbx_record* anim_curve = fbx_find_subrecord_with_name(objs, anim_curve_node_name);
     while (anim_curve) {
-        /* Iterate through subproperties */
-        struct fbx_record* p = anim_curve->subrecords;
-        while (p) {
-            if (strcmp(p->name, "KeyTime") == 0) {
-                struct fbx_property* prop = p->properties + 0;
-                int num_frames = prop->length / fbx_pt_unit_size(prop->type);
-                /* Set new max */
-                if (num_frames > max_num_frames)
-                    max_num_frames = num_frames;
-                break;
-            }
-            p = p->next;
+        struct fbx_record* p = fbx_find_subrecord_with_name(anim_curve, "KeyTime");
+        if (p) {
+            struct fbx_property* prop = p->properties + 0;
+            int num_frames = prop->length / fbx_pt_unit_size(prop->type);
+            /* Set new max */
+            if (num_frames > max_num_frames)
+                max_num_frames = num_frames;
         }
         /* Process next anim curve node */
         anim_curve = fbx_find_sibling_with_name(anim_curve, anim_curve_node_name);
@@ -1297,103 +1297,150 @@ static int fbx_find_num_frames(struct fbx_record* objs)
     return max_num_frames;
 }
 
-static float fbx_calc_anim_curv_value(struct fbx_record* anim_curv_node, int cur_frame, int max_frames, float framerate)
-{
-    struct fbx_property* key_value = 0;
-    struct fbx_property* key_time = 0;
-    /* Gather the two relevant properties */
-    struct fbx_record* p = anim_curv_node->subrecords;
-    while (p) {
-        if (strcmp("KeyValueFloat", p->name) == 0) {
-            key_value = p->properties + 0;
-        } else if (strcmp("KeyTime", p->name) == 0) {
-            key_time = p->properties + 0;
-        }
-        p = p->next;
-    }
+/* Animation curve with its keys resolved once, read only while sampling */
+struct fbx_anim_curve {
+    float* times; /* Key times in seconds */
+    const float* values;
+    size_t num_keys;
+};
 
-    /* Calc the corresponding value */
-    float frame_time = 1.0f / framerate;
-    size_t key_time_arr_sz = key_time->length / fbx_pt_unit_size(key_time->type);
-    float cur_frame_perc = ((float)cur_frame / max_frames);
-    float cur_ideal_time = cur_frame * frame_time;
-    /* Initial value by lerp */
-    size_t key_time_idx = (key_time_arr_sz - 1) * cur_frame_perc;
-    int found = 0;
-    do {
-        /* Reached one of the boundaries */
-        if (key_time_idx == 0 || key_time_idx == key_time_arr_sz - 1)
-            break;
-        /* Calc distances */
-        found = 1;
-        float cur_distance = fabs(convert_fbx_time(key_time->data.lp[key_time_idx]) - cur_ideal_time);
-        float next_distance = fabs(convert_fbx_time(key_time->data.lp[key_time_idx + 1]) - cur_ideal_time);
-        float prev_distance = fabs(convert_fbx_time(key_time->data.lp[key_time_idx - 1]) - cur_ideal_time);
-        /* Check immediate right and immediate left distances */
-        if (next_distance < cur_distance) {
-            ++key_time_idx;
-            found = 0;
-        } else if (prev_distance < cur_distance) {
-            --key_time_idx;
-            found = 0;
-        }
-    } while (!found);
+/* Animated channels and rest transform of a joint */
+struct fbx_joint_anim {
+    const struct fbx_anim_curve* curves[3][3]; /* T, R, S curves by X, Y, Z */
+    int filled; /* Bitflag of components driven by a curve node */
+    float t[3], r[3], s[3];
+    int rot_active;
+    float pre_rot[3];
+    int parent;
+};
+
+struct fbx_sample_job {
+    struct frameset* fset;
+    struct fbx_joint_anim* joints;
+    float framerate;
+};
 
-    /* Fetch value for given index */
-    float value = key_value->data.fp[key_time_idx];
-    return value;
+/* Below this many joint samples frames are sampled on the calling thread */
+#define FBX_PARALLEL_SAMPLE_MIN 4096
+/* Joint samples each parallel task covers at least */
+#define FBX_SAMPLE_TASK_MIN 1024
+
+static void fbx_resolve_anim_curve(struct fbx_record* anim_curve, struct fbx_anim_curve* c)
+{
+    struct fbx_record* kv = fbx_find_subrecord_with_name(anim_curve, "KeyValueFloat");
+    struct fbx_record* kt = fbx_find_subrecord_with_name(anim_curve, "KeyTime");
+    memset(c, 0, sizeof(struct fbx_anim_curve));
+    if (!kv || !kt)
+        return;
+    struct fbx_property* key_value = kv->properties + 0;
+    struct fbx_property* key_time = kt->properties + 0;
+    size_t num_times = key_time->length / fbx_pt_unit_size(key_time->type);
+    size_t num_values = key_value->length / fbx_pt_unit_size(key_value->type);
+    c->num_keys = num_times < num_values ? num_times : num_values;
+    c->values = fbx_property_array(key_value);
+    const int64_t* key_times = fbx_property_array(key_time);
+    c->times = malloc(c->num_keys * sizeof(float));
+    for (size_t k = 0; k < c->num_keys; ++k)
+        c->times[k] = convert_fbx_time(key_times[k]);
 }
 
-/* Returns bitflag of components filled */
-static int fbx_read_frame_transform(struct fbx_indexes* indexes, int mdl_id, int cur_frame, int max_frames, float framerate, float t[3], float r[3], float s[3])
+/* Linear interpolation at time t, cursor only moves forward so increasing times sample in O(1) */
+static float fbx_sample_anim_curve(const struct fbx_anim_curve* c, size_t* cursor, float t)
+{
+    size_t k = *cursor;
+    while (k + 1 < c->num_keys && c->times[k + 1] <= t)
+        ++k;
+    *cursor = k;
+    if (k + 1 >= c->num_keys || t <= c->times[k])
+        return c->values[k];
+    float a = (t - c->times[k]) / (c->times[k + 1] - c->times[k]);
+    return c->values[k] + (c->values[k + 1] - c->values[k]) * a;
+}
+
+/* Binds the curves driving given joint model node */
+static void fbx_resolve_joint_curves(struct fbx_indexes* indexes, struct hashmap* curves, int64_t mdl_id, struct fbx_joint_anim* ja)
 {
-    /* Result bitflag */
-    int components_filled = 0;
     /* Get AnimationCurveNode childs of model node */
-    struct vector* mdl_chld_ids = fbx_get_connection_ids(&indexes->cidx.rev_index, mdl_id);
-    for (size_t i = 0; i < mdl_chld_ids->size; ++i) {
-        int64_t mdl_chld_id = *(int64_t*)vector_at(mdl_chld_ids, i);
+    struct fbx_id_list mdl_chld_ids = fbx_get_child_ids(&indexes->cidx, mdl_id);
+    if (!mdl_chld_ids.size)
+        return;
+    for (size_t i = 0; i < mdl_chld_ids.size; ++i) {
+        int64_t mdl_chld_id = mdl_chld_ids.ids[i];
         struct fbx_record* rec = fbx_find_object_type_with_id(&indexes->objs_idx, "AnimationCurveNode", mdl_chld_id);
-        if (rec) {
-            /* Select the transform component to fill */
-            const char* component_type = rec->properties[1].data.str;
-            size_t component_type_sz = rec->properties[1].length;
-            float* component_target = 0;
-            if (strncmp("T", component_type, component_type_sz) == 0) {
-                component_target = t;
-                components_filled |= (1 << 1);
-            }
-            else if (strncmp("R", component_type, component_type_sz) == 0) {
-                component_target = r;
-                components_filled |= (1 << 2);
-            }
-            else if (strncmp("S", component_type, component_type_sz) == 0) {
-                component_target = s;
-                components_filled |= (1 << 3);
-            }
+        if (!rec)
+            continue;
+        /* Select the transform component to fill */
+        const char* component_type = rec->properties[1].data.str;
+        size_t component_type_sz = rec->properties[1].length;
+        int comp = -1;
+        if (strncmp("T", component_type, component_type_sz) == 0)
+            comp = 0;
+        else if (strncmp("R", component_type, component_type_sz) == 0)
+            comp = 1;
+        else if (strncmp("S", component_type, component_type_sz) == 0)
+            comp = 2;
+        if (comp == -1)
+            continue;
+        ja->filled |= 1 << (comp + 1);
 
-            /* Find AnimationCurveNode's AnimationCurve childs */
-            struct vector* acn_chld_ids = fbx_get_connection_ids(&indexes->cidx.rev_index, mdl_chld_id);
-            for (size_t j = 0; j < acn_chld_ids->size; ++j) {
-                int64_t acn_chld_id = *(int64_t*)vector_at(acn_chld_ids, j);
-                /* Get child description */
-                const char* desc = fbx_get_connection_desc(&indexes->cidx, acn_chld_id);
-                int tidx = -1;
-                if (strncmp("d|X", desc, 3) == 0)
-                    tidx = 0;
-                else if (strncmp("d|Y", desc, 3) == 0)
-                    tidx = 1;
-                else if (strncmp("d|Z", desc, 3) == 0)
-                    tidx = 2;
-
-                if (tidx != -1) {
-                    struct fbx_record* anim_curve_node = fbx_find_object_with_id(&indexes->objs_idx, acn_chld_id);
-                    component_target[tidx] = fbx_calc_anim_curv_value(anim_curve_node, cur_frame, max_frames, framerate);
-                }
-            }
+        /* Find AnimationCurveNode's AnimationCurve childs */
+        struct fbx_id_list acn_chld_ids = fbx_get_child_ids(&indexes->cidx, mdl_chld_id);
+        if (!acn_chld_ids.size)
+            continue;
+        for (size_t j = 0; j < acn_chld_ids.size; ++j) {
+            int64_t acn_chld_id = acn_chld_ids.ids[j];
+            /* Get child description */
+            const char* desc = fbx_get_connection_desc(&indexes->cidx, acn_chld_id);
+            int tidx = -1;
+            if (strncmp("d|X", desc, 3) == 0)
+                tidx = 0;
+            else if (strncmp("d|Y", desc, 3) == 0)
+                tidx = 1;
+            else if (strncmp("d|Z", desc, 3) == 0)
+                tidx = 2;
+            hm_ptr* p = hashmap_get(curves, acn_chld_id);
+            if (tidx != -1 && p)
+                ja->curves[comp][tidx] = hm_pcast(*p);
+        }
+    }
+}
+
+static void fbx_sample_joints_task(void* arg, size_t begin, size_t end)
+{
+    struct fbx_sample_job* job = arg;
+    float frame_time = 1.0f / job->framerate;
+    for (size_t jnt = begin; jnt < end; ++jnt) {
+        struct fbx_joint_anim* ja = job->joints + jnt;
+        size_t cursors[3][3];
+        memset(cursors, 0, sizeof(cursors));
+        quat prq = quat_from_euler(vec3_new(radians(ja->pre_rot[1]),
+                                            radians(ja->pre_rot[0]),
+                                            radians(ja->pre_rot[2])));
+        /* Iterate through each frame */
+        for (size_t i = 0; i < job->fset->num_frames; ++i) {
+            struct joint* j = job->fset->frames[i]->joints + jnt;
+            float cur_time = i * frame_time;
+            float f[3][3] = {{0.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 0.0f}, {1.0f, 1.0f, 1.0f}};
+            for (int c = 0; c < 3; ++c)
+                for (int k = 0; k < 3; ++k)
+                    if (ja->curves[c][k] && ja->curves[c][k]->num_keys)
+                        f[c][k] = fbx_sample_anim_curve(ja->curves[c][k], &cursors[c][k], cur_time);
+            /* Fallback to local transform if a component had no frame transform */
+            const float* tt = ja->filled & (1 << 1) ? f[0] : ja->t;
+            const float* rr = ja->filled & (1 << 2) ? f[1] : ja->r;
+            const float* ss = ja->filled & (1 << 3) ? f[2] : ja->s;
+
+            quat rq = quat_from_euler(vec3_new(radians(rr[1]),
+                                               radians(rr[0]),
+                                               radians(rr[2])));
+            if (ja->rot_active)
+                rq = quat_mul_quat(prq, rq);
+            memcpy(j->position, tt, 3 * sizeof(float));
+            memcpy(j->rotation, &rq, 4 * sizeof(float));
+            memcpy(j->scaling, ss, 3 * sizeof(float));
+            j->parent = ja->parent == -1 ? 0 : job->fset->frames[i]->joints + ja->parent;
         }
     }
-    return components_filled;
 }
 
 static struct frameset* fbx_read_frames(struct fbx_record* objs, struct fbx_indexes* indexes, float framerate)
@@ -1401,7 +1448,7 @@ static struct frameset* fbx_read_frames(struct fbx_record* objs, struct fbx_inde
     /* Create empty frameset */
     struct frameset* fset = frameset_new();
     fset->num_frames = fbx_find_num_frames(objs);
-    fset->frames = malloc(fset->num_frames * sizeof(struct frame*));
+    fset->frames = asset_malloc(fset->num_frames * sizeof(struct frame*));
     memset(fset->frames, 0, fset->num_frames * sizeof(struct frame*));
 
     /* Prepopulate with empty frames */
@@ -1409,12 +1456,26 @@ static struct frameset* fbx_read_frames(struct fbx_record* objs, struct fbx_inde
     for (uint32_t i = 0; i < fset->num_frames; ++i) {
         struct frame* fr = frame_new();
         fr->num_joints = jcount;
-        fr->joints = realloc(fr->joints, fr->num_joints * sizeof(struct joint));
+        fr->joints = asset_realloc(fr->joints, fr->num_joints * sizeof(struct joint));
         memset(fr->joints, 0, fr->num_joints * sizeof(struct joint));
         fset->frames[i] = fr;
     }
 
+    /* Resolve every curve once */
+    size_t num_curves = 0;
+    struct fbx_record* anim_curve = fbx_find_subrecord_with_name(objs, "AnimationCurve");
+    for (struct fbx_record* ac = anim_curve; ac; ac = fbx_find_sibling_with_name(ac, "AnimationCurve"))
+        ++num_curves;
+    struct fbx_anim_curve* curves = malloc(num_curves * sizeof(struct fbx_anim_curve));
+    struct hashmap curve_index;
+    hashmap_init(&curve_index, id_hash, id_eql);
+    for (size_t i = 0; anim_curve; anim_curve = fbx_find_sibling_with_name(anim_curve, "AnimationCurve"), ++i) {
+        fbx_resolve_anim_curve(anim_curve, curves + i);
+        hashmap_put(&curve_index, anim_curve->properties[0].data.l, hm_cast(curves + i));
+    }
+
     /* Iterate joints type Model nodes */
+    struct fbx_joint_anim* joints = calloc(jcount ? jcount : 1, sizeof(struct fbx_joint_anim));
     const char* mdl_node_name = "Model";
     struct fbx_record* mdl = fbx_find_subrecord_with_name(objs, mdl_node_name);
     int cur_joint_idx = 0;
@@ -1422,51 +1483,110 @@ static struct frameset* fbx_read_frames(struct fbx_record* objs, struct fbx_inde
         int64_t mdl_id = mdl->properties[0].data.l;
         const char* type = mdl->properties[2].data.str;
         if (fbx_is_joint_type(type)) {
+            struct fbx_joint_anim* ja = joints + cur_joint_idx;
             /* Local Transforms */
-            float s[3] = {1.0f, 1.0f, 1.0f}, r[3] = {0.0f, 0.0f, 0.0f}, t[3] = {0.0f, 0.0f, 0.0f};
-            int rot_active = 0; float pre_rot[3] = {0.0f, 0.0f, 0.0f};
-            fbx_read_local_transform(mdl, t, r, s, &rot_active, pre_rot);
-            /* AnimationCurveNode transforms */
-            /*
-            float acn_s[3] = {1.0f, 1.0f, 1.0f}, acn_r[3] = {0.0f, 0.0f, 0.0f}, acn_t[3] = {0.0f, 0.0f, 0.0f};
-            fbx_read_acn_transform(objs_idx, cidx, mdl_id, acn_t, acn_r, acn_s);
-            */
+            ja->s[0] = ja->s[1] = ja->s[2] = 1.0f;
+            fbx_read_local_transform(mdl, ja->t, ja->r, ja->s, &ja->rot_active, ja->pre_rot);
             /* Get parent index */
-            int par_idx = fbx_joint_parent_index(objs, indexes, mdl_id);
-            /* Iterate through each frame */
-            for (uint32_t i = 0; i < fset->num_frames; ++i) {
-                struct joint* j = fset->frames[i]->joints + cur_joint_idx;
-                float fs[3] = {1.0f, 1.0f, 1.0f}, fr[3] = {0.0f, 0.0f, 0.0f}, ft[3] = {0.0f, 0.0f, 0.0f};
-                /* Fallback to local transform if a component had no frame transform */
-                int components_filled = fbx_read_frame_transform(indexes, mdl_id, i, fset->num_frames, framerate, ft, fr, fs);
-                float* ss = s; float* rr = r; float* tt = t;
-                if (components_filled & (1 << 1)) tt = ft;
-                if (components_filled & (1 << 2)) rr = fr;
-                if (components_filled & (1 << 3)) ss = fs;
-
-                quat rq = quat_from_euler(vec3_new(radians(rr[1]),
-                                                   radians(rr[0]),
-                                                   radians(rr[2])));
-                if (rot_active) {
-                    quat prq = quat_from_euler(vec3_new(radians(pre_rot[1]),
-                                                        radians(pre_rot[0]),
-                                                        radians(pre_rot[2])));
-                    rq = quat_mul_quat(prq, rq);
-                }
-                memcpy(j->position, tt, 3 * sizeof(float));
-                memcpy(j->rotation, &rq, 4 * sizeof(float));
-                memcpy(j->scaling, ss, 3 * sizeof(float));
-                j->parent = par_idx == -1 ? 0 : fset->frames[i]->joints + par_idx;
-            }
+            ja->parent = fbx_joint_parent_index(objs, indexes, mdl_id);
+            fbx_resolve_joint_curves(indexes, &curve_index, mdl_id, ja);
             ++cur_joint_idx;
         }
         /* Process next model node */
         mdl = fbx_find_sibling_with_name(mdl, mdl_node_name);
     }
 
+    /* Sample, each joint walks its own curves through all frames */
+    struct fbx_sample_job job;
+    job.fset = fset;
+    job.joints = joints;
+    job.framerate = framerate;
+    if (fset->num_frames * (size_t)cur_joint_idx >= FBX_PARALLEL_SAMPLE_MIN) {
+        tp_ensure_started();
+        size_t grain = fset->num_frames ? (FBX_SAMPLE_TASK_MIN + fset->num_frames - 1) / fset->num_frames : 1;
+        tp_parallel_for(cur_joint_idx, grain, fbx_sample_joints_task, &job);
+    } else {
+        fbx_sample_joints_task(&job, 0, cur_joint_idx);
+    }
+
+    free(joints);
+    hashmap_destroy(&curve_index);
+    for (size_t i = 0; i < num_curves; ++i)
+        free(curves[i].times);
+    free(curves);
     return fset;
 }
 
+/*-----------------------------------------------------------------
+ * Record filters
+ *-----------------------------------------------------------------*/
+/* Top level records any of the loaders read */
+static const char* const fbx_top_level_records[] = { "GlobalSettings", "Objects", "Connections", 0 };
+
+/* Objects read for a full model, textures, videos, poses and the like are skipped */
+static const char* const fbx_model_objects[] = {
+    "Model", "Geometry", "Deformer", "Material", "AnimationCurveNode", "AnimationCurve", 0
+};
+static const struct fbx_record_filter fbx_model_filter = { fbx_top_level_records, fbx_model_objects };
+
+/* Objects read for animation only, joints and their curves */
+static const char* const fbx_animation_objects[] = { "Model", "AnimationCurveNode", "AnimationCurve", 0 };
+static const struct fbx_record_filter fbx_animation_filter = { fbx_top_level_records, fbx_animation_objects };
+
+/*-----------------------------------------------------------------
+ * Array prefetch
+ *-----------------------------------------------------------------*/
+static void fbx_push_array(struct vector* props, struct fbx_property* p)
+{
+    if (p && p->enc_data)
+        vector_append(props, &p);
+}
+
+static void fbx_push_subrecord_array(struct vector* props, struct fbx_record* rec, const char* name)
+{
+    struct fbx_record* r = fbx_find_subrecord_with_name(rec, name);
+    if (r && r->num_props > 0)
+        fbx_push_array(props, r->properties + 0);
+}
+
+/* Inflates the arrays a load is going to read in one parallel pass,
+ * anything left out is still inflated lazily on first access */
+static void fbx_prefetch_arrays(struct fbx_record* objs, int geometry, int animation)
+{
+    struct vector props;
+    vector_init(&props, sizeof(struct fbx_property*));
+    if (geometry) {
+        struct fbx_record* geom = fbx_find_subrecord_with_name(objs, "Geometry");
+        while (geom) {
+            fbx_push_subrecord_array(&props, geom, "Vertices");
+            fbx_push_subrecord_array(&props, geom, "PolygonVertexIndex");
+            fbx_push_array(&props, fbx_find_layer_property(geom, "LayerElementNormal",   "Normals"));
+            fbx_push_array(&props, fbx_find_layer_property(geom, "LayerElementTangent",  "Tangents"));
+            fbx_push_array(&props, fbx_find_layer_property(geom, "LayerElementBinormal", "Binormals"));
+            fbx_push_array(&props, fbx_find_layer_property(geom, "LayerElementUV",       "UV"));
+            fbx_push_array(&props, fbx_find_layer_property(geom, "LayerElementUV",       "UVIndex"));
+            fbx_push_array(&props, fbx_find_layer_property(geom, "LayerElementMaterial", "Materials"));
+            geom = fbx_find_sibling_with_name(geom, "Geometry");
+        }
+        struct fbx_record* deformer = fbx_find_subrecord_with_name(objs, "Deformer");
+        while (deformer) {
+            fbx_push_subrecord_array(&props, deformer, "Weights");
+            fbx_push_subrecord_array(&props, deformer, "Indexes");
+            deformer = fbx_find_sibling_with_name(deformer, "Deformer");
+        }
+    }
+    if (animation) {
+        struct fbx_record* curve = fbx_find_subrecord_with_name(objs, "AnimationCurve");
+        while (curve) {
+            fbx_push_subrecord_array(&props, curve, "KeyTime");
+            fbx_push_subrecord_array(&props, curve, "KeyValueFloat");
+            curve = fbx_find_sibling_with_name(curve, "AnimationCurve");
+        }
+    }
+    fbx_inflate_properties((struct fbx_property**)props.data, props.size);
+    vector_destroy(&props);
+}
+
 /*-----------------------------------------------------------------
  * Constructor
  *-----------------------------------------------------------------*/
@@ -1485,13 +1605,12 @@ struct model* model_from_fbx(const unsigned char* data, size_t sz)
 
     /* Read header */
     if (!fbx_read_header(&ps, &fbx)) {
-        fprintf(stderr, "Not a fbx file!\n");
+        set_last_asset_load_error("Not a fbx file");
         return 0;
     }
 
     /* Parse fbx file */
-    struct fbx_record* r = fbx_read_root_record(&ps);
-    fbx.root = r;
+    fbx_read_root_record(&ps, &fbx, &fbx_model_filter);
 
     /* Build indexes */
     struct fbx_record* conns = fbx_find_subrecord_with_name(fbx.root, "Connections");
@@ -1504,6 +1623,9 @@ struct model* model_from_fbx(const unsigned char* data, size_t sz)
     struct fbx_transform_orientation gorient;
     fbx_global_orientation(gsettings, gorient.signs, gorient.indxs);
 
+    /* Inflate geometry, and animation when there is a skeleton to drive */
+    fbx_prefetch_arrays(objs, 1, fbx_joint_count(objs) > 0);
+
     /* Gather model data from parsed tree  */
     struct model* m = fbx_read_model(objs, &indexes);
 
@@ -1532,7 +1654,7 @@ struct model* model_from_fbx(const unsigned char* data, size_t sz)
     /* Free indexes */
     fbx_destroy_indexes(&indexes);
     /* Free tree */
-    fbx_record_destroy(r);
+    fbx_file_destroy(&fbx);
     return m;
 }
 
@@ -1551,13 +1673,12 @@ struct frameset* frameset_from_fbx(const unsigned char* data, size_t sz)
 
     /* Read header */
     if (!fbx_read_header(&ps, &fbx)) {
-        fprintf(stderr, "Not a fbx file!\n");
+        set_last_asset_load_error("Not a fbx file");
         return 0;
     }
 
     /* Parse fbx file */
-    struct fbx_record* r = fbx_read_root_record(&ps);
-    fbx.root = r;
+    fbx_read_root_record(&ps, &fbx, &fbx_animation_filter);
 
     /* Build indexes */
     struct fbx_record* conns = fbx_find_subrecord_with_name(fbx.root, "Connections");
@@ -1569,7 +1690,34 @@ struct frameset* frameset_from_fbx(const unsigned char* data, size_t sz)
     struct fbx_record* gsettings = fbx_find_subrecord_with_name(fbx.root, "GlobalSettings");
     float fr = fbx_framerate(gsettings);
 
+    /* Inflate the curves */
+    fbx_prefetch_arrays(objs, 0, 1);
+
     /* Gather animation frames */
     struct frameset* fset = fbx_read_frames(objs, &indexes, fr);
+
+    /* Free indexes and tree */
+    fbx_destroy_indexes(&indexes);
+    fbx_file_destroy(&fbx);
     return fset;
 }
+
+int model_info_from_fbx(const unsigned char* data, size_t sz, struct model_info* info)
+{
+    struct parser_state ps;
+    memset(&ps, 0, sizeof(struct parser_state));
+    ps.data = (unsigned char*) data;
+    ps.cur = (unsigned char*) data;
+    ps.bufend = (unsigned char*) data + sz;
+
+    /* Counts are only known after resolving the object graph,
+     * so this just validates the header */
+    struct fbx_file fbx;
+    memset(&fbx, 0, sizeof(struct fbx_file));
+    if (sz < 27 || !fbx_read_header(&ps, &fbx)) {
+        set_last_asset_load_error("Not a fbx file");
+        return 0;
+    }
+    (void) info;
+    return 1;
+}
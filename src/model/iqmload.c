@@ -1,8 +1,9 @@
 #include <assets/model/modelload.h>
+#include <assets/error.h>
+#include <assets/allocator.h>
 #include "iqmfile.h"
 #include <string.h>
 #include <stdlib.h>
-#include <stdio.h>
 #include <hashmap.h>
 #include <linalgb.h>
 #include <assert.h>
@@ -14,14 +15,14 @@ static struct frameset* iqm_read_frames(struct iqm_file* iqm)
     unsigned short* framedata = (unsigned short*)(base + h->ofs_frames);
     struct frameset* frameset = frameset_new();
 
-    struct frame** frames = malloc(h->num_frames * sizeof(struct frame*));
+    struct frame** frames = asset_malloc(h->num_frames * sizeof(struct frame*));
     memset(frames, 0, h->num_frames * sizeof(struct frame*));
 
     for (uint32_t i = 0; i < h->num_frames; ++i) {
         /* Setup empty frame */
         struct frame* f = frame_new();
         f->num_joints = h->num_poses;
-        f->joints = realloc(f->joints, f->num_joints * sizeof(struct joint));
+        f->joints = asset_realloc(f->joints, f->num_joints * sizeof(struct joint));
         memset(f->joints, 0, f->num_joints * sizeof(struct joint));
 
         for (uint32_t j = 0; j < h->num_poses; ++j) {
@@ -61,10 +62,10 @@ static struct skeleton* iqm_read_skeleton(struct iqm_file* iqm)
 
     /* Joints */
     skel->rest_pose->num_joints = h->num_joints;
-    skel->rest_pose->joints = realloc(skel->rest_pose->joints, skel->rest_pose->num_joints * sizeof(struct joint));
+    skel->rest_pose->joints = asset_realloc(skel->rest_pose->joints, skel->rest_pose->num_joints * sizeof(struct joint));
     memset(skel->rest_pose->joints, 0, skel->rest_pose->num_joints * sizeof(struct joint));
     /* Joint names */
-    skel->joint_names = realloc(skel->joint_names, skel->rest_pose->num_joints * sizeof(char*));
+    skel->joint_names = asset_realloc(skel->joint_names, skel->rest_pose->num_joints * sizeof(char*));
     memset(skel->joint_names, 0, skel->rest_pose->num_joints * sizeof(char*));
 
     for (uint32_t i = 0; i < h->num_joints; ++i) {
@@ -77,7 +78,7 @@ static struct skeleton* iqm_read_skeleton(struct iqm_file* iqm)
         /* Copy joint name */
         const char* name = (const char*)(base + h->ofs_text + joint->name);
         size_t name_sz = strlen(name) * sizeof(char);
-        skel->joint_names[i] = malloc(name_sz + 1);
+        skel->joint_names[i] = asset_malloc(name_sz + 1);
         memcpy(skel->joint_names[i], name, name_sz);
         *(skel->joint_names[i] + name_sz) = 0;
 
@@ -90,30 +91,21 @@ static struct skeleton* iqm_read_skeleton(struct iqm_file* iqm)
     return skel;
 }
 
-static struct mesh* iqm_read_mesh(struct iqm_file* iqm, uint32_t mesh_idx, uint32_t prev_verts_num)
+static void iqm_read_vertices(struct iqm_file* iqm, struct iqm_mesh* mesh, struct mesh* m)
 {
     /* Aliases */
     struct iqm_header* h = &iqm->header;
     unsigned char* base = iqm->base;
 
-    struct iqm_mesh* mesh = (struct iqm_mesh*)(base + h->ofs_meshes + mesh_idx * sizeof(struct iqm_mesh));
-    struct mesh* m = mesh_new();
-
     /* Allocate vertices */
-    m->num_verts = mesh->num_vertexes;
-    m->vertices = realloc(m->vertices, m->num_verts * sizeof(struct vertex));
+    m->vertices = asset_realloc(m->vertices, m->num_verts * sizeof(struct vertex));
     memset(m->vertices, 0, m->num_verts * sizeof(struct vertex));
 
-    /* Allocate indices */
-    m->num_indices = mesh->num_triangles * 3;
-    m->indices = realloc(m->indices, m->num_indices * sizeof(uint32_t));
-    memset(m->indices, 0, m->num_indices * sizeof(uint32_t));
-
     /* Check is mesh has bone weights and allocate space if needed */
     for (uint32_t j = 0; j < h->num_vertexarrays; ++j) {
         struct iqm_vertexarray* va = (struct iqm_vertexarray*)(base + h->ofs_vertexarrays) + j;
         if (va->type == IQM_BLENDINDEXES || va->type == IQM_BLENDWEIGHTS) {
-            m->weights = malloc(m->num_verts * sizeof(struct vertex_weight));
+            m->weights = asset_malloc(m->num_verts * sizeof(struct vertex_weight));
             break;
         }
     }
@@ -166,6 +158,81 @@ static struct mesh* iqm_read_mesh(struct iqm_file* iqm, uint32_t mesh_idx, uint3
             }
         }
     }
+}
+
+/* Writes the declared attributes of the mesh straight into its streams, skipping the other arrays */
+static void iqm_read_vertex_streams(struct iqm_file* iqm, struct iqm_mesh* mesh, uint32_t mesh_idx, struct mesh* m, const struct model_output* out)
+{
+    /* Aliases */
+    struct iqm_header* h = &iqm->header;
+    unsigned char* base = iqm->base;
+    const struct vertex_decl* decl = out->decl;
+
+    model_output_streams(out, mesh_idx, m);
+    unsigned int written = 0;
+
+    for (uint32_t j = 0; j < h->num_vertexarrays; ++j) {
+        struct iqm_vertexarray* va = (struct iqm_vertexarray*)(base + h->ofs_vertexarrays) + j;
+        enum vertex_attrib attrib;
+        switch (va->type) {
+            case IQM_POSITION:     attrib = VERTEX_POSITION;     break;
+            case IQM_TEXCOORD:     attrib = VERTEX_UV;           break;
+            case IQM_NORMAL:       attrib = VERTEX_NORMAL;       break;
+            case IQM_TANGENT:      attrib = VERTEX_TANGENT;      break;
+            case IQM_BLENDINDEXES: attrib = VERTEX_BONE_IDS;     break;
+            case IQM_BLENDWEIGHTS: attrib = VERTEX_BONE_WEIGHTS; break;
+            default: continue;
+        }
+        const struct vertex_element* e = vertex_decl_find(decl, attrib);
+        if (!e)
+            continue;
+        written |= 1u << attrib;
+
+        size_t src_stride = iqm_va_fmt_size(va->format) * va->size;
+        unsigned char* src = base + va->offset + mesh->first_vertex * src_stride;
+        unsigned char* dst = (unsigned char*)m->streams[e->stream].data + e->offset;
+        size_t dst_stride = m->streams[e->stream].stride;
+        for (size_t i = 0; i < m->num_verts; ++i, src += src_stride, dst += dst_stride) {
+            if (attrib == VERTEX_BONE_IDS) {
+                assert(iqm_va_fmt_size(va->format) == sizeof(unsigned char));
+                uint32_t bis[4];
+                for (int k = 0; k < 4; ++k)
+                    bis[k] = src[k];
+                vertex_element_write_uint(e, dst, bis);
+            } else if (attrib == VERTEX_BONE_WEIGHTS) {
+                assert(iqm_va_fmt_size(va->format) == sizeof(unsigned char));
+                float biw[4];
+                for (int k = 0; k < 4; ++k)
+                    biw[k] = src[k] / 255.0f;
+                vertex_element_write(e, dst, biw);
+            } else {
+                vertex_element_write(e, dst, (const float*)src);
+            }
+        }
+    }
+    model_output_clear_missing(out, m, written);
+}
+
+static struct mesh* iqm_read_mesh(struct iqm_file* iqm, uint32_t mesh_idx, uint32_t prev_verts_num, const struct model_output* out)
+{
+    /* Aliases */
+    struct iqm_header* h = &iqm->header;
+    unsigned char* base = iqm->base;
+
+    struct iqm_mesh* mesh = (struct iqm_mesh*)(base + h->ofs_meshes + mesh_idx * sizeof(struct iqm_mesh));
+    struct mesh* m = mesh_new();
+    m->num_verts = mesh->num_vertexes;
+
+    /* Allocate indices */
+    m->num_indices = mesh->num_triangles * 3;
+    if (out) {
+        model_output_indices(out, mesh_idx, m);
+        iqm_read_vertex_streams(iqm, mesh, mesh_idx, m, out);
+    } else {
+        m->indices = asset_realloc(m->indices, m->num_indices * sizeof(uint32_t));
+        memset(m->indices, 0, m->num_indices * sizeof(uint32_t));
+        iqm_read_vertices(iqm, mesh, m);
+    }
 
     /* Populate indices */
     for (uint32_t i = 0; i < mesh->num_triangles; ++i) {
@@ -187,23 +254,23 @@ static struct mesh* iqm_read_mesh(struct iqm_file* iqm, uint32_t mesh_idx, uint3
 static size_t int_hash(hm_ptr key) { return (size_t)key; }
 static int int_eql(hm_ptr k1, hm_ptr k2) { return k1 == k2; }
 
-static struct model* iqm_read_model(struct iqm_file* iqm)
+static struct model* iqm_read_model(struct iqm_file* iqm, const struct model_output* out)
 {
     struct hashmap material_ids;
     hashmap_init(&material_ids, int_hash, int_eql);
 
     struct model* model = model_new();
     model->num_mesh_groups = 1;
-    model->mesh_groups = realloc(model->mesh_groups, model->num_mesh_groups * sizeof(struct mesh_group*));
+    model->mesh_groups = asset_realloc(model->mesh_groups, model->num_mesh_groups * sizeof(struct mesh_group*));
     struct mesh_group* mgroup = mesh_group_new();
-    mgroup->name = strdup("root_group");
+    mgroup->name = asset_strdup("root_group");
     model->mesh_groups[0] = mgroup;
 
     for (uint32_t i = 0; i < iqm->header.num_meshes; ++i) {
-        struct mesh* nm = iqm_read_mesh(iqm, i, i == 0 ? 0 : model->meshes[i - 1]->num_verts);
+        struct mesh* nm = iqm_read_mesh(iqm, i, i == 0 ? 0 : model->meshes[i - 1]->num_verts, out);
         nm->mgroup_idx = 0;
         model->num_meshes++;
-        model->meshes = realloc(model->meshes, model->num_meshes * sizeof(struct mesh*));
+        model->meshes = asset_realloc(model->meshes, model->num_meshes * sizeof(struct mesh*));
         model->meshes[model->num_meshes - 1] = nm;
 
         /* Assign actual material index */
@@ -219,7 +286,7 @@ static struct model* iqm_read_model(struct iqm_file* iqm)
     return model;
 }
 
-struct model* model_from_iqm(const unsigned char* data, size_t sz)
+struct model* model_from_iqm(const unsigned char* data, size_t sz, const struct model_output* out)
 {
     struct iqm_file iqm;
     memset(&iqm, 0, sizeof(struct iqm_file));
@@ -228,13 +295,13 @@ struct model* model_from_iqm(const unsigned char* data, size_t sz)
 
     /* Read header */
     if (!iqm_read_header(&iqm)) {
-        fprintf(stderr, "Not a iqm file!\n");
+        set_last_asset_load_error("Not a iqm file");
         return 0;
     }
 
     /* Read meshdata */
     if (iqm.header.num_meshes > 0) {
-        struct model* m = iqm_read_model(&iqm);
+        struct model* m = iqm_read_model(&iqm, out);
         /* Read skeleton */
         if (iqm.header.num_joints > 0) {
             m->skeleton = iqm_read_skeleton(&iqm);
@@ -248,3 +315,45 @@ struct model* model_from_iqm(const unsigned char* data, size_t sz)
 
     return 0;
 }
+
+int model_info_from_iqm(const unsigned char* data, size_t sz, struct model_info* info)
+{
+    struct iqm_file iqm;
+    memset(&iqm, 0, sizeof(struct iqm_file));
+    iqm.base = (unsigned char*) data;
+    iqm.size = sz;
+
+    /* Read header */
+    if (sz < sizeof(struct iqm_header) || !iqm_read_header(&iqm)) {
+        set_last_asset_load_error("Not a iqm file");
+        return 0;
+    }
+    info->num_meshes = iqm.header.num_meshes;
+    info->num_verts = iqm.header.num_vertexes;
+    info->num_indices = (size_t)iqm.header.num_triangles * 3;
+    info->num_joints = iqm.header.num_joints;
+    info->num_frames = iqm.header.num_frames;
+    return 1;
+}
+
+size_t model_extents_from_iqm(const unsigned char* data, size_t sz, struct mesh_extent* extents, size_t max_meshes)
+{
+    struct iqm_file iqm;
+    memset(&iqm, 0, sizeof(struct iqm_file));
+    iqm.base = (unsigned char*) data;
+    iqm.size = sz;
+
+    /* Read header and mesh table */
+    struct iqm_header* h = &iqm.header;
+    if (sz < sizeof(struct iqm_header) || !iqm_read_header(&iqm)
+     || h->ofs_meshes + (size_t)h->num_meshes * sizeof(struct iqm_mesh) > sz) {
+        set_last_asset_load_error("Not a iqm file");
+        return 0;
+    }
+    for (uint32_t i = 0; i < h->num_meshes && i < max_meshes; ++i) {
+        struct iqm_mesh* mesh = (struct iqm_mesh*)(iqm.base + h->ofs_meshes) + i;
+        extents[i].num_verts = mesh->num_vertexes;
+        extents[i].num_indices = (size_t)mesh->num_triangles * 3;
+    }
+    return h->num_meshes;
+}
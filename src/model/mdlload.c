@@ -1,4 +1,5 @@
 #include <assets/model/modelload.h>
+#include <assets/allocator.h>
 #include <stdlib.h>
 #include <string.h>
 #include <linalgb.h>
@@ -13,11 +14,11 @@ struct frameset* frameset_from_anm(const unsigned char* data, size_t sz)
 
     struct frameset* fset = frameset_new();
     fset->num_frames = anm.header.num_frames;
-    fset->frames = calloc(fset->num_frames, sizeof(struct frame*));
+    fset->frames = asset_calloc(fset->num_frames, sizeof(struct frame*));
 
     struct frame* base_frame = frame_new();
     base_frame->num_joints = anm.header.num_joints;
-    base_frame->joints = realloc(base_frame->joints, base_frame->num_joints * sizeof(struct joint));
+    base_frame->joints = asset_realloc(base_frame->joints, base_frame->num_joints * sizeof(struct joint));
     memset(base_frame->joints, 0, base_frame->num_joints * sizeof(struct joint));
     for (unsigned int i = 0; i < base_frame->num_joints; ++i) {
         struct anm_joint* aj = anm.joints + i;
@@ -63,8 +64,33 @@ struct frameset* frameset_from_anm(const unsigned char* data, size_t sz)
     return fset;
 }
 
-struct model* model_from_mdl(const unsigned char* data, size_t sz)
+/* Writes one mdl vertex array of the mesh into the stream element declared for it,
+ * returns the attribute bit when written */
+static unsigned int mdl_write_stream(struct mesh* mesh, const struct vertex_decl* decl, enum vertex_attrib attrib, const void* src, size_t src_stride)
 {
+    const struct vertex_element* e = vertex_decl_find(decl, attrib);
+    if (!e || !src)
+        return 0;
+    const unsigned char* sp = src;
+    unsigned char* dst = (unsigned char*)mesh->streams[e->stream].data + e->offset;
+    size_t dst_stride = mesh->streams[e->stream].stride;
+    for (size_t j = 0; j < mesh->num_verts; ++j, sp += src_stride, dst += dst_stride) {
+        if (attrib == VERTEX_BONE_IDS) {
+            uint32_t bis[4];
+            for (unsigned int k = 0; k < 4; ++k)
+                bis[k] = ((const u16*)sp)[k];
+            vertex_element_write_uint(e, dst, bis);
+        } else {
+            vertex_element_write(e, dst, (const float*)sp);
+        }
+    }
+    return 1u << attrib;
+}
+
+struct model* model_from_mdl(const unsigned char* data, size_t sz, const struct model_output* out)
+{
+    const struct vertex_decl* decl = out ? out->decl : 0;
+
     /* Parse mdl file */
     struct mdl_file mdl_file;
     mdl_parse_from_buf(&mdl_file, (byte*)data, sz);
@@ -100,7 +126,7 @@ struct model* model_from_mdl(const unsigned char* data, size_t sz)
     /* Fill in model struct */
     struct model* m = model_new();
     m->num_meshes = mdl_file.header.num_mesh_descs;
-    m->meshes = realloc(m->meshes, m->num_meshes * sizeof(struct mesh*));
+    m->meshes = asset_realloc(m->meshes, m->num_meshes * sizeof(struct mesh*));
     u32 cur_idx = 0, cur_vert = 0;
     for (unsigned int i = 0; i < m->num_meshes; ++i) {
         /* Fill in mesh struct */
@@ -108,21 +134,36 @@ struct model* model_from_mdl(const unsigned char* data, size_t sz)
         struct mesh* mesh = mesh_new();
         mesh->num_verts   = mdl_mesh->num_vertices;
         mesh->num_indices = mdl_mesh->num_indices;
-        mesh->vertices    = realloc(mesh->vertices, mesh->num_verts * sizeof(struct vertex));
-        if (mdl_file.header.flags.rigged)
-            mesh->weights = realloc(mesh->weights, mesh->num_verts * sizeof(struct vertex_weight));
-        mesh->indices     = realloc(mesh->indices, mesh->num_indices * sizeof(uint32_t));
         mesh->mat_index   = mdl_mesh->mat_idx;
-        for (unsigned int j = 0; j < mesh->num_verts; ++j) {
-            struct vertex* v = mesh->vertices + j;
-            memcpy(v->position, pos_va + cur_vert + j, sizeof(float) * 3);
-            memcpy(v->normal,   nm_va  + cur_vert + j, sizeof(float) * 3);
-            memcpy(v->uvs,      uv_va  + cur_vert + j, sizeof(float) * 2);
+        if (out) {
+            /* Only the declared arrays are read */
+            model_output_indices(out, i, mesh);
+            model_output_streams(out, i, mesh);
+            unsigned int written = 0;
+            written |= mdl_write_stream(mesh, decl, VERTEX_POSITION, pos_va ? pos_va + cur_vert : 0, sizeof(*pos_va));
+            written |= mdl_write_stream(mesh, decl, VERTEX_NORMAL, nm_va ? nm_va + cur_vert : 0, sizeof(*nm_va));
+            written |= mdl_write_stream(mesh, decl, VERTEX_UV, uv_va ? uv_va + cur_vert : 0, sizeof(*uv_va));
             if (mdl_file.header.flags.rigged) {
-                struct vertex_weight* vw = mesh->weights + j;
-                for (unsigned int k = 0; k < 4; ++k) {
-                    vw->bone_ids[k]     = ((u16*)(bi_va + cur_vert + j))[k];
-                    vw->bone_weights[k] = ((f32*)(bw_va + cur_vert + j))[k];
+                written |= mdl_write_stream(mesh, decl, VERTEX_BONE_IDS, bi_va ? bi_va + cur_vert : 0, sizeof(*bi_va));
+                written |= mdl_write_stream(mesh, decl, VERTEX_BONE_WEIGHTS, bw_va ? bw_va + cur_vert : 0, sizeof(*bw_va));
+            }
+            model_output_clear_missing(out, mesh, written);
+        } else {
+            mesh->indices = asset_realloc(mesh->indices, mesh->num_indices * sizeof(uint32_t));
+            mesh->vertices = asset_realloc(mesh->vertices, mesh->num_verts * sizeof(struct vertex));
+            if (mdl_file.header.flags.rigged)
+                mesh->weights = asset_realloc(mesh->weights, mesh->num_verts * sizeof(struct vertex_weight));
+            for (unsigned int j = 0; j < mesh->num_verts; ++j) {
+                struct vertex* v = mesh->vertices + j;
+                memcpy(v->position, pos_va + cur_vert + j, sizeof(float) * 3);
+                memcpy(v->normal,   nm_va  + cur_vert + j, sizeof(float) * 3);
+                memcpy(v->uvs,      uv_va  + cur_vert + j, sizeof(float) * 2);
+                if (mdl_file.header.flags.rigged) {
+                    struct vertex_weight* vw = mesh->weights + j;
+                    for (unsigned int k = 0; k < 4; ++k) {
+                        vw->bone_ids[k]     = ((u16*)(bi_va + cur_vert + j))[k];
+                        vw->bone_weights[k] = ((f32*)(bw_va + cur_vert + j))[k];
+                    }
                 }
             }
         }
@@ -139,9 +180,9 @@ struct model* model_from_mdl(const unsigned char* data, size_t sz)
         } else {
             /* Create mesh group */
             struct mesh_group* mgroup = mesh_group_new();
-            mgroup->name = strdup(name);
+            mgroup->name = asset_strdup(name);
             m->num_mesh_groups++;
-            m->mesh_groups = realloc(m->mesh_groups, m->num_mesh_groups * sizeof(struct mesh_group*));
+            m->mesh_groups = asset_realloc(m->mesh_groups, m->num_mesh_groups * sizeof(struct mesh_group*));
             m->mesh_groups[m->num_mesh_groups - 1] = mgroup;
             /* Assign mgroup idx */
             mesh->mgroup_idx = m->num_mesh_groups - 1;
@@ -162,10 +203,10 @@ struct model* model_from_mdl(const unsigned char* data, size_t sz)
         struct skeleton* skel = skeleton_new();
 
         skel->rest_pose->num_joints = h->num_joints;
-        skel->rest_pose->joints = realloc(skel->rest_pose->joints, skel->rest_pose->num_joints * sizeof(struct joint));
+        skel->rest_pose->joints = asset_realloc(skel->rest_pose->joints, skel->rest_pose->num_joints * sizeof(struct joint));
         memset(skel->rest_pose->joints, 0, skel->rest_pose->num_joints * sizeof(struct joint));
 
-        skel->joint_names = realloc(skel->joint_names, skel->rest_pose->num_joints * sizeof(const char*));
+        skel->joint_names = asset_realloc(skel->joint_names, skel->rest_pose->num_joints * sizeof(const char*));
         memset(skel->joint_names, 0, skel->rest_pose->num_joints * sizeof(const char*));
 
         for (unsigned int i = 0; i < h->num_joints; ++i) {
@@ -175,7 +216,7 @@ struct model* model_from_mdl(const unsigned char* data, size_t sz)
             jnt->parent = mj->ref_parent != MDL_INVALID_OFFSET ? skel->rest_pose->joints + mj->ref_parent : 0;
             /* Copy name */
             const char* name = (const char*)(mdl_file.strings + *((u32*)(mdl_file.joint_name_ofs) + i));
-            skel->joint_names[i] = strdup(name);
+            skel->joint_names[i] = asset_strdup(name);
             /* Copy data */
             memcpy(jnt->position, mj->position, 3 * sizeof(float));
             memcpy(jnt->rotation, mj->rotation, 4 * sizeof(float));
@@ -186,3 +227,31 @@ struct model* model_from_mdl(const unsigned char* data, size_t sz)
 
     return m;
 }
+
+int model_info_from_mdl(const unsigned char* data, size_t sz, struct model_info* info)
+{
+    /* Parsing only resolves the section offsets */
+    struct mdl_file mdl_file;
+    mdl_parse_from_buf(&mdl_file, (byte*)data, sz);
+    info->num_meshes = mdl_file.header.num_mesh_descs;
+    for (unsigned int i = 0; i < mdl_file.header.num_mesh_descs; ++i) {
+        struct mdl_mesh_desc* mdl_mesh = mdl_file.mesh_desc + i;
+        info->num_verts += mdl_mesh->num_vertices;
+        info->num_indices += mdl_mesh->num_indices;
+    }
+    if (mdl_file.header.flags.rigged)
+        info->num_joints = mdl_file.header.num_joints;
+    return 1;
+}
+
+size_t model_extents_from_mdl(const unsigned char* data, size_t sz, struct mesh_extent* extents, size_t max_meshes)
+{
+    struct mdl_file mdl_file;
+    mdl_parse_from_buf(&mdl_file, (byte*)data, sz);
+    for (unsigned int i = 0; i < mdl_file.header.num_mesh_descs && i < max_meshes; ++i) {
+        struct mdl_mesh_desc* mdl_mesh = mdl_file.mesh_desc + i;
+        extents[i].num_verts = mdl_mesh->num_vertices;
+        extents[i].num_indices = mdl_mesh->num_indices;
+    }
+    return mdl_file.header.num_mesh_descs;
+}
@@ -1,71 +1,97 @@
 #include "assets/model/model.h"
+#include "assets/allocator.h"
+#include "../stats.h"
 #include <stdlib.h>
 #include <string.h>
 #include <linalgb.h>
 
 struct model* model_new()
 {
-    struct model* m = malloc(sizeof(struct model));
-    memset(m, 0, sizeof(struct model));
-    m->meshes = malloc(0);
+    struct model* m = asset_calloc(1, sizeof(struct model));
     return m;
 }
 
 struct mesh* mesh_new()
 {
-    struct mesh* mesh = malloc(sizeof(struct mesh));
-    memset(mesh, 0, sizeof(struct mesh));
-    mesh->vertices = malloc(0);
-    mesh->indices = malloc(0);
+    struct mesh* mesh = asset_calloc(1, sizeof(struct mesh));
     return mesh;
 }
 
 struct mesh_group* mesh_group_new()
 {
-    struct mesh_group* mg = malloc(sizeof(struct mesh_group));
-    memset(mg, 0, sizeof(struct mesh_group));
+    struct mesh_group* mg = asset_calloc(1, sizeof(struct mesh_group));
     return mg;
 }
 
 void model_delete(struct model* m)
 {
-    for (size_t i = 0; i < m->num_meshes; ++i)
-        mesh_delete(m->meshes[i]);
-    free(m->meshes);
-    if (m->mesh_groups) {
-        for (size_t i = 0; i < m->num_mesh_groups; ++i)
-            mesh_group_delete(m->mesh_groups[i]);
-        free(m->mesh_groups);
+    uint64_t t0 = stats_phase_begin();
+    if (!m->packed_size) {
+        for (size_t i = 0; i < m->num_meshes; ++i)
+            mesh_delete(m->meshes[i]);
+        asset_free(m->meshes);
+        if (m->mesh_groups) {
+            for (size_t i = 0; i < m->num_mesh_groups; ++i)
+                mesh_group_delete(m->mesh_groups[i]);
+            asset_free(m->mesh_groups);
+        }
+        if (m->skeleton)
+            skeleton_delete(m->skeleton);
+        if (m->frameset)
+            frameset_delete(m->frameset);
     }
-    if (m->skeleton)
-        skeleton_delete(m->skeleton);
-    if (m->frameset)
-        frameset_delete(m->frameset);
-    free(m);
+    asset_free(m);
+    stats_phase_end(ASSET_PHASE_FREE, t0);
 }
 
 void mesh_delete(struct mesh* mesh)
 {
     if (mesh->weights)
-        free(mesh->weights);
-    free(mesh->vertices);
-    free(mesh->indices);
-    free(mesh);
+        asset_free(mesh->weights);
+    if (mesh->quant) {
+        struct mesh_quant* q = mesh->quant;
+        asset_free(q->vertices);
+        asset_free(q->weights);
+        asset_free(q->indices);
+        if (q->lod_indices) {
+            for (size_t i = 0; i < mesh->num_lods; ++i)
+                asset_free(q->lod_indices[i]);
+            asset_free(q->lod_indices);
+        }
+        asset_free(q);
+    }
+    for (size_t i = 0; i < mesh->num_lods; ++i)
+        asset_free(mesh->lods[i].indices);
+    asset_free(mesh->lods);
+    for (size_t i = 0; i < VERTEX_MAX_STREAMS; ++i)
+        asset_free(mesh->streams[i].data);
+    asset_free(mesh->vertices);
+    asset_free(mesh->indices);
+    asset_free(mesh);
+}
+
+void mesh_shrink_to_fit(struct mesh* mesh)
+{
+    if (mesh->num_verts) {
+        mesh->vertices = asset_realloc(mesh->vertices, mesh->num_verts * sizeof(struct vertex));
+        if (mesh->weights)
+            mesh->weights = asset_realloc(mesh->weights, mesh->num_verts * sizeof(struct vertex_weight));
+    }
+    if (mesh->num_indices)
+        mesh->indices = asset_realloc(mesh->indices, mesh->num_indices * sizeof(uint32_t));
 }
 
 void mesh_group_delete(struct mesh_group* mg)
 {
     if (mg->name)
-        free((void*)mg->name);
-    free(mg);
+        asset_free((void*)mg->name);
+    asset_free(mg);
 }
 
 struct skeleton* skeleton_new()
 {
-    struct skeleton* skel = malloc(sizeof(struct skeleton));
-    memset(skel, 0, sizeof(struct skeleton));
+    struct skeleton* skel = asset_calloc(1, sizeof(struct skeleton));
     skel->rest_pose = frame_new();
-    skel->joint_names = malloc(0);
     return skel;
 }
 
@@ -73,17 +99,15 @@ void skeleton_delete(struct skeleton* skel)
 {
     for (uint32_t i = 0; i < skel->rest_pose->num_joints; ++i)
         if (skel->joint_names[i])
-            free(skel->joint_names[i]);
-    free(skel->joint_names);
+            asset_free(skel->joint_names[i]);
+    asset_free(skel->joint_names);
     frame_delete(skel->rest_pose);
-    free(skel);
+    asset_free(skel);
 }
 
 struct frame* frame_new()
 {
-    struct frame* f = malloc(sizeof(struct frame));
-    memset(f, 0, sizeof(struct frame));
-    f->joints = malloc(0);
+    struct frame* f = asset_calloc(1, sizeof(struct frame));
     return f;
 }
 
@@ -91,7 +115,7 @@ struct frame* frame_copy(struct frame* f)
 {
     struct frame* nf = frame_new();
     nf->num_joints = f->num_joints;
-    nf->joints = realloc(nf->joints, nf->num_joints * sizeof(struct joint));
+    nf->joints = asset_realloc(nf->joints, nf->num_joints * sizeof(struct joint));
     for (size_t i = 0; i < nf->num_joints; ++i) {
         struct joint* j = f->joints + i;
         struct joint* nj = nf->joints + i;
@@ -105,8 +129,8 @@ struct frame* frame_copy(struct frame* f)
 
 void frame_delete(struct frame* f)
 {
-    free(f->joints);
-    free(f);
+    asset_free(f->joints);
+    asset_free(f);
 }
 
 void frame_joint_transform(struct joint* j, float trans[16])
@@ -160,14 +184,252 @@ struct frame* frame_interpolate(struct frame* f0, struct frame* f1, float t)
 
 struct frameset* frameset_new()
 {
-    struct frameset* fs = malloc(sizeof(struct frameset));
+    struct frameset* fs = asset_calloc(1, sizeof(struct frameset));
     return fs;
 }
 
 void frameset_delete(struct frameset* fs)
 {
+    uint64_t t0 = stats_phase_begin();
     for (size_t i = 0; i < fs->num_frames; ++i)
         frame_delete(fs->frames[i]);
-    free(fs->frames);
-    free(fs);
+    asset_free(fs->frames);
+    asset_free(fs);
+    stats_phase_end(ASSET_PHASE_FREE, t0);
+}
+
+/*-----------------------------------------------------------------
+ * Packing
+ *-----------------------------------------------------------------*/
+#define PACK_ALIGN 16
+
+/* Bump cursor over the packed block. With a null base it only measures */
+struct pack_cursor {
+    unsigned char* base;
+    size_t ofs;
+};
+
+static void* pack_take(struct pack_cursor* pc, const void* src, size_t sz)
+{
+    size_t ofs = (pc->ofs + (PACK_ALIGN - 1)) & ~(size_t)(PACK_ALIGN - 1);
+    pc->ofs = ofs + sz;
+    if (!pc->base)
+        return 0;
+    void* dst = pc->base + ofs;
+    if (src)
+        memcpy(dst, src, sz);
+    return dst;
+}
+
+static struct frame* pack_frame(struct pack_cursor* pc, const struct frame* f)
+{
+    struct frame* nf = pack_take(pc, f, sizeof(struct frame));
+    struct joint* joints = pack_take(pc, f->joints, f->num_joints * sizeof(struct joint));
+    if (!pc->base)
+        return 0;
+    nf->joints = joints;
+    for (size_t i = 0; i < f->num_joints; ++i)
+        if (f->joints[i].parent)
+            joints[i].parent = joints + (f->joints[i].parent - f->joints);
+    return nf;
+}
+
+static struct mesh_quant* pack_quant(struct pack_cursor* pc, const struct mesh* mesh)
+{
+    const struct mesh_quant* q = mesh->quant;
+    struct mesh_quant* nq = pack_take(pc, q, sizeof(struct mesh_quant));
+    struct qvertex* verts = pack_take(pc, q->vertices, mesh->num_verts * sizeof(struct qvertex));
+    struct qvertex_weight* weights = q->weights
+        ? pack_take(pc, q->weights, mesh->num_verts * sizeof(struct qvertex_weight)) : 0;
+    uint16_t* indices = q->indices
+        ? pack_take(pc, q->indices, mesh->num_indices * sizeof(uint16_t)) : 0;
+    uint16_t** lod_indices = q->lod_indices
+        ? pack_take(pc, 0, mesh->num_lods * sizeof(uint16_t*)) : 0;
+    for (size_t j = 0; q->lod_indices && j < mesh->num_lods; ++j) {
+        uint16_t* li = pack_take(pc, q->lod_indices[j], mesh->lods[j].num_indices * sizeof(uint16_t));
+        if (pc->base)
+            lod_indices[j] = li;
+    }
+    if (pc->base) {
+        nq->vertices = verts;
+        nq->weights = weights;
+        nq->indices = indices;
+        nq->lod_indices = lod_indices;
+    }
+    return nq;
+}
+
+static struct model* pack_model(struct pack_cursor* pc, const struct model* m)
+{
+    struct model* nm = pack_take(pc, m, sizeof(struct model));
+    struct mesh** meshes = pack_take(pc, 0, m->num_meshes * sizeof(struct mesh*));
+    for (size_t i = 0; i < m->num_meshes; ++i) {
+        const struct mesh* mesh = m->meshes[i];
+        struct mesh* nmesh = pack_take(pc, mesh, sizeof(struct mesh));
+        struct vertex* verts = mesh->vertices
+            ? pack_take(pc, mesh->vertices, mesh->num_verts * sizeof(struct vertex)) : 0;
+        struct vertex_weight* weights = mesh->weights
+            ? pack_take(pc, mesh->weights, mesh->num_verts * sizeof(struct vertex_weight)) : 0;
+        uint32_t* indices = mesh->indices
+            ? pack_take(pc, mesh->indices, mesh->num_indices * sizeof(uint32_t)) : 0;
+        struct mesh_lod* lods = mesh->lods
+            ? pack_take(pc, mesh->lods, mesh->num_lods * sizeof(struct mesh_lod)) : 0;
+        for (size_t j = 0; j < mesh->num_lods; ++j) {
+            uint32_t* lod_indices = mesh->lods[j].indices
+                ? pack_take(pc, mesh->lods[j].indices, mesh->lods[j].num_indices * sizeof(uint32_t)) : 0;
+            if (pc->base)
+                lods[j].indices = lod_indices;
+        }
+        struct mesh_quant* quant = mesh->quant ? pack_quant(pc, mesh) : 0;
+        void* streams[VERTEX_MAX_STREAMS];
+        for (size_t j = 0; j < VERTEX_MAX_STREAMS; ++j)
+            streams[j] = mesh->streams[j].data
+                ? pack_take(pc, mesh->streams[j].data, mesh->num_verts * mesh->streams[j].stride) : 0;
+        if (pc->base) {
+            for (size_t j = 0; j < VERTEX_MAX_STREAMS; ++j)
+                nmesh->streams[j].data = streams[j];
+            nmesh->vertices = verts;
+            nmesh->weights = weights;
+            nmesh->indices = indices;
+            nmesh->quant = quant;
+            nmesh->lods = lods;
+            meshes[i] = nmesh;
+        }
+    }
+
+    struct mesh_group** mgroups = pack_take(pc, 0, m->num_mesh_groups * sizeof(struct mesh_group*));
+    for (size_t i = 0; i < m->num_mesh_groups; ++i) {
+        const struct mesh_group* mg = m->mesh_groups[i];
+        struct mesh_group* nmg = pack_take(pc, mg, sizeof(struct mesh_group));
+        const char* name = mg->name ? pack_take(pc, mg->name, strlen(mg->name) + 1) : 0;
+        if (pc->base) {
+            nmg->name = name;
+            mgroups[i] = nmg;
+        }
+    }
+
+    struct skeleton* skel = 0;
+    if (m->skeleton) {
+        const struct skeleton* s = m->skeleton;
+        size_t num_joints = s->rest_pose->num_joints;
+        skel = pack_take(pc, s, sizeof(struct skeleton));
+        struct frame* rest_pose = pack_frame(pc, s->rest_pose);
+        char** names = pack_take(pc, 0, num_joints * sizeof(char*));
+        for (size_t i = 0; i < num_joints; ++i) {
+            const char* jn = s->joint_names[i];
+            char* name = jn ? pack_take(pc, jn, strlen(jn) + 1) : 0;
+            if (pc->base)
+                names[i] = name;
+        }
+        if (pc->base) {
+            skel->rest_pose = rest_pose;
+            skel->joint_names = names;
+        }
+    }
+
+    struct frameset* fset = 0;
+    if (m->frameset) {
+        const struct frameset* fs = m->frameset;
+        fset = pack_take(pc, fs, sizeof(struct frameset));
+        struct frame** frames = pack_take(pc, 0, fs->num_frames * sizeof(struct frame*));
+        for (size_t i = 0; i < fs->num_frames; ++i) {
+            struct frame* f = pack_frame(pc, fs->frames[i]);
+            if (pc->base)
+                frames[i] = f;
+        }
+        if (pc->base)
+            fset->frames = frames;
+    }
+
+    if (pc->base) {
+        nm->meshes = meshes;
+        nm->mesh_groups = mgroups;
+        nm->skeleton = skel;
+        nm->frameset = fset;
+        nm->packed_size = pc->ofs;
+        nm->packed_base = nm;
+    }
+    return nm;
+}
+
+struct model* model_pack(const struct model* m)
+{
+    /* Measure first, then lay out into the exact sized block */
+    struct pack_cursor pc = { 0, 0 };
+    pack_model(&pc, m);
+    pc.base = asset_malloc(pc.ofs);
+    if (!pc.base)
+        return 0;
+    pc.ofs = 0;
+    return pack_model(&pc, m);
+}
+
+#define pack_rebase(p, delta) \
+    do { if (p) (p) = (void*)((unsigned char*)(p) + (delta)); } while (0)
+
+static void frame_relocate(struct frame* f, ptrdiff_t delta)
+{
+    pack_rebase(f->joints, delta);
+    for (size_t i = 0; i < f->num_joints; ++i)
+        pack_rebase(f->joints[i].parent, delta);
+}
+
+void model_relocate(struct model* m)
+{
+    if (!m->packed_size)
+        return;
+    ptrdiff_t delta = (unsigned char*)m - (unsigned char*)m->packed_base;
+    if (!delta)
+        return;
+    m->packed_base = m;
+
+    pack_rebase(m->meshes, delta);
+    for (size_t i = 0; i < m->num_meshes; ++i) {
+        pack_rebase(m->meshes[i], delta);
+        struct mesh* mesh = m->meshes[i];
+        pack_rebase(mesh->vertices, delta);
+        pack_rebase(mesh->weights, delta);
+        pack_rebase(mesh->indices, delta);
+        pack_rebase(mesh->lods, delta);
+        for (size_t j = 0; j < mesh->num_lods; ++j)
+            pack_rebase(mesh->lods[j].indices, delta);
+        if (mesh->quant) {
+            pack_rebase(mesh->quant, delta);
+            struct mesh_quant* q = mesh->quant;
+            pack_rebase(q->vertices, delta);
+            pack_rebase(q->weights, delta);
+            pack_rebase(q->indices, delta);
+            pack_rebase(q->lod_indices, delta);
+            for (size_t j = 0; q->lod_indices && j < mesh->num_lods; ++j)
+                pack_rebase(q->lod_indices[j], delta);
+        }
+        for (size_t j = 0; j < VERTEX_MAX_STREAMS; ++j)
+            pack_rebase(mesh->streams[j].data, delta);
+    }
+
+    pack_rebase(m->mesh_groups, delta);
+    for (size_t i = 0; i < m->num_mesh_groups; ++i) {
+        pack_rebase(m->mesh_groups[i], delta);
+        pack_rebase(m->mesh_groups[i]->name, delta);
+    }
+
+    if (m->skeleton) {
+        pack_rebase(m->skeleton, delta);
+        struct skeleton* s = m->skeleton;
+        pack_rebase(s->rest_pose, delta);
+        frame_relocate(s->rest_pose, delta);
+        pack_rebase(s->joint_names, delta);
+        for (size_t i = 0; i < s->rest_pose->num_joints; ++i)
+            pack_rebase(s->joint_names[i], delta);
+    }
+
+    if (m->frameset) {
+        pack_rebase(m->frameset, delta);
+        struct frameset* fs = m->frameset;
+        pack_rebase(fs->frames, delta);
+        for (size_t i = 0; i < fs->num_frames; ++i) {
+            pack_rebase(fs->frames[i], delta);
+            frame_relocate(fs->frames[i], delta);
+        }
+    }
 }
@@ -1,70 +1,340 @@
 #include "assets/model/modelload.h"
 #include "assets/fileload.h"
+#include "assets/error.h"
+#include "assets/allocator.h"
 #include "../util.h"
+#include "../stats.h"
 #include <stdlib.h>
 #include <string.h>
 
-struct model* model_from_mem_buf(const unsigned char* data, size_t sz, const char* hint)
+enum model_format model_format_detect(const unsigned char* data, size_t sz, const char* hint)
 {
+    /* Magic bytes */
+    static const char fbx_sig[] = "Kaydara FBX Binary  ";
+    static const char iqm_sig[] = "INTERQUAKEMODEL";
+    if (sz >= sizeof(fbx_sig) - 1 && memcmp(data, fbx_sig, sizeof(fbx_sig) - 1) == 0)
+        return MODEL_FORMAT_FBX;
+    if (sz >= sizeof(iqm_sig) && memcmp(data, iqm_sig, sizeof(iqm_sig)) == 0)
+        return MODEL_FORMAT_IQM;
+    if (sz >= 4 && memcmp(data, "ply\n", 4) == 0)
+        return MODEL_FORMAT_PLY;
+
+    /* Formats without a signature (obj, mdl) or damaged
+     * files are left to the loader the hint selects */
+    if (!hint)
+        return MODEL_FORMAT_UNKNOWN;
     if (strcmpi(hint, "obj") == 0)
-        return model_from_obj(data, sz);
+        return MODEL_FORMAT_OBJ;
     else if (strcmpi(hint, "fbx") == 0)
-        return model_from_fbx(data, sz);
+        return MODEL_FORMAT_FBX;
     else if (strcmpi(hint, "ply") == 0)
-        return model_from_ply(data, sz);
+        return MODEL_FORMAT_PLY;
     else if (strcmpi(hint, "iqm") == 0)
-        return model_from_iqm(data, sz);
+        return MODEL_FORMAT_IQM;
     else if (strcmpi(hint, "mdl") == 0)
-        return model_from_mdl(data, sz);
-    /* No model parser found */
-    return 0;
+        return MODEL_FORMAT_MDL;
+    return MODEL_FORMAT_UNKNOWN;
 }
 
-struct model* model_from_file(const char* fpath)
+static const struct mesh_dest* model_output_dest(const struct model_output* out, size_t mesh_idx)
+{
+    return out && mesh_idx < out->num_dests ? out->dests + mesh_idx : 0;
+}
+
+void model_output_streams(const struct model_output* out, size_t mesh_idx, struct mesh* m)
+{
+    const struct mesh_dest* dest = model_output_dest(out, mesh_idx);
+    if (!dest || m->num_verts > dest->max_verts) {
+        /* Too small destinations fail when the load is finished */
+        mesh_alloc_vertex_streams(m, out->decl);
+        return;
+    }
+    for (uint32_t s = 0; s < out->decl->num_streams; ++s) {
+        if (!out->decl->strides[s])
+            continue;
+        m->streams[s].stride = out->decl->strides[s];
+        m->streams[s].data = dest->streams[s]
+            ? dest->streams[s]
+            : asset_calloc(m->num_verts ? m->num_verts : 1, out->decl->strides[s]);
+    }
+}
+
+void model_output_indices(const struct model_output* out, size_t mesh_idx, struct mesh* m)
+{
+    const struct mesh_dest* dest = model_output_dest(out, mesh_idx);
+    if (dest && dest->indices && m->num_indices <= dest->max_indices)
+        m->indices = dest->indices;
+    else
+        m->indices = m->num_indices ? asset_malloc(m->num_indices * sizeof(uint32_t)) : 0;
+}
+
+void model_output_clear_missing(const struct model_output* out, struct mesh* m, unsigned int written)
+{
+    for (uint32_t i = 0; i < out->decl->num_elems; ++i) {
+        const struct vertex_element* e = out->decl->elems + i;
+        if (written & (1u << e->attrib) || !m->streams[e->stream].data)
+            continue;
+        size_t sz = (vertex_attrib_num_comps(e->attrib) * vertex_format_size(e->format) + 3) & ~(size_t)3;
+        unsigned char* dst = (unsigned char*)m->streams[e->stream].data + e->offset;
+        for (size_t v = 0; v < m->num_verts; ++v, dst += m->streams[e->stream].stride)
+            memset(dst, 0, sz);
+    }
+}
+
+static struct model* model_load(const unsigned char* data, size_t sz, const char* hint, const struct model_output* out)
+{
+    clear_last_asset_load_error();
+    uint64_t t0 = stats_phase_begin();
+    struct model* m = 0;
+    switch (model_format_detect(data, sz, hint)) {
+        case MODEL_FORMAT_OBJ:
+            m = model_from_obj(data, sz);
+            break;
+        case MODEL_FORMAT_FBX:
+            m = model_from_fbx(data, sz);
+            break;
+        case MODEL_FORMAT_PLY:
+            m = model_from_ply(data, sz, out);
+            break;
+        case MODEL_FORMAT_IQM:
+            m = model_from_iqm(data, sz, out);
+            break;
+        case MODEL_FORMAT_MDL:
+            m = model_from_mdl(data, sz, out);
+            break;
+        default:
+            /* No model parser found */
+            set_last_asset_load_status(ASSET_LOAD_UNKNOWN_FORMAT, "Unknown model format");
+            break;
+    }
+    stats_phase_end(ASSET_PHASE_PARSE, t0);
+    return m;
+}
+
+struct model* model_from_mem_buf(const unsigned char* data, size_t sz, const char* hint)
+{
+    return model_from_mem_buf_decl(data, sz, hint, 0);
+}
+
+struct model* model_from_mem_buf_decl(const unsigned char* data, size_t sz, const char* hint, const struct vertex_decl* decl)
+{
+    struct model_output out;
+    memset(&out, 0, sizeof(out));
+    out.decl = decl;
+    struct model* m = model_load(data, sz, hint, decl ? &out : 0);
+    if (m && decl) {
+        uint64_t t0 = stats_phase_begin();
+        model_apply_vertex_decl(m, decl);
+        stats_phase_end(ASSET_PHASE_PARSE, t0);
+    }
+    if (m)
+        stats_count_asset();
+    return m;
+}
+
+size_t model_extents_from_mem_buf(const unsigned char* data, size_t sz, const char* hint, struct mesh_extent* extents, size_t max_meshes)
+{
+    clear_last_asset_load_error();
+    switch (model_format_detect(data, sz, hint)) {
+        case MODEL_FORMAT_PLY:
+            return model_extents_from_ply(data, sz, extents, max_meshes);
+        case MODEL_FORMAT_IQM:
+            return model_extents_from_iqm(data, sz, extents, max_meshes);
+        case MODEL_FORMAT_MDL:
+            return model_extents_from_mdl(data, sz, extents, max_meshes);
+        default:
+            break;
+    }
+
+    /* Counts only exist after welding or list walking */
+    struct model* m = model_load(data, sz, hint, 0);
+    if (!m)
+        return 0;
+    for (size_t i = 0; i < m->num_meshes && i < max_meshes; ++i) {
+        extents[i].num_verts = m->meshes[i]->num_verts;
+        extents[i].num_indices = m->meshes[i]->num_indices;
+    }
+    size_t num_meshes = m->num_meshes;
+    model_delete(m);
+    return num_meshes;
+}
+
+/* Moves what the loader left in its own buffers into the destinations and detaches them */
+static int model_output_finish(const struct model_output* out, struct model* m)
+{
+    uint64_t t0 = stats_phase_begin();
+    int ok = m->num_meshes <= out->num_dests;
+    for (size_t i = 0; ok && i < m->num_meshes; ++i) {
+        const struct mesh_dest* dest = out->dests + i;
+        ok = m->meshes[i]->num_verts <= dest->max_verts && m->meshes[i]->num_indices <= dest->max_indices;
+    }
+    if (!ok) {
+        /* Leave caller memory out of the model teardown */
+        for (size_t i = 0; i < m->num_meshes && i < out->num_dests; ++i) {
+            struct mesh* mesh = m->meshes[i];
+            for (uint32_t s = 0; s < VERTEX_MAX_STREAMS; ++s)
+                if (mesh->streams[s].data == out->dests[i].streams[s])
+                    mesh->streams[s].data = 0;
+            if (mesh->indices == out->dests[i].indices)
+                mesh->indices = 0;
+        }
+        set_last_asset_load_error("Destination buffers too small");
+        stats_phase_end(ASSET_PHASE_PARSE, t0);
+        return 0;
+    }
+
+    for (size_t i = 0; i < m->num_meshes; ++i) {
+        struct mesh* mesh = m->meshes[i];
+        const struct mesh_dest* dest = out->dests + i;
+        if (mesh->vertices) {
+            mesh_write_vertex_streams(mesh, out->decl, dest->streams);
+            asset_free(mesh->vertices);
+            mesh->vertices = 0;
+            asset_free(mesh->weights);
+            mesh->weights = 0;
+        }
+        for (uint32_t s = 0; s < VERTEX_MAX_STREAMS; ++s) {
+            void* data = mesh->streams[s].data;
+            if (data && data != dest->streams[s]) {
+                if (dest->streams[s])
+                    memcpy(dest->streams[s], data, mesh->num_verts * mesh->streams[s].stride);
+                asset_free(data);
+            }
+            mesh->streams[s].data = 0;
+            mesh->streams[s].stride = out->decl->strides[s];
+        }
+        if (mesh->indices != dest->indices) {
+            if (dest->indices)
+                memcpy(dest->indices, mesh->indices, mesh->num_indices * sizeof(uint32_t));
+            asset_free(mesh->indices);
+        }
+        mesh->indices = 0;
+    }
+    stats_phase_end(ASSET_PHASE_PARSE, t0);
+    return 1;
+}
+
+struct model* model_decode_into(const unsigned char* data, size_t sz, const char* hint, const struct vertex_decl* decl, const struct mesh_dest* dests, size_t num_dests)
 {
-    /* Check file for existence */
-    long filesz = filesize(fpath);
-    if (filesz == -1)
+    if (!decl) {
+        set_last_asset_load_error("Missing vertex declaration");
         return 0;
+    }
+    struct model_output out;
+    out.decl = decl;
+    out.dests = dests;
+    out.num_dests = num_dests;
+    struct model* m = model_load(data, sz, hint, &out);
+    if (m && !model_output_finish(&out, m)) {
+        model_delete(m);
+        m = 0;
+    }
+    if (m)
+        stats_count_asset();
+    return m;
+}
+
+int model_info_from_mem_buf(const unsigned char* data, size_t sz, const char* hint, struct model_info* info)
+{
+    clear_last_asset_load_error();
+    memset(info, 0, sizeof(*info));
+    info->format = model_format_detect(data, sz, hint);
+    int ok = 0;
+    switch (info->format) {
+        case MODEL_FORMAT_OBJ:
+            /* Plain text without a header, nothing to read ahead */
+            ok = 1;
+            break;
+        case MODEL_FORMAT_FBX:
+            ok = model_info_from_fbx(data, sz, info);
+            break;
+        case MODEL_FORMAT_PLY:
+            ok = model_info_from_ply(data, sz, info);
+            break;
+        case MODEL_FORMAT_IQM:
+            ok = model_info_from_iqm(data, sz, info);
+            break;
+        case MODEL_FORMAT_MDL:
+            ok = model_info_from_mdl(data, sz, info);
+            break;
+        default:
+            set_last_asset_load_status(ASSET_LOAD_UNKNOWN_FORMAT, "Unknown model format");
+            return 0;
+    }
+    if (!ok && get_last_asset_load_status() == ASSET_LOAD_OK)
+        set_last_asset_load_error("Invalid model header");
+    return ok;
+}
 
-    /* Gather file contents */
-    unsigned char* data_buf = malloc(filesz);
-    read_file_to_mem(fpath, data_buf, filesz);
+struct model* model_from_file(const char* fpath)
+{
+    return model_from_file_decl(fpath, 0);
+}
+
+struct model* model_from_file_decl(const char* fpath, const struct vertex_decl* decl)
+{
+    /* Map file contents */
+    struct file_blob fb;
+    if (!file_blob_open(&fb, fpath, FILE_ACCESS_SEQUENTIAL)) {
+        set_last_asset_load_status(ASSET_LOAD_IO_ERROR, "Could not open file");
+        return 0;
+    }
 
     /* Parse model data from memory */
     const char* ext = get_filename_ext(fpath);
-    struct model* m = model_from_mem_buf(data_buf, filesz, ext);
-    free(data_buf);
+    struct model* m = model_from_mem_buf_decl(fb.data, fb.size, ext, decl);
+    file_blob_close(&fb);
 
     /* Return parsed image */
     return m;
 }
 
+int model_info_from_file(const char* fpath, struct model_info* info)
+{
+    /* Map file contents, only the header pages are touched */
+    struct file_blob fb;
+    if (!file_blob_open(&fb, fpath, FILE_ACCESS_RANDOM)) {
+        set_last_asset_load_status(ASSET_LOAD_IO_ERROR, "Could not open file");
+        return 0;
+    }
+
+    /* Parse model header from memory */
+    const char* ext = get_filename_ext(fpath);
+    int ok = model_info_from_mem_buf(fb.data, fb.size, ext, info);
+    file_blob_close(&fb);
+    return ok;
+}
+
 struct frameset* frameset_from_mem_buf(const unsigned char* data, size_t sz, const char* hint)
 {
-    if (strcmpi(hint, "fbx") == 0)
-        return frameset_from_fbx(data, sz);
-    if (strcmpi(hint, "anm") == 0)
-        return frameset_from_anm(data, sz);
-    /* No animation parser found */
-    return 0;
+    clear_last_asset_load_error();
+    uint64_t t0 = stats_phase_begin();
+    struct frameset* fset = 0;
+    if (model_format_detect(data, sz, hint) == MODEL_FORMAT_FBX)
+        fset = frameset_from_fbx(data, sz);
+    else if (hint && strcmpi(hint, "anm") == 0)
+        fset = frameset_from_anm(data, sz);
+    else /* No animation parser found */
+        set_last_asset_load_status(ASSET_LOAD_UNKNOWN_FORMAT, "Unknown animation format");
+    stats_phase_end(ASSET_PHASE_PARSE, t0);
+    if (fset)
+        stats_count_asset();
+    return fset;
 }
 
 struct frameset* frameset_from_file(const char* fpath)
 {
-    /* Check file for existence */
-    long filesz = filesize(fpath);
-    if (filesz == -1)
+    /* Map file contents */
+    struct file_blob fb;
+    if (!file_blob_open(&fb, fpath, FILE_ACCESS_SEQUENTIAL)) {
+        set_last_asset_load_status(ASSET_LOAD_IO_ERROR, "Could not open file");
         return 0;
-
-    /* Gather file contents */
-    unsigned char* data_buf = malloc(filesz);
-    read_file_to_mem(fpath, data_buf, filesz);
+    }
 
     /* Parse frameset data from memory */
     const char* ext = get_filename_ext(fpath);
-    struct frameset* fset = frameset_from_mem_buf(data_buf, filesz, ext);
-    free(data_buf);
+    struct frameset* fset = frameset_from_mem_buf(fb.data, fb.size, ext);
+    file_blob_close(&fb);
 
     /* Return parsed image */
     return fset;
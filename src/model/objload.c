@@ -1,10 +1,15 @@
 #include "assets/model/model.h"
+#include "assets/allocator.h"
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
 #include <vector.h>
 #include <hashmap.h>
 #include "assets/model/postprocess.h"
+#include "../stats.h"
+#include "../strconv.h"
+#include "../threadpool.h"
+#include "weld.h"
 
 /* Custom version of standard isspace, to avoid MSVC checks */
 static int is_space(const char c)
@@ -17,18 +22,40 @@ static int is_space(const char c)
         || c == '\r';
 }
 
-/* Token is not null terminated with token_sz being the token length */
+static const char* skip_space(const char* cur, const char* end)
+{
+    while (cur < end && is_space(*cur))
+        ++cur;
+    return cur;
+}
+
+static const char* skip_word(const char* cur, const char* end)
+{
+    while (cur < end && !is_space(*cur))
+        ++cur;
+    return cur;
+}
+
+/* End of the line starting at cur, either its newline or the buffer end.
+ * Lines are found with memchr, which the C runtimes vectorize */
+static const char* find_eol(const char* cur, const char* end)
+{
+    const char* eol = memchr(cur, '\n', end - cur);
+    return eol ? eol : end;
+}
+
 static float parse_float(const char* token, size_t token_sz)
 {
-    (void) token_sz; /* TODO: Use functions with bound checking */
-    return (float) atof(token);
+    float f = 0.0f;
+    str_to_float(token, token + token_sz, &f);
+    return f;
 }
 
-/* Token is not null terminated with token_sz being the token length */
 static int32_t parse_int(const char* token, size_t token_sz)
 {
-    (void) token_sz; /* TODO: Use functions with bound checking */
-    return atoi(token);
+    long l = 0;
+    str_to_long(token, token + token_sz, &l);
+    return l < INT32_MIN ? INT32_MIN : l > INT32_MAX ? INT32_MAX : (int32_t)l;
 }
 
 /* Parses: i, i/j/k, i//k, i/j */
@@ -38,7 +65,7 @@ static void parse_face_triple(const char* token, size_t token_sz, int32_t* tripl
     const char* cur = token;
     const char* wend = token;
 
-    for (int32_t i = 0; i < 3; ++i) {
+    for (int32_t i = 0; i < 3 && cur < tok_end; ++i) {
         wend = cur;
         /* Advance word end operator */
         while (wend < tok_end && *wend != '/')
@@ -58,111 +85,422 @@ static void parse_space_sep_entry(const char* token, size_t token_sz, float* arr
 
     for (size_t i = 0; i < count; ++i) {
         /* Skip whitespace to next word */
-        while (cur < line_end && is_space(*cur))
-            ++cur;
+        cur = skip_space(cur, line_end);
         /* Check if eol reached */
         if (cur == line_end)
             break;
-        arr[i] = parse_float((const char*)cur, line_end - cur);
-        /* Skip parsed word */
-        while (cur < line_end && !is_space(*cur))
-            ++cur;
+        /* Parse word */
+        const char* wend = skip_word(cur, line_end);
+        arr[i] = parse_float(cur, wend - cur);
+        cur = wend;
+    }
+}
+
+/*-----------------------------------------------------------------
+ * Chunked parsing
+ *-----------------------------------------------------------------*/
+/* Inputs smaller than this are parsed on the calling thread only */
+#define OBJ_PARALLEL_MIN_SZ (4 * 1024 * 1024)
+/* Smallest slice of input handed to a task */
+#define OBJ_CHUNK_MIN_SZ (1024 * 1024)
+/* Chunks per worker, leaves room for stealing when chunks are uneven */
+#define OBJ_CHUNKS_PER_WORKER 4
+
+/* Attribute arrays of the whole file, sized by the counting pass.
+ * Each chunk writes its attributes at its own offset */
+struct obj_attribs {
+    float* positions; /* 3 floats each */
+    float* normals;   /* 3 floats each */
+    float* texcoords; /* 3 floats each */
+    size_t num_positions;
+    size_t num_normals;
+    size_t num_texcoords;
+};
+
+/* Lines whose effect spans chunks are recorded as ops,
+ * replayed in file order to split faces into meshes */
+enum obj_op_type {
+    OBJ_OP_FACES,   /* Run of faces */
+    OBJ_OP_GROUP,   /* o or g line */
+    OBJ_OP_USEMTL,  /* Material change */
+    OBJ_OP_NORMALS  /* Normals were found for the current mesh */
+};
+
+struct obj_op {
+    enum obj_op_type type;
+    size_t begin, end; /* Face range in the chunk */
+    const char* name;  /* Group or material name, points into the input */
+    size_t name_sz;
+};
+
+/* Newline aligned slice of the input parsed by a single task */
+struct obj_chunk {
+    const char* begin;
+    const char* end;
+    /* Attributes defined in the chunk and before it */
+    size_t num_positions, num_normals, num_texcoords;
+    size_t pos_base, nm_base, tex_base;
+    /* Face index triplets, absolute and 1 based (0 for missing) */
+    struct vector faces;
+    struct vector ops;
+    struct obj_attribs* attribs;
+};
+
+enum obj_line_type {
+    OBJ_LINE_OTHER = 0,
+    OBJ_LINE_POSITION,
+    OBJ_LINE_NORMAL,
+    OBJ_LINE_TEXCOORD,
+    OBJ_LINE_FACE,
+    OBJ_LINE_GROUP,
+    OBJ_LINE_USEMTL
+};
+
+/* Classifies a line by its keyword, args is set past the keyword */
+static enum obj_line_type obj_line_type(const char* line, const char* line_end, const char** args)
+{
+    /* Skip leading whitespace */
+    const char* cur = skip_space(line, line_end);
+
+    /* Check if comment or empty line and skip them */
+    if (cur == line_end || *cur == '#')
+        return OBJ_LINE_OTHER;
+
+    /* Find terminator of first word (first whitespace) */
+    const char* wend = skip_word(cur, line_end);
+    size_t kw_sz = wend - cur;
+    *args = wend;
+
+    /* Dispatch on keyword */
+    switch (cur[0]) {
+        case 'v':
+            if (kw_sz == 1)
+                return OBJ_LINE_POSITION;
+            else if (kw_sz == 2 && cur[1] == 'n')
+                return OBJ_LINE_NORMAL;
+            else if (kw_sz == 2 && cur[1] == 't')
+                return OBJ_LINE_TEXCOORD;
+            break;
+        case 'f':
+            if (kw_sz == 1)
+                return OBJ_LINE_FACE;
+            break;
+        case 'o':
+        case 'g':
+            if (kw_sz == 1)
+                return OBJ_LINE_GROUP;
+            break;
+        case 'u':
+            if (kw_sz == 6 && memcmp(cur, "usemtl", 6) == 0)
+                return OBJ_LINE_USEMTL;
+            break;
+    }
+    return OBJ_LINE_OTHER;
+}
+
+/* First pass, counts attributes so that each chunk knows where its
+ * own start and relative indices can be resolved while parsing */
+static void obj_count_task(void* arg, size_t begin, size_t end)
+{
+    struct obj_chunk* chunks = arg;
+    for (size_t i = begin; i < end; ++i) {
+        struct obj_chunk* c = chunks + i;
+        const char* cur = c->begin;
+        while (cur < c->end) {
+            const char* eol = find_eol(cur, c->end);
+            const char* args;
+            switch (obj_line_type(cur, eol, &args)) {
+                case OBJ_LINE_POSITION:
+                    ++c->num_positions;
+                    break;
+                case OBJ_LINE_NORMAL:
+                    ++c->num_normals;
+                    break;
+                case OBJ_LINE_TEXCOORD:
+                    ++c->num_texcoords;
+                    break;
+                default:
+                    break;
+            }
+            cur = eol + 1;
+        }
+    }
+}
+
+/* Makes an index absolute (1 based) given the number of attributes
+ * defined so far. Negative indices count back from the last one */
+static int32_t resolve_index(int32_t idx, size_t count)
+{
+    if (idx >= 0)
+        return idx;
+    int64_t abs_idx = (int64_t)count + idx + 1;
+    return abs_idx > 0 ? (int32_t)abs_idx : 0;
+}
+
+static void chunk_push_op(struct obj_chunk* c, enum obj_op_type type, const char* name, size_t name_sz)
+{
+    struct obj_op op;
+    memset(&op, 0, sizeof(struct obj_op));
+    op.type = type;
+    op.name = name;
+    op.name_sz = name_sz;
+    vector_append(&c->ops, &op);
+}
+
+/* Appends a face and extends the current run of faces */
+static void chunk_push_face(struct obj_chunk* c, const int32_t* f)
+{
+    vector_append(&c->faces, f);
+    struct obj_op* last = c->ops.size ? vector_at(&c->ops, c->ops.size - 1) : 0;
+    if (last && last->type == OBJ_OP_FACES) {
+        last->end = c->faces.size;
+    } else {
+        chunk_push_op(c, OBJ_OP_FACES, 0, 0);
+        last = vector_at(&c->ops, c->ops.size - 1);
+        last->begin = c->faces.size - 1;
+        last->end = c->faces.size;
     }
 }
 
-/* Holds allocation info about current parsing state */
+/* Second pass, parses a chunk writing its attributes in place */
+static void obj_parse_chunk(struct obj_chunk* c)
+{
+    struct obj_attribs* at = c->attribs;
+    size_t npos = 0, nnm = 0, ntex = 0;
+    /* Normals op already recorded since the last group or material change */
+    int normals_marked = 0;
+
+    const char* cur = c->begin;
+    while (cur < c->end) {
+        const char* eol = find_eol(cur, c->end);
+        const char* args;
+        switch (obj_line_type(cur, eol, &args)) {
+            case OBJ_LINE_POSITION: {
+                /* Vertex */
+                /*
+                 * v x y z (w)
+                 * with w being optional and with default value 1.0
+                 */
+                float vvv[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+                parse_space_sep_entry(args, eol - args, vvv, 4);
+                memcpy(at->positions + 3 * (c->pos_base + npos++), vvv, 3 * sizeof(float));
+                break;
+            }
+            case OBJ_LINE_NORMAL: {
+                /* Vertex normal */
+                /*
+                 * vn i j k
+                 */
+                float vn[3] = { 0.0f, 0.0f, 0.0f };
+                parse_space_sep_entry(args, eol - args, vn, 3);
+                memcpy(at->normals + 3 * (c->nm_base + nnm++), vn, 3 * sizeof(float));
+                if (!normals_marked) {
+                    chunk_push_op(c, OBJ_OP_NORMALS, 0, 0);
+                    normals_marked = 1;
+                }
+                break;
+            }
+            case OBJ_LINE_TEXCOORD: {
+                /* Texture coordinates */
+                /*
+                 * vt u (v) (w)
+                 * with v, w being optional with default values of 0
+                 */
+                float vt[3] = { 0.0f, 0.0f, 0.0f };
+                parse_space_sep_entry(args, eol - args, vt, 3);
+                memcpy(at->texcoords + 3 * (c->tex_base + ntex++), vt, 3 * sizeof(float));
+                break;
+            }
+            case OBJ_LINE_FACE: {
+                /* Vertex index */
+                /*
+                 * f v/vt/vn v/vt/vn v/vt/vn
+                 * with vt and vn being optional
+                 * Negative reference numbers for v can be used
+                 */
+                const int max_face_vertices = 16;
+                int32_t f[3 * max_face_vertices];
+                memset(f, 0, sizeof(f));
+                int i = 0;
+                const char* fc = args;
+                for (;;) {
+                    /* Skip whitespace to next word */
+                    fc = skip_space(fc, eol);
+                    /* Check if eol reached */
+                    if (fc == eol)
+                        break;
+                    assert(i < max_face_vertices);
+                    /* Parse the triple and make it absolute */
+                    const char* tend = skip_word(fc, eol);
+                    int32_t* t = f + i * 3;
+                    parse_face_triple(fc, tend - fc, t);
+                    t[0] = resolve_index(t[0], c->pos_base + npos);
+                    t[1] = resolve_index(t[1], c->tex_base + ntex);
+                    t[2] = resolve_index(t[2], c->nm_base + nnm);
+                    fc = tend;
+                    /* Quad or more need additional face per triple */
+                    if (i >= 3) {
+                        int32_t g[9];
+                        memcpy(g + 0, f + i * 3, 3 * sizeof(int32_t));
+                        memcpy(g + 3, f + 0, 3 * sizeof(int32_t));
+                        memcpy(g + 6, f + (i - 1) * 3, 3 * sizeof(int32_t));
+                        chunk_push_face(c, g);
+                    }
+                    ++i;
+                }
+                /* Store data */
+                chunk_push_face(c, f);
+                break;
+            }
+            case OBJ_LINE_GROUP: {
+                /* Object or group name, up to the end of line */
+                const char* name = skip_space(args, eol);
+                const char* name_end = eol;
+                while (name_end > name && is_space(*(name_end - 1)))
+                    --name_end;
+                chunk_push_op(c, OBJ_OP_GROUP, name, name_end - name);
+                normals_marked = 0;
+                break;
+            }
+            case OBJ_LINE_USEMTL: {
+                /* Material name */
+                const char* name = skip_space(args, eol);
+                const char* name_end = skip_word(name, eol);
+                chunk_push_op(c, OBJ_OP_USEMTL, name, name_end - name);
+                normals_marked = 0;
+                break;
+            }
+            case OBJ_LINE_OTHER:
+                break;
+        }
+        /* Advance current position */
+        cur = eol + 1;
+    }
+}
+
+static void obj_parse_task(void* arg, size_t begin, size_t end)
+{
+    struct obj_chunk* chunks = arg;
+    for (size_t i = begin; i < end; ++i)
+        obj_parse_chunk(chunks + i);
+}
+
+/* Splits input at newlines into at most max_chunks slices of similar size */
+static size_t obj_split_chunks(const char* data, size_t sz, struct obj_chunk* chunks, size_t max_chunks)
+{
+    const char* cur = data;
+    const char* end = data + sz;
+    size_t target = sz / max_chunks;
+    size_t n = 0;
+    while (cur < end) {
+        const char* cend = end;
+        if (n + 1 < max_chunks && (size_t)(end - cur) > target) {
+            cend = find_eol(cur + target, end);
+            if (cend < end)
+                ++cend; /* Keep the newline */
+        }
+        memset(chunks + n, 0, sizeof(struct obj_chunk));
+        chunks[n].begin = cur;
+        chunks[n].end = cend;
+        vector_init(&chunks[n].faces, 9 * sizeof(int32_t));
+        vector_init(&chunks[n].ops, sizeof(struct obj_op));
+        ++n;
+        cur = cend;
+    }
+    return n;
+}
+
+/*-----------------------------------------------------------------
+ * Mesh construction
+ *-----------------------------------------------------------------*/
+/* Contiguous faces of a chunk */
+struct face_span {
+    const int32_t* faces;
+    size_t num_faces;
+};
+
+/* Holds allocation info about current mesh building state */
 struct parser_state {
-    struct vector positions; /* Array of mesh positions */
-    struct vector normals;   /* Array of mesh normals */
-    struct vector texcoords; /* Array of mesh texture coordinates */
-    struct vector faces;     /* Array of face indice triplets */
+    struct obj_attribs* attribs;
+    struct vector spans; /* Face spans of the mesh being gathered */
+    size_t num_faces;    /* Total faces in spans */
     struct hashmap found_materials; /* Hashmap of already found materials */
+    struct asset_arena* scratch;    /* Backs found material names */
     int mat_id_cnt;  /* Material id counter */
     int cur_mat_idx; /* Current material index set to meshes when being flushed */
     int has_normals; /* Set if normals found for current mesh */
 };
 
-static size_t indice_hash(hm_ptr key)
+/* Copies attribute of given 1 based index, if it exists */
+static void copy_attrib(float* dst, const float* arr, size_t count, int32_t idx, size_t num_comps)
 {
-    int32_t* k = (int32_t*) hm_pcast(key);
-    return (size_t) k[0] ^ k[1] ^ k[2];
-}
-
-static int indice_eql(hm_ptr k1, hm_ptr k2)
-{
-    return memcmp(hm_pcast(k1), hm_pcast(k2), 3 * sizeof(int32_t)) == 0; /* Compare obj vertex index triplets */
+    if (idx > 0 && (size_t)idx <= count)
+        memcpy(dst, arr + 3 * (idx - 1), num_comps * sizeof(float));
 }
 
 static struct mesh* mesh_from_parser_state(struct parser_state* ps)
 {
+    struct obj_attribs* at = ps->attribs;
+
     /* Create mesh */
     struct mesh* mesh = mesh_new();
     mesh->num_verts = 0;
     mesh->num_indices = 0;
-    /* Allocate top limit */
-    mesh->vertices = realloc(mesh->vertices, ps->faces.size * 3 * sizeof(struct vertex));
-    mesh->indices = realloc(mesh->indices, ps->faces.size * 3 * sizeof(uint32_t));
+    /* Indices are exact, vertices grow as unique triples are found */
+    size_t vert_cap = ps->num_faces / 2 + 16;
+    mesh->vertices = asset_realloc(mesh->vertices, vert_cap * sizeof(struct vertex));
+    mesh->indices = asset_realloc(mesh->indices, ps->num_faces * 3 * sizeof(uint32_t));
 
     /* Used to find and reuse indices of already stored vertices */
-    struct hashmap stored_vertices;
-    hashmap_init(&stored_vertices, indice_hash, indice_eql);
+    struct welder stored_vertices;
+    welder_init(&stored_vertices, ps->num_faces * 3, 3 * sizeof(int32_t), 0);
 
     /* Iterate through triples */
-    for (size_t i = 0; i < ps->faces.size; ++i) {
-        /* Iterate as a triangle face */
-        for (size_t j = 0; j < 3; ++j) {
-            /* Vertex indices */
-            int32_t* vi = (int32_t*)vector_at(&ps->faces, i) + 3 * j;
-
-            /* Check if current triple has already been stored */
-            hm_ptr* indice = hashmap_get(&stored_vertices, hm_cast(vi));
-            ++mesh->num_indices;
-            if (indice) {
-                mesh->indices[mesh->num_indices - 1] = *((uint32_t*)indice);
-            } else {
-                ++mesh->num_verts;
-                /* Current working vertex */
-                struct vertex* v = mesh->vertices + mesh->num_verts - 1;
-
-                /* Store position data */
-                int32_t pos_index = vi[0];
-                if (pos_index != 0) {
-                    pos_index = pos_index > 0 ? pos_index - 1 : (int32_t)(ps->positions.size + pos_index);
-                    memcpy(v->position, vector_at(&ps->positions, pos_index), 3 * sizeof(float));
+    for (size_t s = 0; s < ps->spans.size; ++s) {
+        struct face_span* span = vector_at(&ps->spans, s);
+        for (size_t i = 0; i < span->num_faces; ++i) {
+            /* Iterate as a triangle face */
+            for (size_t j = 0; j < 3; ++j) {
+                /* Vertex indices */
+                const int32_t* vi = span->faces + 9 * i + 3 * j;
+
+                /* Find or store current triple */
+                int is_new;
+                uint32_t idx = welder_weld(&stored_vertices, vi, &is_new);
+                mesh->indices[mesh->num_indices++] = idx;
+                if (is_new) {
+                    if (mesh->num_verts == vert_cap) {
+                        vert_cap *= 2;
+                        mesh->vertices = asset_realloc(mesh->vertices, vert_cap * sizeof(struct vertex));
+                    }
+                    ++mesh->num_verts;
+                    /* Current working vertex */
+                    struct vertex* v = mesh->vertices + idx;
+                    memset(v, 0, sizeof(struct vertex));
+
+                    /* Store position, texture and normal data */
+                    copy_attrib(v->position, at->positions, at->num_positions, vi[0], 3);
+                    copy_attrib(v->uvs, at->texcoords, at->num_texcoords, vi[1], 2);
+                    copy_attrib(v->normal, at->normals, at->num_normals, vi[2], 3);
                 }
-
-                /* Store texture data */
-                int32_t tex_index = vi[1];
-                if (tex_index != 0) {
-                    tex_index = tex_index > 0 ? tex_index - 1 : (int32_t)(ps->texcoords.size + tex_index);
-                    memcpy(v->uvs, vector_at(&ps->texcoords, tex_index), 2 * sizeof(float));
-                }
-
-                /* Store normal data */
-                int32_t nm_index = vi[2];
-                if (nm_index != 0) {
-                    nm_index = nm_index > 0 ? nm_index - 1 : (int32_t)(ps->normals.size + nm_index);
-                    memcpy(v->normal, vector_at(&ps->normals, nm_index), 3 * sizeof(float));
-                }
-
-                /* Store new vertice index into indices array */
-                mesh->indices[mesh->num_indices - 1] = mesh->num_verts - 1;
-                /* Store face triple ptr to lookup table */
-                hashmap_put(&stored_vertices, hm_cast(vi), hm_cast(mesh->num_verts - 1));
             }
         }
     }
-    hashmap_destroy(&stored_vertices);
+    welder_destroy(&stored_vertices);
+    mesh_shrink_to_fit(mesh);
     mesh->mat_index = ps->cur_mat_idx;
     return mesh;
 }
 
-static void flush_mgroup(const char* name, struct model* m)
+static void flush_mgroup(const char* name, size_t name_sz, struct model* m)
 {
     struct mesh_group* mgroup = mesh_group_new();
-    mgroup->name = strdup(name);
+    char* gname = asset_malloc(name_sz + 1);
+    memcpy(gname, name, name_sz);
+    gname[name_sz] = '\0';
+    mgroup->name = gname;
     m->num_mesh_groups++;
-    m->mesh_groups = realloc(m->mesh_groups, m->num_mesh_groups * sizeof(struct mesh_group*));
+    m->mesh_groups = asset_realloc(m->mesh_groups, m->num_mesh_groups * sizeof(struct mesh_group*));
     m->mesh_groups[m->num_mesh_groups - 1] = mgroup;
 }
 
@@ -170,16 +508,18 @@ static void flush_mesh(struct parser_state* ps, struct model* m)
 {
     /* Create new mesh entry from parser state */
     m->num_meshes++;
-    m->meshes = realloc(m->meshes, m->num_meshes * sizeof(struct mesh*));
+    m->meshes = asset_realloc(m->meshes, m->num_meshes * sizeof(struct mesh*));
+    uint64_t t0 = stats_phase_begin();
     m->meshes[m->num_meshes - 1] = mesh_from_parser_state(ps);
+    stats_phase_end(ASSET_PHASE_WELD, t0);
 
     /* Lazily create root mesh group */
     struct mesh_group* mgroup = 0;
     if (!m->num_mesh_groups) {
         mgroup = mesh_group_new();
-        mgroup->name = strdup("root_group");
+        mgroup->name = asset_strdup("root_group");
         m->num_mesh_groups++;
-        m->mesh_groups = realloc(m->mesh_groups, m->num_mesh_groups * sizeof(struct mesh_group*));
+        m->mesh_groups = asset_realloc(m->mesh_groups, m->num_mesh_groups * sizeof(struct mesh_group*));
         m->mesh_groups[m->num_mesh_groups - 1] = mgroup;
     } else {
         mgroup = m->mesh_groups[m->num_mesh_groups - 1];
@@ -190,12 +530,15 @@ static void flush_mesh(struct parser_state* ps, struct model* m)
     /* Generate normals if needed */
     if (!ps->has_normals)
         mesh_generate_normals(m->meshes[m->num_meshes - 1]);
+    /* Reorder for post transform cache and vertex fetch locality */
+    mesh_optimize_vertex_cache(m->meshes[m->num_meshes - 1]);
+    mesh_optimize_vertex_fetch(m->meshes[m->num_meshes - 1]);
     /* Reset mesh specific flags */
     ps->has_normals = 0;
 
     /* Clear gathered faces */
-    vector_destroy(&ps->faces);
-    vector_init(&ps->faces, 9 * sizeof(int32_t));
+    vector_clear(&ps->spans);
+    ps->num_faces = 0;
 }
 
 static size_t found_materials_hash(hm_ptr key)
@@ -213,196 +556,103 @@ static int found_materials_eql(hm_ptr k1, hm_ptr k2)
     return strcmp((const char*)hm_pcast(k1), (const char*)hm_pcast(k2)) == 0;
 }
 
-static void found_materials_iter(hm_ptr key, hm_ptr value)
+static void use_material(struct parser_state* ps, const char* name, size_t name_sz)
 {
-    (void) value;
-    free(hm_pcast(key));
+    /* Copy material name to new buffer */
+    char* material = asset_arena_alloc(ps->scratch, name_sz + 1);
+    memcpy(material, name, name_sz * sizeof(char));
+    material[name_sz] = '\0';
+    /* Check if material is already found */
+    hm_ptr* fmat = hashmap_get(&ps->found_materials, hm_cast(material));
+    if (fmat) {
+        ps->cur_mat_idx = *(int*)fmat;
+    } else {
+        ps->cur_mat_idx = ps->mat_id_cnt++;
+        hashmap_put(&ps->found_materials, hm_cast(material), hm_cast(ps->mat_id_cnt - 1));
+    }
 }
 
-/* line is null terminated buffer and line_sz is the buffer length with the null terminator */
-static void parse_line(struct parser_state* ps, struct model* m, const unsigned char* line, size_t line_sz)
+/* Replays the ops of a chunk, in file order */
+static void replay_chunk_ops(struct parser_state* ps, struct model* m, struct obj_chunk* c)
 {
-    /* Limit to avoid buffer overreads */
-    const unsigned char* line_end = line + line_sz;
-    /* Running pointer */
-    const unsigned char* cur = line;
-
-    /* Skip leading whitespace */
-    while (cur < line_end && is_space(*cur))
-        ++cur;
-
-    /* Check if comment or empty line and skip them */
-    if (cur == line_end - 1 || *cur == '#')
-        return;
-
-    /* Find terminator of first word (first whitespace) */
-    const unsigned char* wend = cur;
-    while(wend < line_end && !is_space(*wend))
-        ++wend;
-    size_t next_word_sz = wend - cur;
-
-    if (strncmp("v", (const char*)cur, next_word_sz) == 0) {
-        /* Vertex */
-        /*
-         * v x y z (w)
-         * with w being optional and with default value 1.0
-         */
-        ++cur;
-
-        /* Parse entry data */
-        float vvv[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
-        parse_space_sep_entry((const char*)cur, line_end - cur, vvv, 4);
-
-        /* Store parsed positions */
-        vector_append(&ps->positions, vvv);
-    } else if (strncmp("vn", (const char*) cur, next_word_sz) == 0) {
-        /* Vertex normal */
-        /*
-         * vn i j k
-         */
-        cur += 2;
-
-        /* Parse entry data */
-        float vn[3] = { 0.0f, 0.0f, 0.0f };
-        parse_space_sep_entry((const char*)cur, line_end - cur, vn, 3);
-
-        /* Store data */
-        vector_append(&ps->normals, vn);
-        ps->has_normals = 1; /* Set normal found flag */
-    } else if (strncmp("vt", (const char*) cur, next_word_sz) == 0) {
-        /* Texture coordinates */
-        /*
-         * vt u (v) (w)
-         * with v, w being optional with default values of 0
-         */
-        cur += 2;
-
-        /* Parse entry data */
-        float vt[3] = { 0.0f, 0.0f, 0.0f };
-        parse_space_sep_entry((const char*)cur, line_end - cur, vt, 3);
-
-        /* Store data */
-        vector_append(&ps->texcoords, vt);
-    } else if (strncmp("f", (const char*) cur, next_word_sz) == 0) {
-        /* Vertex index */
-        /*
-         * f v/vt/vn v/vt/vn v/vt/vn
-         * with vt and vn being optional
-         * Negative reference numbers for v can be used
-         */
-        ++cur;
-        const int max_face_vertices = 16;
-        int32_t f[3 * max_face_vertices];
-        memset(f, 0, sizeof(f));
-        int i = 0;
-        while (cur != line_end) {
-            assert(i < max_face_vertices);
-            /* Skip whitespace to next word */
-            while (cur < line_end && is_space(*cur))
-                ++cur;
-            /* Check if eol reached */
-            if (cur == line_end - 1)
+    for (size_t i = 0; i < c->ops.size; ++i) {
+        struct obj_op* op = vector_at(&c->ops, i);
+        switch (op->type) {
+            case OBJ_OP_FACES: {
+                struct face_span span;
+                span.faces = vector_at(&c->faces, op->begin);
+                span.num_faces = op->end - op->begin;
+                vector_append(&ps->spans, &span);
+                ps->num_faces += span.num_faces;
                 break;
-            /* Find end of current triple */
-            const unsigned char* tend = cur;
-            while (tend < line_end && !is_space(*tend))
-                ++tend;
-            /* Parse the triple */
-            parse_face_triple((const char*)cur, tend - cur, f + i * 3);
-            /* Skip parsed word */
-            while (cur < line_end && !is_space(*cur))
-                ++cur;
-            /* Quad or more need additional face per triple */
-            if (i >= 3) {
-                int32_t g[9];
-                memcpy(g + 0, f + i * 3, 3 * sizeof(float));
-                memcpy(g + 3, f + 0, 3 * sizeof(float));
-                memcpy(g + 6, f + (i - 1) * 3, 3 * sizeof(float));
-                vector_append(&ps->faces, g);
             }
-            ++i;
-        }
-
-        /* Store data */
-        vector_append(&ps->faces, f);
-    } else if (strncmp("o", (const char*) cur, next_word_sz) == 0) {
-        const unsigned char* name = cur + next_word_sz;
-        while(name < line_end && is_space(*name))
-            ++name;
-        flush_mgroup((const char*)name, m);
-        if (ps->faces.size > 0)
-            flush_mesh(ps, m);
-    } else if (strncmp("g", (const char*) cur, next_word_sz) == 0) {
-        const unsigned char* name = cur + next_word_sz;
-        while(name < line_end && is_space(*name))
-            ++name;
-        flush_mgroup((const char*)name, m);
-        if (ps->faces.size > 0)
-            flush_mesh(ps, m);
-    } else if (strncmp("usemtl", (const char*) cur, next_word_sz) == 0) {
-        /* Flush, as a new material is comming into use */
-        if (ps->faces.size > 0)
-            flush_mesh(ps, m);
-        /* Skip space after keyword */
-        cur += 6;
-        /* Skip whitespace to next word */
-        while (cur < line_end && is_space(*cur))
-            ++cur;
-        /* Find the end of the material name */
-        const unsigned char* we = cur;
-        while (we < line_end && !is_space(*we))
-            ++we;
-        /* Copy material name to new buffer */
-        char* material = calloc(we - cur + 1, sizeof(char));
-        memcpy(material, cur, (we - cur) * sizeof(char));
-        /* Check if material is already found */
-        hm_ptr* fmat = hashmap_get(&ps->found_materials, hm_cast(material));
-        if (fmat) {
-            free(material);
-            ps->cur_mat_idx = *(int*)fmat;
-        } else {
-            ps->cur_mat_idx = ps->mat_id_cnt++;
-            hashmap_put(&ps->found_materials, hm_cast(material), hm_cast(ps->mat_id_cnt - 1));
+            case OBJ_OP_GROUP:
+                flush_mgroup(op->name, op->name_sz, m);
+                if (ps->num_faces > 0)
+                    flush_mesh(ps, m);
+                break;
+            case OBJ_OP_USEMTL:
+                /* Flush, as a new material is comming into use */
+                if (ps->num_faces > 0)
+                    flush_mesh(ps, m);
+                use_material(ps, op->name, op->name_sz);
+                break;
+            case OBJ_OP_NORMALS:
+                ps->has_normals = 1;
+                break;
         }
     }
 }
 
 struct model* model_from_obj(const unsigned char* data, size_t sz)
 {
-    /* Pointer to the current reading position */
-    unsigned char* cur = (unsigned char*) data;
+    /* Big inputs are split at line boundaries and parsed in parallel */
+    size_t max_chunks = 1;
+    if (sz >= OBJ_PARALLEL_MIN_SZ) {
+        tp_ensure_started();
+        max_chunks = tp_num_workers() * OBJ_CHUNKS_PER_WORKER;
+        if (max_chunks > sz / OBJ_CHUNK_MIN_SZ)
+            max_chunks = sz / OBJ_CHUNK_MIN_SZ;
+        if (max_chunks == 0)
+            max_chunks = 1;
+    }
+    struct obj_chunk* chunks = malloc(max_chunks * sizeof(struct obj_chunk));
+    size_t num_chunks = obj_split_chunks((const char*)data, sz, chunks, max_chunks);
+
+    /* Count attributes and give each chunk its offsets */
+    struct obj_attribs attribs;
+    memset(&attribs, 0, sizeof(struct obj_attribs));
+    tp_parallel_for(num_chunks, 1, obj_count_task, chunks);
+    for (size_t i = 0; i < num_chunks; ++i) {
+        struct obj_chunk* c = chunks + i;
+        c->pos_base = attribs.num_positions;
+        c->nm_base = attribs.num_normals;
+        c->tex_base = attribs.num_texcoords;
+        attribs.num_positions += c->num_positions;
+        attribs.num_normals += c->num_normals;
+        attribs.num_texcoords += c->num_texcoords;
+        c->attribs = &attribs;
+    }
+    attribs.positions = malloc(attribs.num_positions * 3 * sizeof(float));
+    attribs.normals = malloc(attribs.num_normals * 3 * sizeof(float));
+    attribs.texcoords = malloc(attribs.num_texcoords * 3 * sizeof(float));
+
+    /* Parse */
+    tp_parallel_for(num_chunks, 1, obj_parse_task, chunks);
 
     /* Create model object */
     struct model* m = model_new();
-    /* Create initial parsing state object */
+    /* Create mesh building state object */
     struct parser_state ps;
     memset(&ps, 0, sizeof(struct parser_state));
-
-    /* Initialize parser state vectors */
-    vector_init(&ps.positions, 3 * sizeof(float));
-    vector_init(&ps.normals, 3 * sizeof(float));
-    vector_init(&ps.texcoords, 3 * sizeof(float));
-    vector_init(&ps.faces, 9 * sizeof(int32_t));
+    ps.attribs = &attribs;
+    vector_init(&ps.spans, sizeof(struct face_span));
     hashmap_init(&ps.found_materials, found_materials_hash, found_materials_eql);
+    ps.scratch = asset_arena_create(4 * 1024);
 
-    /* Read line by line */
-    while (cur <= data + sz) {
-        /* Set end of line point */
-        unsigned char* eol = cur;
-        while ((eol < data + sz) && *eol != '\n')
-            ++eol;
-
-        /* Process line */
-        size_t line_sz = eol - cur + 1;
-        unsigned char* line_buf = malloc(line_sz);
-        memcpy(line_buf, cur, eol - cur);
-        *(line_buf + line_sz - 1) = '\0'; /* Overwrite \n with \0 */
-        parse_line(&ps, m, line_buf, line_sz);
-        free(line_buf);
-
-        /* Advance current position */
-        cur = eol + 1;
-    }
+    /* Split faces into meshes */
+    for (size_t i = 0; i < num_chunks; ++i)
+        replay_chunk_ops(&ps, m, chunks + i);
 
     /* Flush final mesh */
     flush_mesh(&ps, m);
@@ -410,13 +660,18 @@ struct model* model_from_obj(const unsigned char* data, size_t sz)
     /* Total materials */
     m->num_materials = ps.found_materials.size;
 
-    /* Deallocate parser state arrays */
-    hashmap_iter(&ps.found_materials, found_materials_iter);
+    /* Deallocate parser state */
     hashmap_destroy(&ps.found_materials);
-    vector_destroy(&ps.positions);
-    vector_destroy(&ps.normals);
-    vector_destroy(&ps.texcoords);
-    vector_destroy(&ps.faces);
+    asset_arena_destroy(ps.scratch);
+    vector_destroy(&ps.spans);
+    for (size_t i = 0; i < num_chunks; ++i) {
+        vector_destroy(&chunks[i].faces);
+        vector_destroy(&chunks[i].ops);
+    }
+    free(chunks);
+    free(attribs.positions);
+    free(attribs.normals);
+    free(attribs.texcoords);
 
     return m;
 }
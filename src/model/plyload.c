@@ -1,10 +1,13 @@
 #include "assets/model/model.h"
+#include "assets/model/modelload.h"
+#include "assets/error.h"
+#include "assets/allocator.h"
 #include <assert.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdint.h>
-#include <stdio.h>
 #include <assets/model/postprocess.h>
+#include "../strconv.h"
 
 /*-----------------------------------------------------------------
  * Data iterator
@@ -114,6 +117,8 @@ struct ply_header {
     struct { int maj, min; } ver;
     struct ply_element* elems;
     unsigned long nelems;
+    /* Backs names, properties and elements, released in one go */
+    struct asset_arena* scratch;
 };
 
 struct ply_data {
@@ -133,7 +138,7 @@ static enum ply_prop_type ply_prop_dtype_read(struct data_iterator* it)
     return i;
 }
 
-static int ply_prop_read(struct ply_property* pp, struct data_iterator* it)
+static int ply_prop_read(struct ply_property* pp, struct data_iterator* it, struct asset_arena* scratch)
 {
     /* Skip "property" word */
     it_fwnw(it);
@@ -157,35 +162,41 @@ static int ply_prop_read(struct ply_property* pp, struct data_iterator* it)
 
     /* Read property name */
     int wsz = it_cntw(it);
-    pp->name = calloc(1, wsz + 1);
-    strncpy((char*)pp->name, (const char*)it->cur, wsz);
+    char* name = asset_arena_alloc(scratch, wsz + 1);
+    memcpy(name, it->cur, wsz);
+    name[wsz] = 0;
+    pp->name = name;
     it_fwl(it);
     return 0;
 }
 
-static int ply_elem_read(struct ply_element* pe, struct data_iterator* it)
+static int ply_elem_read(struct ply_element* pe, struct data_iterator* it, struct asset_arena* scratch)
 {
     /* Skip "element" word */
     it_fwnw(it);
 
     /* Read element name */
     int wsz = it_cntw(it);
-    pe->name = calloc(1, wsz + 1);
-    strncpy((char*)pe->name, (const char*)it->cur, wsz);
+    char* name = asset_arena_alloc(scratch, wsz + 1);
+    memcpy(name, it->cur, wsz);
+    name[wsz] = 0;
+    pe->name = name;
     it_fwnw(it);
 
     /* Read element count */
-    pe->nentries = atol((const char*)it->cur);
+    long nentries = 0;
+    str_to_long((const char*)it->cur, (const char*)it->lim, &nentries);
+    pe->nentries = nentries > 0 ? (unsigned long)nentries : 0;
     it_fwl(it);
 
     /* Read properties */
     while (it_cmpw(it, "property")) {
         /* Allocate and read property */
         pe->nprops++;
-        pe->props = realloc(pe->props, pe->nprops * sizeof(*pe->props));
+        pe->props = asset_arena_realloc(scratch, pe->props, pe->nprops * sizeof(*pe->props));
         struct ply_property* pp = pe->props + (pe->nprops - 1);
         memset(pp, 0, sizeof(*pp));
-        ply_prop_read(pp, it);
+        ply_prop_read(pp, it, scratch);
     }
     return 0;
 }
@@ -194,6 +205,7 @@ static int ply_header_read(struct ply_header* ph, struct data_iterator* it)
 {
     /* Zero out */
     memset(ph, 0, sizeof(*ph));
+    ph->scratch = asset_arena_create(16 * 1024);
 
     /* Read format */
     if (!it_cmpw(it, "format"))
@@ -211,9 +223,12 @@ static int ply_header_read(struct ply_header* ph, struct data_iterator* it)
     it_fwnw(it);
 
     /* Read version */
-    ph->ver.maj = atoi((const char*)it->cur);
-    it_fwb(it);
-    ph->ver.min = atoi((const char*)it->cur);
+    long maj = 0, min = 0;
+    const char* vp = str_to_long((const char*)it->cur, (const char*)it->lim, &maj);
+    if (vp < (const char*)it->lim && *vp == '.')
+        str_to_long(vp + 1, (const char*)it->lim, &min);
+    ph->ver.maj = (int)maj;
+    ph->ver.min = (int)min;
     it_fwl(it);
 
     /* Skip comments */
@@ -226,10 +241,10 @@ static int ply_header_read(struct ply_header* ph, struct data_iterator* it)
             return 1;
         /* Allocate and read element */
         ph->nelems++;
-        ph->elems = realloc(ph->elems, ph->nelems * sizeof(*ph->elems));
+        ph->elems = asset_arena_realloc(ph->scratch, ph->elems, ph->nelems * sizeof(*ph->elems));
         struct ply_element* pe = ph->elems + (ph->nelems - 1);
         memset(pe, 0, sizeof(*pe));
-        ply_elem_read(pe, it);
+        ply_elem_read(pe, it, ph->scratch);
     }
     it_fwl(it);
     return 0;
@@ -279,10 +294,47 @@ static unsigned long ply_read_list_size(enum ply_prop_type pt, void* data)
     return sz;
 }
 
+static struct ply_property* ply_find_property(struct ply_element* pe, const char* name)
+{
+    struct ply_property* found = 0;
+    for (unsigned long j = 0; j < pe->nprops; ++j)
+        if (strcmp(pe->props[j].name, name) == 0)
+            found = pe->props + j;
+    return found;
+}
+
+/* Number of indices a face or tristrips element expands to, walking only the list sizes */
+static size_t ply_count_indices(struct ply_element* pe, struct ply_property* ve_prop, void* chunk, int strips)
+{
+    if (!ve_prop)
+        return 0;
+    size_t num_indices = 0;
+    unsigned long dsz = ply_prop_type_sizes[ve_prop->dtype];
+    void* curd = chunk;
+    for (unsigned long j = 0; j < pe->nentries; ++j) {
+        unsigned long list_sz = ply_read_list_size(ve_prop->lsz_type, curd);
+        curd += ply_prop_type_sizes[ve_prop->lsz_type];
+        if (!strips) {
+            num_indices += list_sz;
+        } else {
+            /* Each index past the first two of a run adds a triangle */
+            unsigned long run = 0;
+            for (unsigned long k = 0; k < list_sz; ++k) {
+                if (*(int32_t*)(curd + k * dsz) == -1)
+                    run = 0;
+                else if (++run >= 3)
+                    num_indices += 3;
+            }
+        }
+        curd += list_sz * dsz;
+    }
+    return num_indices;
+}
+
 static int ply_data_read(struct ply_data* pd, struct ply_header* ph, struct data_iterator* it)
 {
     pd->nelems = ph->nelems;
-    pd->elem_chunks = calloc(pd->nelems, sizeof(void*));
+    pd->elem_chunks = asset_arena_alloc(ph->scratch, pd->nelems * sizeof(void*));
     for (unsigned long i = 0; i < ph->nelems; ++i) {
         struct ply_element* pe = ph->elems + i;
         if (ph->format != PLY_ASCII) {
@@ -316,28 +368,13 @@ static int ply_data_read(struct ply_data* pd, struct ply_header* ph, struct data
 
 static void ply_header_free(struct ply_header* ph)
 {
-    for (unsigned long i = 0; i < ph->nelems; ++i) {
-        struct ply_element* pe = ph->elems + i;
-        for (unsigned long j = 0; j < pe->nprops; ++j)
-            free((void*)pe->props[j].name);
-        free((void*)pe->name);
-        free(pe->props);
-    }
-    free(ph->elems);
-}
-
-static void ply_data_free(struct ply_data* pd, int from_ascii)
-{
-    if (from_ascii) {
-        for (unsigned long i = 0; i < pd->nelems; ++i) {
-            free(pd->elem_chunks[i]);
-        }
-    }
-    free(pd->elem_chunks);
+    /* Also releases the data chunk table */
+    asset_arena_destroy(ph->scratch);
 }
 
-static struct mesh* ply_read_mesh(struct ply_header* ph, struct ply_data* pd)
+static struct mesh* ply_read_mesh(struct ply_header* ph, struct ply_data* pd, const struct model_output* out)
 {
+    const struct vertex_decl* decl = out ? out->decl : 0;
     struct mesh* mesh = mesh_new();
     for (unsigned long i = 0; i < ph->nelems; ++i) {
         struct ply_element* pe = ph->elems + i;
@@ -345,11 +382,18 @@ static struct mesh* ply_read_mesh(struct ply_header* ph, struct ply_data* pd)
         if (strcmp(pe->name, "vertex") == 0) {
             /* Vertices */
             mesh->num_verts = pe->nentries;
-            mesh->vertices = realloc(mesh->vertices, mesh->num_verts * sizeof(struct vertex));
-            memset(mesh->vertices, 0, mesh->num_verts * sizeof(struct vertex));
+            const struct vertex_element* pos_elem = 0;
+            if (decl) {
+                model_output_streams(out, 0, mesh);
+                model_output_clear_missing(out, mesh, 1u << VERTEX_POSITION);
+                pos_elem = vertex_decl_find(decl, VERTEX_POSITION);
+            } else {
+                mesh->vertices = asset_realloc(mesh->vertices, mesh->num_verts * sizeof(struct vertex));
+                memset(mesh->vertices, 0, mesh->num_verts * sizeof(struct vertex));
+            }
             /* Speedup */
             int entrysz_varies = ply_element_entries_are_variable_size(pe);
-            if (!entrysz_varies) {
+            if (!entrysz_varies && (!decl || pos_elem)) {
                 size_t entry_sz = ply_element_entries_size(pe) / pe->nentries;
                 size_t xyz_ofs[3] = {0, 0, 0};
                 size_t cur_prop_ofs = 0;
@@ -365,33 +409,32 @@ static struct mesh* ply_read_mesh(struct ply_header* ph, struct ply_data* pd)
                 }
                 for (unsigned long j = 0; j < pe->nentries; ++j) {
                     void* entryd = elem_chunk + j * entry_sz;
-                    struct vertex* v = mesh->vertices + j;
-                    v->position[0] = *(float*)(entryd + xyz_ofs[0]);
-                    v->position[1] = *(float*)(entryd + xyz_ofs[1]);
-                    v->position[2] = *(float*)(entryd + xyz_ofs[2]);
+                    float position[3];
+                    position[0] = *(float*)(entryd + xyz_ofs[0]);
+                    position[1] = *(float*)(entryd + xyz_ofs[1]);
+                    position[2] = *(float*)(entryd + xyz_ofs[2]);
+                    if (decl) {
+                        struct vertex_stream* vs = mesh->streams + pos_elem->stream;
+                        vertex_element_write(pos_elem, (unsigned char*)vs->data + j * vs->stride + pos_elem->offset, position);
+                    } else {
+                        memcpy(mesh->vertices[j].position, position, sizeof(position));
+                    }
                 }
             } else {
 
             }
         } else if (strcmp(pe->name, "tristrips") == 0) {
-            /* Triangle Strips */
+            /* Triangle Strips, sized up front */
+            struct ply_property* ve_prop = ply_find_property(pe, "vertex_indices");
             mesh->num_indices = 0;
-            mesh->indices = realloc(mesh->indices, mesh->num_indices * sizeof(uint32_t));
-            struct ply_property* ve_prop = 0;
-            for (unsigned long j = 0; j < pe->nprops; ++j) {
-                struct ply_property* pp = pe->props + j;
-                if (strcmp(pp->name, "vertex_indices") == 0)
-                    ve_prop = pp;
-            }
+            mesh->indices = asset_realloc(mesh->indices, ply_count_indices(pe, ve_prop, elem_chunk, 1) * sizeof(uint32_t));
             void* curd = elem_chunk;
-            for (unsigned long j = 0; j < pe->nentries; ++j) {
+            for (unsigned long j = 0; ve_prop && j < pe->nentries; ++j) {
                 /* Entry's list size */
                 unsigned long list_sz = ply_read_list_size(ve_prop->lsz_type, curd);
                 curd += ply_prop_type_sizes[ve_prop->lsz_type];
                 /* List item size */
                 unsigned long dsz = ply_prop_type_sizes[ve_prop->dtype];
-                /* Grow indice array */
-                mesh->indices = realloc(mesh->indices, (3 * (mesh->num_indices + list_sz)) * sizeof(uint32_t));
                 /* Store indices */
                 int prev[2] = {-1, -1};
                 for (unsigned long k = 0; k < list_sz; ++k) {
@@ -418,24 +461,17 @@ static struct mesh* ply_read_mesh(struct ply_header* ph, struct ply_data* pd)
                 curd += list_sz * dsz;
             }
         } else if (strcmp(pe->name, "face") == 0) {
-            /* Faces */
+            /* Faces, sized up front */
+            struct ply_property* ve_prop = ply_find_property(pe, "vertex_indices");
             mesh->num_indices = 0;
-            mesh->indices = realloc(mesh->indices, mesh->num_indices * sizeof(uint32_t));
-            struct ply_property* ve_prop = 0;
-            for (unsigned long j = 0; j < pe->nprops; ++j) {
-                struct ply_property* pp = pe->props + j;
-                if (strcmp(pp->name, "vertex_indices") == 0)
-                    ve_prop = pp;
-            }
+            mesh->indices = asset_realloc(mesh->indices, ply_count_indices(pe, ve_prop, elem_chunk, 0) * sizeof(uint32_t));
             void* curd = elem_chunk;
-            for (unsigned long j = 0; j < pe->nentries; ++j) {
+            for (unsigned long j = 0; ve_prop && j < pe->nentries; ++j) {
                 /* Entry's list size */
                 unsigned long list_sz = ply_read_list_size(ve_prop->lsz_type, curd);
                 curd += ply_prop_type_sizes[ve_prop->lsz_type];
                 /* List item size */
                 unsigned long dsz = ply_prop_type_sizes[ve_prop->dtype];
-                /* Grow indice array */
-                mesh->indices = realloc(mesh->indices, (mesh->num_indices + list_sz) * sizeof(uint32_t));
                 /* Store indices */
                 for (unsigned long k = 0; k < list_sz; ++k) {
                     int32_t indice = *(int32_t*)(curd + k * dsz);
@@ -448,7 +484,7 @@ static struct mesh* ply_read_mesh(struct ply_header* ph, struct ply_data* pd)
     return mesh;
 }
 
-struct model* model_from_ply(const unsigned char* data, size_t sz)
+struct model* model_from_ply(const unsigned char* data, size_t sz, const struct model_output* out)
 {
     /* Data iterator */
     struct data_iterator it;
@@ -456,7 +492,7 @@ struct model* model_from_ply(const unsigned char* data, size_t sz)
 
     /* Check magic */
     if (it_rem((&it), 4) && strncmp((const char*)data, "ply\n", 4) != 0) {
-        printf("Invalid ply header!\n");
+        set_last_asset_load_error("Invalid ply header");
         return 0;
     }
     it_fwl((&it));
@@ -468,27 +504,99 @@ struct model* model_from_ply(const unsigned char* data, size_t sz)
     ply_data_read(&ply_data, &ply_header, &it);
 
     /* Read mesh */
-    struct mesh* mesh = ply_read_mesh(&ply_header, &ply_data);
-    mesh_generate_normals(mesh);
+    /* Normals are generated from the positions, which needs the full vertices */
+    const struct model_output* direct = out && !vertex_decl_find(out->decl, VERTEX_NORMAL) ? out : 0;
+    struct mesh* mesh = ply_read_mesh(&ply_header, &ply_data, direct);
+    if (!direct)
+        mesh_generate_normals(mesh);
     mesh->mgroup_idx = 0;
 
     /* Setup model struct */
     struct model* m = model_new();
     m->num_meshes++;
-    m->meshes = realloc(m->meshes, m->num_meshes * sizeof(struct mesh*));
+    m->meshes = asset_realloc(m->meshes, m->num_meshes * sizeof(struct mesh*));
     m->meshes[m->num_meshes - 1] = mesh;
     m->num_materials = 1;
 
     /* Create and append the root mesh group */
     struct mesh_group* mgroup = mesh_group_new();
-    mgroup->name = strdup("root_group");
+    mgroup->name = asset_strdup("root_group");
     m->num_mesh_groups++;
-    m->mesh_groups = realloc(m->mesh_groups, m->num_mesh_groups * sizeof(struct mesh_group*));
+    m->mesh_groups = asset_realloc(m->mesh_groups, m->num_mesh_groups * sizeof(struct mesh_group*));
     m->mesh_groups[m->num_mesh_groups - 1] = mgroup;
 
     /* Free header and data */
-    ply_data_free(&ply_data, ply_header.format == PLY_ASCII);
     ply_header_free(&ply_header);
 
     return m;
 }
+
+int model_info_from_ply(const unsigned char* data, size_t sz, struct model_info* info)
+{
+    /* Data iterator */
+    struct data_iterator it;
+    it_init((&it), data, sz);
+
+    /* Check magic */
+    if (sz < 4 || strncmp((const char*)data, "ply\n", 4) != 0) {
+        set_last_asset_load_error("Invalid ply header");
+        return 0;
+    }
+    it_fwl((&it));
+
+    /* Element counts are all in the header, face list
+     * lengths are not so triangles are assumed */
+    struct ply_header ply_header;
+    int err = ply_header_read(&ply_header, &it);
+    for (unsigned long i = 0; i < ply_header.nelems; ++i) {
+        struct ply_element* pe = ply_header.elems + i;
+        if (strcmp(pe->name, "vertex") == 0)
+            info->num_verts = pe->nentries;
+        else if (strcmp(pe->name, "face") == 0)
+            info->num_indices = pe->nentries * 3;
+    }
+    info->num_meshes = 1;
+    ply_header_free(&ply_header);
+    if (err) {
+        set_last_asset_load_error("Invalid ply header");
+        return 0;
+    }
+    return 1;
+}
+
+size_t model_extents_from_ply(const unsigned char* data, size_t sz, struct mesh_extent* extents, size_t max_meshes)
+{
+    /* Data iterator */
+    struct data_iterator it;
+    it_init((&it), data, sz);
+
+    /* Check magic */
+    if (sz < 4 || strncmp((const char*)data, "ply\n", 4) != 0) {
+        set_last_asset_load_error("Invalid ply header");
+        return 0;
+    }
+    it_fwl((&it));
+
+    /* Vertex count is in the header, index count needs a walk over the list sizes */
+    struct ply_header ply_header;
+    if (ply_header_read(&ply_header, &it)) {
+        ply_header_free(&ply_header);
+        set_last_asset_load_error("Invalid ply header");
+        return 0;
+    }
+    struct ply_data ply_data;
+    ply_data_read(&ply_data, &ply_header, &it);
+    struct mesh_extent extent = { 0, 0 };
+    for (unsigned long i = 0; i < ply_header.nelems; ++i) {
+        struct ply_element* pe = ply_header.elems + i;
+        int strips = strcmp(pe->name, "tristrips") == 0;
+        if (strcmp(pe->name, "vertex") == 0)
+            extent.num_verts = pe->nentries;
+        else if (strips || strcmp(pe->name, "face") == 0)
+            extent.num_indices = ply_count_indices(pe, ply_find_property(pe, "vertex_indices"), ply_data.elem_chunks[i], strips);
+    }
+    ply_header_free(&ply_header);
+    if (max_meshes > 0)
+        extents[0] = extent;
+    return 1;
+}
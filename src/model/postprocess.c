@@ -1,4 +1,9 @@
 #include "assets/model/postprocess.h"
+#include "assets/allocator.h"
+#include "simplify.h"
+#include "../stats.h"
+#include "../threadpool.h"
+#include <stdlib.h>
 #include <string.h>
 #include <linalgb.h>
 
@@ -70,6 +75,8 @@ static void vec3_append(float v[3], float val[3]) { v[0] += val[0]; v[1] += val[
 
 void mesh_generate_tangents(struct mesh* m)
 {
+    uint64_t t0 = stats_phase_begin();
+
     /* Clear all tangents to 0,0,0 */
     for (size_t i = 0; i < m->num_verts; i++) {
         memset(m->vertices[i].tangent, 0, sizeof(m->vertices[i].tangent));
@@ -108,10 +115,14 @@ void mesh_generate_tangents(struct mesh* m)
         memcpy(m->vertices[i].tangent, &ntangent, 3 * sizeof(float));
         memcpy(m->vertices[i].binormal, &nbinormal, 3 * sizeof(float));
     }
+
+    stats_phase_end(ASSET_PHASE_POSTPROCESS, t0);
 }
 
 void mesh_generate_normals(struct mesh* m)
 {
+    uint64_t t0 = stats_phase_begin();
+
     /* Clear all normals to 0,0,0 */
     for (size_t i = 0; i < m->num_verts; i++)
         memset(m->vertices[i].normal, 0, sizeof(m->vertices[i].normal));
@@ -141,10 +152,14 @@ void mesh_generate_normals(struct mesh* m)
         vec3 nnormal = vec3_normalize(*(vec3*)m->vertices[i].normal);
         memcpy(m->vertices[i].normal, &nnormal, 3 * sizeof(float));
     }
+
+    stats_phase_end(ASSET_PHASE_POSTPROCESS, t0);
 }
 
 void mesh_generate_orthagonal_tangents(struct mesh* m)
 {
+    uint64_t t0 = stats_phase_begin();
+
     /* Clear all tangents to 0,0,0 */
     for (size_t i = 0; i < m->num_verts; i++) {
         memset(m->vertices[i].tangent, 0, sizeof(m->vertices[i].tangent));
@@ -186,10 +201,14 @@ void mesh_generate_orthagonal_tangents(struct mesh* m)
         memcpy(m->vertices[i].tangent, &ntangent, 3 * sizeof(float));
         memcpy(m->vertices[i].binormal, &nbinormal, 3 * sizeof(float));
     }
+
+    stats_phase_end(ASSET_PHASE_POSTPROCESS, t0);
 }
 
 void mesh_generate_texcoords_cylinder(struct mesh* m)
 {
+    uint64_t t0 = stats_phase_begin();
+
     vec2 unwrap_vector = vec2_new(1, 0);
 
     float max_height = -99999999;
@@ -211,6 +230,264 @@ void mesh_generate_texcoords_cylinder(struct mesh* m)
     float scale = (max_height - min_height);
     for (size_t i = 0; i < m->num_verts; i++)
         m->vertices[i].uvs[1] = m->vertices[i].uvs[1] / scale;
+
+    stats_phase_end(ASSET_PHASE_POSTPROCESS, t0);
+}
+
+/*-----------------------------------------------------------------
+ * Vertex cache and fetch optimization
+ *-----------------------------------------------------------------*/
+/* Tipsify (Sander, Nehab, Barczak 2007), fans triangles around a vertex
+ * and picks the next fanning vertex among the ones just used, favouring
+ * vertices that will still be in cache after their remaining triangles */
+#define VCACHE_SIZE 16
+
+/* Removes triangles with repeated indices, returns new index count */
+static size_t remove_degenerate_triangles(uint32_t* indices, size_t num_indices)
+{
+    size_t n = 0;
+    for (size_t i = 0; i + 2 < num_indices; i += 3) {
+        uint32_t a = indices[i], b = indices[i + 1], c = indices[i + 2];
+        if (a == b || b == c || a == c)
+            continue;
+        indices[n++] = a;
+        indices[n++] = b;
+        indices[n++] = c;
+    }
+    return n;
+}
+
+/* Next vertex to fan around when the candidates run dry, recent
+ * dead ends first and then any vertex with pending triangles */
+static int64_t tipsify_skip_dead_end(const uint32_t* live_tris, uint32_t* dead_end, size_t* dead_end_len, size_t num_verts, size_t* cursor)
+{
+    while (*dead_end_len > 0) {
+        uint32_t d = dead_end[--(*dead_end_len)];
+        if (live_tris[d] > 0)
+            return d;
+    }
+    while (*cursor < num_verts) {
+        if (live_tris[*cursor] > 0)
+            return *cursor;
+        ++(*cursor);
+    }
+    return -1;
+}
+
+/* Reorders a triangle list in place, uses only the standard allocator */
+static void tipsify(uint32_t* indices, size_t num_indices, size_t num_verts)
+{
+    size_t num_tris = num_indices / 3;
+    if (num_tris == 0 || num_verts == 0)
+        return;
+
+    /* Per vertex state */
+    uint32_t* live_tris = calloc(num_verts, sizeof(uint32_t));
+    uint32_t* adj_offsets = malloc((num_verts + 1) * sizeof(uint32_t));
+    uint32_t* cache_time = calloc(num_verts, sizeof(uint32_t));
+    /* Per triangle state */
+    uint32_t* adj_tris = malloc(num_indices * sizeof(uint32_t));
+    unsigned char* emitted = calloc(num_tris, 1);
+    /* Stack of used vertices, and candidates of the current fan */
+    uint32_t* dead_end = malloc(num_indices * sizeof(uint32_t));
+    uint32_t* candidates = malloc(num_indices * sizeof(uint32_t));
+    uint32_t* out = malloc(num_indices * sizeof(uint32_t));
+
+    /* Build vertex to triangle adjacency */
+    for (size_t i = 0; i < num_indices; ++i)
+        ++live_tris[indices[i]];
+    adj_offsets[0] = 0;
+    for (size_t v = 0; v < num_verts; ++v)
+        adj_offsets[v + 1] = adj_offsets[v] + live_tris[v];
+    /* Filled from the back so that triangles are in ascending order,
+     * leaves each offset at the start of its own range */
+    for (size_t i = num_indices; i-- > 0;) {
+        uint32_t v = indices[i];
+        adj_tris[--adj_offsets[v + 1]] = i / 3;
+    }
+    for (size_t v = 0; v < num_verts; ++v)
+        adj_offsets[v + 1] = adj_offsets[v] + live_tris[v];
+
+    size_t num_out = 0, dead_end_len = 0, cursor = 0;
+    uint32_t timestamp = VCACHE_SIZE + 1;
+    int64_t fan = 0;
+    while (fan >= 0) {
+        /* Emit pending triangles around the fanning vertex */
+        size_t num_candidates = 0;
+        for (uint32_t j = adj_offsets[fan]; j < adj_offsets[fan + 1]; ++j) {
+            uint32_t t = adj_tris[j];
+            if (emitted[t])
+                continue;
+            emitted[t] = 1;
+            for (int k = 0; k < 3; ++k) {
+                uint32_t v = indices[3 * t + k];
+                out[num_out++] = v;
+                dead_end[dead_end_len++] = v;
+                candidates[num_candidates++] = v;
+                --live_tris[v];
+                /* Cache miss, vertex is (re)loaded */
+                if (timestamp - cache_time[v] > VCACHE_SIZE)
+                    cache_time[v] = timestamp++;
+            }
+        }
+
+        /* Pick the candidate that will stay longest in cache after its
+         * remaining triangles are emitted, fall back to dead ends */
+        fan = -1;
+        int64_t best = -1;
+        for (size_t i = 0; i < num_candidates; ++i) {
+            uint32_t v = candidates[i];
+            if (live_tris[v] == 0)
+                continue;
+            int64_t p = 0;
+            if (timestamp - cache_time[v] + 2 * live_tris[v] <= VCACHE_SIZE)
+                p = timestamp - cache_time[v];
+            if (p > best) {
+                best = p;
+                fan = v;
+            }
+        }
+        if (fan < 0)
+            fan = tipsify_skip_dead_end(live_tris, dead_end, &dead_end_len, num_verts, &cursor);
+    }
+
+    memcpy(indices, out, num_indices * sizeof(uint32_t));
+    free(out);
+    free(candidates);
+    free(dead_end);
+    free(emitted);
+    free(adj_tris);
+    free(cache_time);
+    free(adj_offsets);
+    free(live_tris);
+}
+
+void mesh_optimize_vertex_cache(struct mesh* m)
+{
+    uint64_t t0 = stats_phase_begin();
+    m->num_indices = remove_degenerate_triangles(m->indices, m->num_indices);
+    tipsify(m->indices, m->num_indices, m->num_verts);
+    mesh_shrink_to_fit(m);
+    stats_phase_end(ASSET_PHASE_POSTPROCESS, t0);
+}
+
+void mesh_optimize_vertex_fetch(struct mesh* m)
+{
+    uint64_t t0 = stats_phase_begin();
+
+    /* Number vertices in order of first use */
+    uint32_t* remap = malloc(m->num_verts * sizeof(uint32_t));
+    memset(remap, 0xFF, m->num_verts * sizeof(uint32_t));
+    uint32_t num_used = 0;
+    for (size_t i = 0; i < m->num_indices; ++i) {
+        uint32_t v = m->indices[i];
+        if (remap[v] == UINT32_MAX)
+            remap[v] = num_used++;
+        m->indices[i] = remap[v];
+    }
+    /* Levels only refer to vertices of the full mesh */
+    for (size_t j = 0; j < m->num_lods; ++j)
+        for (size_t i = 0; i < m->lods[j].num_indices; ++i)
+            m->lods[j].indices[i] = remap[m->lods[j].indices[i]];
+
+    /* Move vertices to their new place, unused ones are dropped */
+    if (num_used) {
+        struct vertex* verts = asset_malloc(num_used * sizeof(struct vertex));
+        for (size_t v = 0; v < m->num_verts; ++v)
+            if (remap[v] != UINT32_MAX)
+                verts[remap[v]] = m->vertices[v];
+        asset_free(m->vertices);
+        m->vertices = verts;
+        if (m->weights) {
+            struct vertex_weight* weights = asset_malloc(num_used * sizeof(struct vertex_weight));
+            for (size_t v = 0; v < m->num_verts; ++v)
+                if (remap[v] != UINT32_MAX)
+                    weights[remap[v]] = m->weights[v];
+            asset_free(m->weights);
+            m->weights = weights;
+        }
+    }
+    m->num_verts = num_used;
+    free(remap);
+
+    stats_phase_end(ASSET_PHASE_POSTPROCESS, t0);
+}
+
+/*-----------------------------------------------------------------
+ * Level of detail
+ *-----------------------------------------------------------------*/
+/* Total indices above which levels are simplified on the thread pool */
+#define LOD_PARALLEL_MIN_INDICES (64 * 1024)
+
+struct lod_task {
+    const struct mesh* mesh;
+    size_t target_indices;
+    uint32_t* indices; /* Result, standard allocator */
+    size_t num_indices;
+};
+
+static void lod_task_run(void* arg, size_t begin, size_t end)
+{
+    struct lod_task* tasks = arg;
+    for (size_t i = begin; i < end; ++i) {
+        struct lod_task* t = tasks + i;
+        const struct mesh* m = t->mesh;
+        t->indices = malloc(m->num_indices * sizeof(uint32_t));
+        t->num_indices = simplify_triangles(t->indices, m->indices, m->num_indices,
+                                            m->vertices, m->weights, m->num_verts, t->target_indices);
+        tipsify(t->indices, t->num_indices, m->num_verts);
+    }
+}
+
+static void generate_lods(struct mesh** meshes, size_t num_meshes, const float* ratios, size_t num_ratios)
+{
+    uint64_t t0 = stats_phase_begin();
+
+    /* Every level is simplified from the full mesh, independently of the others */
+    size_t num_tasks = num_meshes * num_ratios;
+    struct lod_task* tasks = malloc(num_tasks * sizeof(struct lod_task));
+    size_t total_indices = 0;
+    for (size_t i = 0; i < num_meshes; ++i) {
+        for (size_t j = 0; j < num_ratios; ++j) {
+            struct lod_task* t = tasks + i * num_ratios + j;
+            float r = ratios[j] < 0.0f ? 0.0f : (ratios[j] > 1.0f ? 1.0f : ratios[j]);
+            t->mesh = meshes[i];
+            t->target_indices = (size_t)(meshes[i]->num_indices / 3 * r) * 3;
+            t->indices = 0;
+            t->num_indices = 0;
+            total_indices += meshes[i]->num_indices;
+        }
+    }
+    if (total_indices >= LOD_PARALLEL_MIN_INDICES)
+        tp_ensure_started();
+    tp_parallel_for(num_tasks, 1, lod_task_run, tasks);
+
+    /* Store levels, asset allocations stay on the calling thread */
+    for (size_t i = 0; i < num_meshes; ++i) {
+        struct mesh* m = meshes[i];
+        for (size_t j = 0; j < m->num_lods; ++j)
+            asset_free(m->lods[j].indices);
+        asset_free(m->lods);
+        m->lods = num_ratios ? asset_malloc(num_ratios * sizeof(struct mesh_lod)) : 0;
+        m->num_lods = num_ratios;
+        for (size_t j = 0; j < num_ratios; ++j) {
+            struct lod_task* t = tasks + i * num_ratios + j;
+            struct mesh_lod* lod = m->lods + j;
+            lod->num_indices = t->num_indices;
+            lod->indices = t->num_indices ? asset_malloc(t->num_indices * sizeof(uint32_t)) : 0;
+            if (t->num_indices)
+                memcpy(lod->indices, t->indices, t->num_indices * sizeof(uint32_t));
+            free(t->indices);
+        }
+    }
+    free(tasks);
+
+    stats_phase_end(ASSET_PHASE_POSTPROCESS, t0);
+}
+
+void mesh_generate_lods(struct mesh* m, const float* ratios, size_t num_ratios)
+{
+    generate_lods(&m, 1, ratios, num_ratios);
 }
 
 void model_generate_normals(struct model* m)
@@ -236,3 +513,20 @@ void model_generate_texcoords_cylinder(struct model* m)
     for (size_t i = 0; i < m->num_meshes; i++)
         mesh_generate_texcoords_cylinder(m->meshes[i]);
 }
+
+void model_optimize_vertex_cache(struct model* m)
+{
+    for (size_t i = 0; i < m->num_meshes; i++)
+        mesh_optimize_vertex_cache(m->meshes[i]);
+}
+
+void model_optimize_vertex_fetch(struct model* m)
+{
+    for (size_t i = 0; i < m->num_meshes; i++)
+        mesh_optimize_vertex_fetch(m->meshes[i]);
+}
+
+void model_generate_lods(struct model* m, const float* ratios, size_t num_ratios)
+{
+    generate_lods(m->meshes, m->num_meshes, ratios, num_ratios);
+}
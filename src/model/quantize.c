@@ -0,0 +1,160 @@
+#include "assets/model/postprocess.h"
+#include "assets/allocator.h"
+#include "../stats.h"
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+#include <math.h>
+
+static uint16_t unorm16(float v)
+{
+    v = v < 0.0f ? 0.0f : (v > 1.0f ? 1.0f : v);
+    return (uint16_t)(v * 65535.0f + 0.5f);
+}
+
+static int16_t snorm16(float v)
+{
+    v = v < -1.0f ? -1.0f : (v > 1.0f ? 1.0f : v);
+    return (int16_t)lrintf(v * 32767.0f);
+}
+
+static uint8_t unorm8(float v)
+{
+    v = v < 0.0f ? 0.0f : (v > 1.0f ? 1.0f : v);
+    return (uint8_t)(v * 255.0f + 0.5f);
+}
+
+/* Maps a unit vector on the octahedron, folding the lower half over the upper */
+static void oct_encode(int16_t out[2], const float n[3])
+{
+    float l1 = fabsf(n[0]) + fabsf(n[1]) + fabsf(n[2]);
+    if (l1 == 0.0f) {
+        out[0] = out[1] = 0;
+        return;
+    }
+    float x = n[0] / l1, y = n[1] / l1;
+    if (n[2] < 0.0f) {
+        float ox = x;
+        x = (1.0f - fabsf(y)) * (ox >= 0.0f ? 1.0f : -1.0f);
+        y = (1.0f - fabsf(ox)) * (y >= 0.0f ? 1.0f : -1.0f);
+    }
+    out[0] = snorm16(x);
+    out[1] = snorm16(y);
+}
+
+/* Offset and scale covering values of given component */
+static void component_bounds(const struct mesh* m, size_t ofs, size_t num_comps, float* offset, float* scale)
+{
+    for (size_t k = 0; k < num_comps; ++k) {
+        float mn = FLT_MAX, mx = -FLT_MAX;
+        for (size_t v = 0; v < m->num_verts; ++v) {
+            float c = ((const float*)((const unsigned char*)(m->vertices + v) + ofs))[k];
+            mn = c < mn ? c : mn;
+            mx = c > mx ? c : mx;
+        }
+        if (m->num_verts == 0)
+            mn = mx = 0.0f;
+        offset[k] = mn;
+        scale[k] = mx - mn;
+    }
+}
+
+static void quantize_weights(struct qvertex_weight* qw, const struct vertex_weight* w)
+{
+    float total = 0.0f;
+    for (int k = 0; k < 4; ++k)
+        total += w->bone_weights[k] > 0.0f ? w->bone_weights[k] : 0.0f;
+    int sum = 0, largest = 0;
+    for (int k = 0; k < 4; ++k) {
+        float bw = w->bone_weights[k] > 0.0f ? w->bone_weights[k] : 0.0f;
+        qw->bone_ids[k] = (uint8_t)w->bone_ids[k];
+        qw->bone_weights[k] = total > 0.0f ? unorm8(bw / total) : 0;
+        sum += qw->bone_weights[k];
+        if (w->bone_weights[k] > w->bone_weights[largest])
+            largest = k;
+    }
+    /* Rounding leftovers go to the strongest influence */
+    if (total > 0.0f)
+        qw->bone_weights[largest] = (uint8_t)(qw->bone_weights[largest] + 255 - sum);
+}
+
+static uint16_t* indices_to_16(const uint32_t* indices, size_t num_indices)
+{
+    uint16_t* out = asset_malloc(num_indices * sizeof(uint16_t));
+    for (size_t i = 0; i < num_indices; ++i)
+        out[i] = (uint16_t)indices[i];
+    return out;
+}
+
+void mesh_quantize(struct mesh* m)
+{
+    if (m->quant || !m->vertices)
+        return;
+    uint64_t t0 = stats_phase_begin();
+
+    struct mesh_quant* q = asset_calloc(1, sizeof(struct mesh_quant));
+    component_bounds(m, offsetof(struct vertex, position), 3, q->pos_offset, q->pos_scale);
+    component_bounds(m, offsetof(struct vertex, uvs), 2, q->uv_offset, q->uv_scale);
+
+    /* Vertices */
+    q->vertices = asset_malloc(m->num_verts * sizeof(struct qvertex));
+    for (size_t i = 0; i < m->num_verts; ++i) {
+        const struct vertex* v = m->vertices + i;
+        struct qvertex* qv = q->vertices + i;
+        for (int k = 0; k < 3; ++k)
+            qv->position[k] = q->pos_scale[k] > 0.0f ? unorm16((v->position[k] - q->pos_offset[k]) / q->pos_scale[k]) : 0;
+        /* Binormal handedness */
+        const float* n = v->normal;
+        const float* t = v->tangent;
+        float c[3] = { n[1] * t[2] - n[2] * t[1], n[2] * t[0] - n[0] * t[2], n[0] * t[1] - n[1] * t[0] };
+        qv->position[3] = c[0] * v->binormal[0] + c[1] * v->binormal[1] + c[2] * v->binormal[2] < 0.0f;
+        oct_encode(qv->normal, v->normal);
+        oct_encode(qv->tangent, v->tangent);
+        for (int k = 0; k < 2; ++k)
+            qv->uvs[k] = q->uv_scale[k] > 0.0f ? unorm16((v->uvs[k] - q->uv_offset[k]) / q->uv_scale[k]) : 0;
+        for (int k = 0; k < 4; ++k)
+            qv->color[k] = unorm8(v->color[k]);
+    }
+    asset_free(m->vertices);
+    m->vertices = 0;
+
+    /* Weights, kept as they are when bone ids need more than 8 bits */
+    if (m->weights) {
+        int fits = 1;
+        for (size_t i = 0; i < m->num_verts && fits; ++i)
+            for (int k = 0; k < 4; ++k)
+                if (m->weights[i].bone_ids[k] > UINT8_MAX && m->weights[i].bone_weights[k] > 0.0f)
+                    fits = 0;
+        if (fits) {
+            q->weights = asset_malloc(m->num_verts * sizeof(struct qvertex_weight));
+            for (size_t i = 0; i < m->num_verts; ++i)
+                quantize_weights(q->weights + i, m->weights + i);
+            asset_free(m->weights);
+            m->weights = 0;
+        }
+    }
+
+    /* Indices, all of them are below num_verts */
+    if (m->num_verts <= UINT16_MAX + 1) {
+        q->indices = indices_to_16(m->indices, m->num_indices);
+        asset_free(m->indices);
+        m->indices = 0;
+        if (m->num_lods) {
+            q->lod_indices = asset_malloc(m->num_lods * sizeof(uint16_t*));
+            for (size_t j = 0; j < m->num_lods; ++j) {
+                q->lod_indices[j] = indices_to_16(m->lods[j].indices, m->lods[j].num_indices);
+                asset_free(m->lods[j].indices);
+                m->lods[j].indices = 0;
+            }
+        }
+    }
+
+    m->quant = q;
+    stats_phase_end(ASSET_PHASE_POSTPROCESS, t0);
+}
+
+void model_quantize(struct model* m)
+{
+    for (size_t i = 0; i < m->num_meshes; i++)
+        mesh_quantize(m->meshes[i]);
+}
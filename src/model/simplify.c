@@ -0,0 +1,534 @@
+#include "simplify.h"
+#include "weld.h"
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+#include <math.h>
+
+/* Weight of the planes keeping borders and seams in place */
+#define SIMPLIFY_EDGE_WEIGHT 10.0
+/* Collapses of a pass may cost up to this times the error of the last needed one */
+#define SIMPLIFY_PASS_ERROR_BOUND 1.5f
+/* Bits of the error used to order collapses (sign is always 0) */
+#define SIMPLIFY_SORT_BITS 12
+
+#define NO_VERTEX UINT32_MAX
+#define MULTI_VERTEX (UINT32_MAX - 1)
+
+/* Decides which collapses keep outlines and seams intact */
+enum vertex_kind {
+    VK_MANIFOLD, /* Interior vertex, collapses onto any neighbour */
+    VK_BORDER,   /* On an open boundary, collapses along it */
+    VK_SEAM,     /* Shares position with a twin of different attributes,
+                    both collapse along the seam together */
+    VK_LOCKED    /* Never moves */
+};
+
+struct quadric {
+    double a00, a11, a22, a10, a20, a21;
+    double b0, b1, b2, c;
+};
+
+struct collapse {
+    uint32_t v0, v1; /* Vertex v0 moves onto v1 */
+    float error;
+};
+
+struct simplifier {
+    size_t num_verts;
+    float (*pos)[3];          /* Positions normalized to the unit cube */
+    uint32_t* remap;          /* First vertex with the same position */
+    uint32_t* wedge;          /* Next vertex with the same position, circular */
+    uint32_t* bone;           /* Dominant bone per vertex, NO_VERTEX without weights */
+    struct quadric* quadrics; /* Per position, at the remap index */
+    /* Recomputed every pass from the current triangles */
+    uint32_t* adj_offsets;    /* Vertex to triangle adjacency */
+    uint32_t* adj;
+    uint32_t* open_out;       /* Target of the open edge leaving the vertex */
+    uint32_t* open_in;        /* Source of the open edge reaching the vertex */
+    unsigned char* kind;
+    uint32_t* twin;           /* Other vertex of a seam */
+};
+
+/*-----------------------------------------------------------------
+ * Quadrics
+ *-----------------------------------------------------------------*/
+static void quadric_from_plane(struct quadric* q, const double n[3], double d, double w)
+{
+    q->a00 = n[0] * n[0] * w;
+    q->a11 = n[1] * n[1] * w;
+    q->a22 = n[2] * n[2] * w;
+    q->a10 = n[1] * n[0] * w;
+    q->a20 = n[2] * n[0] * w;
+    q->a21 = n[2] * n[1] * w;
+    q->b0 = n[0] * d * w;
+    q->b1 = n[1] * d * w;
+    q->b2 = n[2] * d * w;
+    q->c = d * d * w;
+}
+
+static void quadric_add(struct quadric* q, const struct quadric* r)
+{
+    q->a00 += r->a00;
+    q->a11 += r->a11;
+    q->a22 += r->a22;
+    q->a10 += r->a10;
+    q->a20 += r->a20;
+    q->a21 += r->a21;
+    q->b0 += r->b0;
+    q->b1 += r->b1;
+    q->b2 += r->b2;
+    q->c += r->c;
+}
+
+static float quadric_error(const struct quadric* q, const float p[3])
+{
+    double x = p[0], y = p[1], z = p[2];
+    double rx = q->a00 * x + q->a10 * y + q->a20 * z + q->b0;
+    double ry = q->a10 * x + q->a11 * y + q->a21 * z + q->b1;
+    double rz = q->a20 * x + q->a21 * y + q->a22 * z + q->b2;
+    double r = rx * x + ry * y + rz * z + q->b0 * x + q->b1 * y + q->b2 * z + q->c;
+    return (float)fabs(r);
+}
+
+static void triangle_normal_d(double n[3], const float a[3], const float b[3], const float c[3])
+{
+    double e1[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+    double e2[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+    n[0] = e1[1] * e2[2] - e1[2] * e2[1];
+    n[1] = e1[2] * e2[0] - e1[0] * e2[2];
+    n[2] = e1[0] * e2[1] - e1[1] * e2[0];
+}
+
+/*-----------------------------------------------------------------
+ * Topology
+ *-----------------------------------------------------------------*/
+static void build_adjacency(struct simplifier* s, const uint32_t* indices, size_t num_indices)
+{
+    memset(s->adj_offsets, 0, (s->num_verts + 1) * sizeof(uint32_t));
+    for (size_t i = 0; i < num_indices; ++i)
+        ++s->adj_offsets[indices[i] + 1];
+    for (size_t v = 0; v < s->num_verts; ++v)
+        s->adj_offsets[v + 1] += s->adj_offsets[v];
+    /* Fill using the offsets as cursors, then shift them back */
+    for (size_t i = 0; i < num_indices; ++i)
+        s->adj[s->adj_offsets[indices[i]]++] = i / 3;
+    for (size_t v = s->num_verts; v > 0; --v)
+        s->adj_offsets[v] = s->adj_offsets[v - 1];
+    s->adj_offsets[0] = 0;
+}
+
+static int has_edge(struct simplifier* s, const uint32_t* indices, uint32_t a, uint32_t b)
+{
+    for (uint32_t j = s->adj_offsets[a]; j < s->adj_offsets[a + 1]; ++j) {
+        const uint32_t* tri = indices + 3 * s->adj[j];
+        for (int k = 0; k < 3; ++k)
+            if (tri[k] == a && tri[(k + 1) % 3] == b)
+                return 1;
+    }
+    return 0;
+}
+
+static void classify_vertices(struct simplifier* s, const uint32_t* indices, size_t num_indices)
+{
+    size_t nv = s->num_verts;
+    for (size_t v = 0; v < nv; ++v) {
+        s->open_out[v] = NO_VERTEX;
+        s->open_in[v] = NO_VERTEX;
+    }
+
+    /* Edges without an opposite half edge are open */
+    for (size_t i = 0; i < num_indices; i += 3) {
+        for (int k = 0; k < 3; ++k) {
+            uint32_t a = indices[i + k], b = indices[i + (k + 1) % 3];
+            if (has_edge(s, indices, b, a))
+                continue;
+            s->open_out[a] = s->open_out[a] == NO_VERTEX ? b : MULTI_VERTEX;
+            s->open_in[b] = s->open_in[b] == NO_VERTEX ? a : MULTI_VERTEX;
+        }
+    }
+
+    for (size_t v = 0; v < nv; ++v) {
+        s->twin[v] = NO_VERTEX;
+        if (s->adj_offsets[v] == s->adj_offsets[v + 1]) {
+            s->kind[v] = VK_LOCKED;
+            continue;
+        }
+        /* Count used vertices at the same position */
+        size_t count = 0;
+        uint32_t other = NO_VERTEX;
+        uint32_t w = v;
+        do {
+            if (s->adj_offsets[w] != s->adj_offsets[w + 1]) {
+                ++count;
+                if (w != v)
+                    other = w;
+            }
+            w = s->wedge[w];
+        } while (w != v);
+
+        uint32_t out = s->open_out[v], in = s->open_in[v];
+        if (count == 1) {
+            if (out == NO_VERTEX && in == NO_VERTEX)
+                s->kind[v] = VK_MANIFOLD;
+            else if (out < MULTI_VERTEX && in < MULTI_VERTEX && out != in)
+                s->kind[v] = VK_BORDER;
+            else
+                s->kind[v] = VK_LOCKED;
+        } else if (count == 2) {
+            /* A seam when the open edges of both twins run over the same positions */
+            uint32_t oout = s->open_out[other], oin = s->open_in[other];
+            if (out < MULTI_VERTEX && in < MULTI_VERTEX && oout < MULTI_VERTEX && oin < MULTI_VERTEX
+             && s->remap[out] == s->remap[oin] && s->remap[in] == s->remap[oout]) {
+                s->kind[v] = VK_SEAM;
+                s->twin[v] = other;
+            } else {
+                s->kind[v] = VK_LOCKED;
+            }
+        } else {
+            s->kind[v] = VK_LOCKED;
+        }
+    }
+}
+
+/*-----------------------------------------------------------------
+ * Collapses
+ *-----------------------------------------------------------------*/
+/* Vertex reached from v by its open edges that is at the position of t */
+static uint32_t open_neighbour_at(struct simplifier* s, uint32_t v, uint32_t t)
+{
+    uint32_t r = s->remap[t];
+    if (s->open_out[v] < MULTI_VERTEX && s->remap[s->open_out[v]] == r)
+        return s->open_out[v];
+    if (s->open_in[v] < MULTI_VERTEX && s->remap[s->open_in[v]] == r)
+        return s->open_in[v];
+    return NO_VERTEX;
+}
+
+static int can_collapse(struct simplifier* s, uint32_t v0, uint32_t v1)
+{
+    unsigned char k0 = s->kind[v0], k1 = s->kind[v1];
+    if (s->bone[v0] != s->bone[v1])
+        return 0;
+    switch (k0) {
+        case VK_MANIFOLD:
+            return 1;
+        case VK_BORDER:
+            return (k1 == VK_BORDER || k1 == VK_LOCKED)
+                && (s->open_out[v0] == v1 || s->open_in[v0] == v1);
+        case VK_SEAM: {
+            if (!(k1 == VK_SEAM || k1 == VK_LOCKED)
+             || !(s->open_out[v0] == v1 || s->open_in[v0] == v1))
+                return 0;
+            /* Twin must move along the other side of the seam */
+            uint32_t t1 = open_neighbour_at(s, s->twin[v0], v1);
+            return t1 != NO_VERTEX && s->bone[s->twin[v0]] == s->bone[t1];
+        }
+        default:
+            return 0;
+    }
+}
+
+/* Checks if moving v0 onto v1 turns any of the surrounding triangles over */
+static int has_triangle_flip(struct simplifier* s, const uint32_t* indices, uint32_t v0, uint32_t v1)
+{
+    const float* p1 = s->pos[v1];
+    for (uint32_t j = s->adj_offsets[v0]; j < s->adj_offsets[v0 + 1]; ++j) {
+        const uint32_t* tri = indices + 3 * s->adj[j];
+        /* Triangles over the collapsed edge vanish */
+        if (s->remap[tri[0]] == s->remap[v1] || s->remap[tri[1]] == s->remap[v1] || s->remap[tri[2]] == s->remap[v1])
+            continue;
+        const float* p[3];
+        const float* q[3];
+        for (int k = 0; k < 3; ++k) {
+            p[k] = s->pos[tri[k]];
+            q[k] = tri[k] == v0 ? p1 : p[k];
+        }
+        double nb[3], na[3];
+        triangle_normal_d(nb, p[0], p[1], p[2]);
+        triangle_normal_d(na, q[0], q[1], q[2]);
+        if (nb[0] * na[0] + nb[1] * na[1] + nb[2] * na[2] <= 0.0)
+            return 1;
+    }
+    return 0;
+}
+
+static size_t pick_collapses(struct simplifier* s, const uint32_t* indices, size_t num_indices, struct collapse* out)
+{
+    size_t n = 0;
+    for (size_t i = 0; i < num_indices; i += 3) {
+        for (int k = 0; k < 3; ++k) {
+            uint32_t a = indices[i + k], b = indices[i + (k + 1) % 3];
+            /* Interior edges are seen from both sides, keep one */
+            if (a > b && s->kind[a] == VK_MANIFOLD && s->kind[b] == VK_MANIFOLD)
+                continue;
+            int ab = can_collapse(s, a, b);
+            int ba = can_collapse(s, b, a);
+            if (!ab && !ba)
+                continue;
+            float eab = ab ? quadric_error(s->quadrics + s->remap[a], s->pos[b]) : FLT_MAX;
+            float eba = ba ? quadric_error(s->quadrics + s->remap[b], s->pos[a]) : FLT_MAX;
+            struct collapse* c = out + n++;
+            if (eab <= eba) {
+                c->v0 = a;
+                c->v1 = b;
+                c->error = eab;
+            } else {
+                c->v0 = b;
+                c->v1 = a;
+                c->error = eba;
+            }
+        }
+    }
+    return n;
+}
+
+/* Counting sort on the upper bits of the error */
+static void sort_collapses(uint32_t* order, const struct collapse* cs, size_t n)
+{
+    uint32_t counts[1 << SIMPLIFY_SORT_BITS];
+    memset(counts, 0, sizeof(counts));
+    for (size_t i = 0; i < n; ++i) {
+        uint32_t bits;
+        memcpy(&bits, &cs[i].error, sizeof(uint32_t));
+        ++counts[bits >> (32 - SIMPLIFY_SORT_BITS - 1)];
+    }
+    uint32_t sum = 0;
+    for (size_t i = 0; i < (1 << SIMPLIFY_SORT_BITS); ++i) {
+        uint32_t c = counts[i];
+        counts[i] = sum;
+        sum += c;
+    }
+    for (size_t i = 0; i < n; ++i) {
+        uint32_t bits;
+        memcpy(&bits, &cs[i].error, sizeof(uint32_t));
+        order[counts[bits >> (32 - SIMPLIFY_SORT_BITS - 1)]++] = i;
+    }
+}
+
+/* Removes triangles that lost a vertex to a collapse, returns new index count */
+static size_t apply_collapses(uint32_t* indices, size_t num_indices, const uint32_t* collapse_remap)
+{
+    size_t n = 0;
+    for (size_t i = 0; i < num_indices; i += 3) {
+        uint32_t a = collapse_remap[indices[i]];
+        uint32_t b = collapse_remap[indices[i + 1]];
+        uint32_t c = collapse_remap[indices[i + 2]];
+        if (a == b || b == c || a == c)
+            continue;
+        indices[n++] = a;
+        indices[n++] = b;
+        indices[n++] = c;
+    }
+    return n;
+}
+
+/*-----------------------------------------------------------------
+ * Setup
+ *-----------------------------------------------------------------*/
+static void init_positions(struct simplifier* s, const struct vertex* vertices)
+{
+    float mn[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+    float mx[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+    for (size_t v = 0; v < s->num_verts; ++v) {
+        for (int k = 0; k < 3; ++k) {
+            float p = vertices[v].position[k];
+            mn[k] = p < mn[k] ? p : mn[k];
+            mx[k] = p > mx[k] ? p : mx[k];
+        }
+    }
+    float extent = 0.0f;
+    for (int k = 0; k < 3; ++k)
+        extent = mx[k] - mn[k] > extent ? mx[k] - mn[k] : extent;
+    float scale = extent > 0.0f ? 1.0f / extent : 1.0f;
+    for (size_t v = 0; v < s->num_verts; ++v)
+        for (int k = 0; k < 3; ++k)
+            s->pos[v][k] = (vertices[v].position[k] - mn[k]) * scale;
+
+    /* Group vertices by position */
+    struct welder positions;
+    welder_init(&positions, s->num_verts, 3 * sizeof(float), 0);
+    uint32_t* first = malloc(s->num_verts * sizeof(uint32_t));
+    for (size_t v = 0; v < s->num_verts; ++v) {
+        int is_new;
+        uint32_t p = welder_weld(&positions, vertices[v].position, &is_new);
+        if (is_new) {
+            first[p] = v;
+            s->remap[v] = v;
+            s->wedge[v] = v;
+        } else {
+            uint32_t r = first[p];
+            s->remap[v] = r;
+            s->wedge[v] = s->wedge[r];
+            s->wedge[r] = v;
+        }
+    }
+    free(first);
+    welder_destroy(&positions);
+}
+
+static void init_bones(struct simplifier* s, const struct vertex_weight* weights)
+{
+    for (size_t v = 0; v < s->num_verts; ++v) {
+        s->bone[v] = NO_VERTEX;
+        if (!weights)
+            continue;
+        float best = 0.0f;
+        for (int k = 0; k < 4; ++k) {
+            if (weights[v].bone_weights[k] > best) {
+                best = weights[v].bone_weights[k];
+                s->bone[v] = weights[v].bone_ids[k];
+            }
+        }
+    }
+}
+
+static void init_quadrics(struct simplifier* s, const uint32_t* indices, size_t num_indices)
+{
+    memset(s->quadrics, 0, s->num_verts * sizeof(struct quadric));
+    for (size_t i = 0; i < num_indices; i += 3) {
+        const float* p[3];
+        for (int k = 0; k < 3; ++k)
+            p[k] = s->pos[indices[i + k]];
+        double n[3];
+        triangle_normal_d(n, p[0], p[1], p[2]);
+        double len = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        if (len <= 0.0)
+            continue;
+        double un[3] = { n[0] / len, n[1] / len, n[2] / len };
+        double d = -(un[0] * p[0][0] + un[1] * p[0][1] + un[2] * p[0][2]);
+
+        /* Surface plane, weighted by area */
+        struct quadric q;
+        quadric_from_plane(&q, un, d, len * 0.5);
+        for (int k = 0; k < 3; ++k)
+            quadric_add(s->quadrics + s->remap[indices[i + k]], &q);
+
+        /* Planes perpendicular to open edges, keeping borders and seams in place */
+        for (int k = 0; k < 3; ++k) {
+            uint32_t a = indices[i + k], b = indices[i + (k + 1) % 3];
+            if (has_edge(s, indices, b, a))
+                continue;
+            const float* pa = s->pos[a];
+            const float* pb = s->pos[b];
+            double e[3] = { pb[0] - pa[0], pb[1] - pa[1], pb[2] - pa[2] };
+            double elen2 = e[0] * e[0] + e[1] * e[1] + e[2] * e[2];
+            double en[3] = { e[1] * un[2] - e[2] * un[1], e[2] * un[0] - e[0] * un[2], e[0] * un[1] - e[1] * un[0] };
+            double enl = sqrt(en[0] * en[0] + en[1] * en[1] + en[2] * en[2]);
+            if (enl <= 0.0)
+                continue;
+            en[0] /= enl;
+            en[1] /= enl;
+            en[2] /= enl;
+            double ed = -(en[0] * pa[0] + en[1] * pa[1] + en[2] * pa[2]);
+            struct quadric eq;
+            quadric_from_plane(&eq, en, ed, elen2 * SIMPLIFY_EDGE_WEIGHT);
+            quadric_add(s->quadrics + s->remap[a], &eq);
+            quadric_add(s->quadrics + s->remap[b], &eq);
+        }
+    }
+}
+
+/*-----------------------------------------------------------------
+ * Simplification
+ *-----------------------------------------------------------------*/
+size_t simplify_triangles(uint32_t* dst, const uint32_t* indices, size_t num_indices,
+                          const struct vertex* vertices, const struct vertex_weight* weights,
+                          size_t num_verts, size_t target_indices)
+{
+    num_indices -= num_indices % 3;
+    memcpy(dst, indices, num_indices * sizeof(uint32_t));
+    if (num_indices <= target_indices || num_verts == 0)
+        return num_indices;
+
+    struct simplifier s;
+    s.num_verts = num_verts;
+    s.pos = malloc(num_verts * sizeof(*s.pos));
+    s.remap = malloc(num_verts * sizeof(uint32_t));
+    s.wedge = malloc(num_verts * sizeof(uint32_t));
+    s.bone = malloc(num_verts * sizeof(uint32_t));
+    s.quadrics = malloc(num_verts * sizeof(struct quadric));
+    s.adj_offsets = malloc((num_verts + 1) * sizeof(uint32_t));
+    s.adj = malloc(num_indices * sizeof(uint32_t));
+    s.open_out = malloc(num_verts * sizeof(uint32_t));
+    s.open_in = malloc(num_verts * sizeof(uint32_t));
+    s.kind = malloc(num_verts);
+    s.twin = malloc(num_verts * sizeof(uint32_t));
+    struct collapse* collapses = malloc(num_indices * sizeof(struct collapse));
+    uint32_t* order = malloc(num_indices * sizeof(uint32_t));
+    uint32_t* collapse_remap = malloc(num_verts * sizeof(uint32_t));
+    unsigned char* collapse_locked = malloc(num_verts);
+
+    init_positions(&s, vertices);
+    init_bones(&s, weights);
+    build_adjacency(&s, dst, num_indices);
+    classify_vertices(&s, dst, num_indices);
+    init_quadrics(&s, dst, num_indices);
+
+    while (num_indices > target_indices) {
+        size_t num_collapses = pick_collapses(&s, dst, num_indices, collapses);
+        if (num_collapses == 0)
+            break;
+        sort_collapses(order, collapses, num_collapses);
+
+        /* Collapses needed, two triangles go away with most of them */
+        size_t tris_needed = (num_indices - target_indices + 2) / 3;
+        size_t goal = tris_needed / 2;
+        float error_bound = goal < num_collapses
+            ? collapses[order[goal]].error * SIMPLIFY_PASS_ERROR_BOUND : FLT_MAX;
+
+        for (size_t v = 0; v < num_verts; ++v)
+            collapse_remap[v] = v;
+        memset(collapse_locked, 0, num_verts);
+
+        size_t tris_removed = 0, applied = 0;
+        for (size_t i = 0; i < num_collapses && tris_removed < tris_needed; ++i) {
+            const struct collapse* c = collapses + order[i];
+            if (c->error > error_bound && applied > 0)
+                break;
+            uint32_t v0 = c->v0, v1 = c->v1;
+            uint32_t r0 = s.remap[v0], r1 = s.remap[v1];
+            /* Neighbourhoods of this pass stay untouched by other collapses */
+            if (collapse_locked[r0] || collapse_locked[r1])
+                continue;
+            if (has_triangle_flip(&s, dst, v0, v1))
+                continue;
+            if (s.kind[v0] == VK_SEAM) {
+                uint32_t t0 = s.twin[v0];
+                uint32_t t1 = open_neighbour_at(&s, t0, v1);
+                if (has_triangle_flip(&s, dst, t0, t1))
+                    continue;
+                collapse_remap[t0] = t1;
+            }
+            collapse_remap[v0] = v1;
+            quadric_add(s.quadrics + r1, s.quadrics + r0);
+            collapse_locked[r0] = 1;
+            collapse_locked[r1] = 1;
+            tris_removed += s.kind[v0] == VK_BORDER ? 1 : 2;
+            ++applied;
+        }
+        if (applied == 0)
+            break;
+
+        num_indices = apply_collapses(dst, num_indices, collapse_remap);
+        build_adjacency(&s, dst, num_indices);
+        classify_vertices(&s, dst, num_indices);
+    }
+
+    free(collapse_locked);
+    free(collapse_remap);
+    free(order);
+    free(collapses);
+    free(s.twin);
+    free(s.kind);
+    free(s.open_in);
+    free(s.open_out);
+    free(s.adj);
+    free(s.adj_offsets);
+    free(s.quadrics);
+    free(s.bone);
+    free(s.wedge);
+    free(s.remap);
+    free(s.pos);
+    return num_indices;
+}
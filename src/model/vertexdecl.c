@@ -0,0 +1,229 @@
+#include "assets/model/vertexdecl.h"
+#include "assets/model/model.h"
+#include "assets/allocator.h"
+#include <string.h>
+#include <math.h>
+
+static const unsigned int attrib_num_comps[VERTEX_ATTRIB_COUNT] = {
+    3, 3, 3, 3, 4, 2, 4, 4
+};
+
+static const size_t format_sizes[VERTEX_FORMAT_COUNT] = {
+    4, 2, 2, 2, 1, 1, 4, 2, 1
+};
+
+void vertex_decl_init(struct vertex_decl* d)
+{
+    memset(d, 0, sizeof(*d));
+}
+
+int vertex_decl_add(struct vertex_decl* d, enum vertex_attrib attrib, enum vertex_format fmt, uint32_t stream)
+{
+    if (attrib >= VERTEX_ATTRIB_COUNT || fmt >= VERTEX_FORMAT_COUNT
+     || stream >= VERTEX_MAX_STREAMS || vertex_decl_find(d, attrib))
+        return 0;
+    struct vertex_element* e = d->elems + d->num_elems++;
+    e->attrib = attrib;
+    e->format = fmt;
+    e->stream = stream;
+    e->offset = d->strides[stream];
+    /* Keep every element 4 byte aligned */
+    size_t sz = attrib_num_comps[attrib] * format_sizes[fmt];
+    d->strides[stream] += (uint32_t)((sz + 3) & ~(size_t)3);
+    if (stream + 1 > d->num_streams)
+        d->num_streams = stream + 1;
+    return 1;
+}
+
+const struct vertex_element* vertex_decl_find(const struct vertex_decl* d, enum vertex_attrib attrib)
+{
+    for (uint32_t i = 0; i < d->num_elems; ++i)
+        if (d->elems[i].attrib == attrib)
+            return d->elems + i;
+    return 0;
+}
+
+size_t vertex_format_size(enum vertex_format fmt)
+{
+    return format_sizes[fmt];
+}
+
+unsigned int vertex_attrib_num_comps(enum vertex_attrib attrib)
+{
+    return attrib_num_comps[attrib];
+}
+
+/* Round to nearest, overflow to infinity and underflow to zero */
+static uint16_t float_to_half(float f)
+{
+    uint32_t x;
+    memcpy(&x, &f, sizeof(x));
+    uint16_t sign = (x >> 16) & 0x8000;
+    int32_t exp = (int32_t)((x >> 23) & 0xff) - 127 + 15;
+    uint32_t mant = x & 0x7fffff;
+    if (((x >> 23) & 0xff) == 0xff)
+        return sign | 0x7c00 | (mant ? 0x200 : 0);
+    if (exp >= 31)
+        return sign | 0x7c00;
+    if (exp <= 0) {
+        if (exp < -10)
+            return sign;
+        mant |= 0x800000;
+        uint32_t shift = 14 - exp;
+        return sign | (uint16_t)((mant + (1u << (shift - 1))) >> shift);
+    }
+    /* Mantissa carry rolls into the exponent */
+    return sign | (uint16_t)((((uint32_t)exp << 10) | (mant >> 13)) + ((mant >> 12) & 1));
+}
+
+/* Zeroes the alignment padding after the components, so output bytes are deterministic */
+static void clear_padding(const struct vertex_element* e, void* dst)
+{
+    size_t sz = attrib_num_comps[e->attrib] * format_sizes[e->format];
+    size_t padded = (sz + 3) & ~(size_t)3;
+    if (padded != sz)
+        memset((unsigned char*)dst + sz, 0, padded - sz);
+}
+
+static float clampf(float v, float lo, float hi)
+{
+    return v < lo ? lo : (v > hi ? hi : v);
+}
+
+void vertex_element_write(const struct vertex_element* e, void* dst, const float* v)
+{
+    unsigned int n = attrib_num_comps[e->attrib];
+    for (unsigned int k = 0; k < n; ++k) {
+        switch (e->format) {
+            case VERTEX_FMT_F32:
+                ((float*)dst)[k] = v[k];
+                break;
+            case VERTEX_FMT_F16:
+                ((uint16_t*)dst)[k] = float_to_half(v[k]);
+                break;
+            case VERTEX_FMT_UNORM16:
+                ((uint16_t*)dst)[k] = (uint16_t)(clampf(v[k], 0.0f, 1.0f) * 65535.0f + 0.5f);
+                break;
+            case VERTEX_FMT_SNORM16:
+                ((int16_t*)dst)[k] = (int16_t)lrintf(clampf(v[k], -1.0f, 1.0f) * 32767.0f);
+                break;
+            case VERTEX_FMT_UNORM8:
+                ((uint8_t*)dst)[k] = (uint8_t)(clampf(v[k], 0.0f, 1.0f) * 255.0f + 0.5f);
+                break;
+            case VERTEX_FMT_SNORM8:
+                ((int8_t*)dst)[k] = (int8_t)lrintf(clampf(v[k], -1.0f, 1.0f) * 127.0f);
+                break;
+            case VERTEX_FMT_U32:
+                ((uint32_t*)dst)[k] = (uint32_t)clampf(v[k] + 0.5f, 0.0f, 4294967040.0f);
+                break;
+            case VERTEX_FMT_U16:
+                ((uint16_t*)dst)[k] = (uint16_t)clampf(v[k] + 0.5f, 0.0f, 65535.0f);
+                break;
+            case VERTEX_FMT_U8:
+                ((uint8_t*)dst)[k] = (uint8_t)clampf(v[k] + 0.5f, 0.0f, 255.0f);
+                break;
+            default:
+                break;
+        }
+    }
+    clear_padding(e, dst);
+}
+
+void vertex_element_write_uint(const struct vertex_element* e, void* dst, const uint32_t* v)
+{
+    unsigned int n = attrib_num_comps[e->attrib];
+    switch (e->format) {
+        case VERTEX_FMT_U32:
+            memcpy(dst, v, n * sizeof(uint32_t));
+            break;
+        case VERTEX_FMT_U16:
+            for (unsigned int k = 0; k < n; ++k)
+                ((uint16_t*)dst)[k] = v[k] > UINT16_MAX ? UINT16_MAX : (uint16_t)v[k];
+            clear_padding(e, dst);
+            break;
+        case VERTEX_FMT_U8:
+            for (unsigned int k = 0; k < n; ++k)
+                ((uint8_t*)dst)[k] = v[k] > UINT8_MAX ? UINT8_MAX : (uint8_t)v[k];
+            clear_padding(e, dst);
+            break;
+        default: {
+            float f[4];
+            for (unsigned int k = 0; k < n; ++k)
+                f[k] = (float)v[k];
+            vertex_element_write(e, dst, f);
+            break;
+        }
+    }
+}
+
+void mesh_alloc_vertex_streams(struct mesh* m, const struct vertex_decl* d)
+{
+    for (uint32_t s = 0; s < d->num_streams; ++s) {
+        if (!d->strides[s])
+            continue;
+        m->streams[s].stride = d->strides[s];
+        m->streams[s].data = asset_calloc(m->num_verts ? m->num_verts : 1, d->strides[s]);
+    }
+}
+
+void mesh_write_vertex_streams(const struct mesh* m, const struct vertex_decl* d, void* const* streams)
+{
+    for (uint32_t i = 0; i < d->num_elems; ++i) {
+        const struct vertex_element* e = d->elems + i;
+        if (!streams[e->stream])
+            continue;
+        unsigned char* dst = (unsigned char*)streams[e->stream] + e->offset;
+        size_t stride = d->strides[e->stream];
+        if (e->attrib == VERTEX_BONE_IDS || e->attrib == VERTEX_BONE_WEIGHTS) {
+            if (!m->weights) {
+                for (size_t v = 0; v < m->num_verts; ++v, dst += stride)
+                    memset(dst, 0, (attrib_num_comps[e->attrib] * format_sizes[e->format] + 3) & ~(size_t)3);
+                continue;
+            }
+            for (size_t v = 0; v < m->num_verts; ++v, dst += stride) {
+                if (e->attrib == VERTEX_BONE_IDS)
+                    vertex_element_write_uint(e, dst, m->weights[v].bone_ids);
+                else
+                    vertex_element_write(e, dst, m->weights[v].bone_weights);
+            }
+            continue;
+        }
+        for (size_t v = 0; v < m->num_verts; ++v, dst += stride) {
+            const struct vertex* vx = m->vertices + v;
+            const float* src = 0;
+            switch (e->attrib) {
+                case VERTEX_POSITION: src = vx->position; break;
+                case VERTEX_NORMAL:   src = vx->normal;   break;
+                case VERTEX_TANGENT:  src = vx->tangent;  break;
+                case VERTEX_BINORMAL: src = vx->binormal; break;
+                case VERTEX_COLOR:    src = vx->color;    break;
+                case VERTEX_UV:       src = vx->uvs;      break;
+                default: break;
+            }
+            vertex_element_write(e, dst, src);
+        }
+    }
+}
+
+void mesh_apply_vertex_decl(struct mesh* m, const struct vertex_decl* d)
+{
+    if (!m->vertices)
+        return;
+
+    mesh_alloc_vertex_streams(m, d);
+    void* streams[VERTEX_MAX_STREAMS];
+    for (uint32_t s = 0; s < VERTEX_MAX_STREAMS; ++s)
+        streams[s] = m->streams[s].data;
+    mesh_write_vertex_streams(m, d, streams);
+
+    asset_free(m->vertices);
+    m->vertices = 0;
+    asset_free(m->weights);
+    m->weights = 0;
+}
+
+void model_apply_vertex_decl(struct model* m, const struct vertex_decl* d)
+{
+    for (size_t i = 0; i < m->num_meshes; i++)
+        mesh_apply_vertex_decl(m->meshes[i], d);
+}
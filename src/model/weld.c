@@ -0,0 +1,88 @@
+#include "weld.h"
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+static inline uint64_t rotl64(uint64_t x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+/* Word wise multiply-rotate hash with a murmur3 finalizer, keys being
+ * small and 4 byte aligned in size */
+static uint64_t weld_hash(const unsigned char* key, size_t sz)
+{
+    uint64_t h = 0x9E3779B97F4A7C15ULL ^ sz;
+    size_t i = 0;
+    for (; i + 8 <= sz; i += 8) {
+        uint64_t k;
+        memcpy(&k, key + i, 8);
+        h = rotl64(h ^ (k * 0x87C37B91114253D5ULL), 31) * 0x4CF5AD432745937FULL;
+    }
+    if (i < sz) {
+        uint32_t k;
+        memcpy(&k, key + i, 4);
+        h = rotl64(h ^ (k * 0x87C37B91114253D5ULL), 31) * 0x4CF5AD432745937FULL;
+    }
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDULL;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+void welder_init(struct welder* w, size_t max_keys, size_t key_sz, void* key_store)
+{
+    assert(key_sz % 4 == 0);
+    /* Keep load factor at or below one half */
+    size_t num_slots = 16;
+    while (num_slots < max_keys * 2)
+        num_slots <<= 1;
+    w->slots = calloc(num_slots, sizeof(struct weld_slot));
+    w->mask = num_slots - 1;
+    w->key_sz = key_sz;
+    w->max_keys = max_keys;
+    w->num_keys = 0;
+    w->own_keys = !key_store;
+    w->keys = key_store ? key_store : malloc(max_keys * key_sz);
+}
+
+void welder_destroy(struct welder* w)
+{
+    free(w->slots);
+    if (w->own_keys)
+        free(w->keys);
+    memset(w, 0, sizeof(struct welder));
+}
+
+uint32_t welder_weld(struct welder* w, const void* key, int* is_new)
+{
+    uint64_t h = weld_hash(key, w->key_sz);
+    uint32_t tag = (uint32_t)(h >> 32);
+    size_t pos = (size_t)h & w->mask;
+    for (;;) {
+        struct weld_slot* s = w->slots + pos;
+        if (!s->idx)
+            break;
+        if (s->hash == tag && memcmp(w->keys + (s->idx - 1) * w->key_sz, key, w->key_sz) == 0) {
+            *is_new = 0;
+            return s->idx - 1;
+        }
+        pos = (pos + 1) & w->mask;
+    }
+
+    /* Not found, store at the empty slot */
+    assert(w->num_keys < w->max_keys);
+    uint32_t idx = (uint32_t)w->num_keys++;
+    memcpy(w->keys + idx * w->key_sz, key, w->key_sz);
+    w->slots[pos].hash = tag;
+    w->slots[pos].idx = idx + 1;
+    *is_new = 1;
+    return idx;
+}
+
+const void* welder_key(struct welder* w, uint32_t idx)
+{
+    return w->keys + idx * w->key_sz;
+}
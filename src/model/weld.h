@@ -0,0 +1,68 @@
+/*********************************************************************************************************************/
+/*                                                  /===-_---~~~~~~~~~------____                                     */
+/*                                                 |===-~___                _,-'                                     */
+/*                  -==\\                         `//~\\   ~~~~`---.___.-~~                                          */
+/*              ______-==|                         | |  \\           _-~`                                            */
+/*        __--~~~  ,-/-==\\                        | |   `\        ,'                                                */
+/*     _-~       /'    |  \\                      / /      \      /                                                  */
+/*   .'        /       |   \\                   /' /        \   /'                                                   */
+/*  /  ____  /         |    \`\.__/-~~ ~ \ _ _/'  /          \/'                                                     */
+/* /-'~    ~~~~~---__  |     ~-/~         ( )   /'        _--~`                                                      */
+/*                   \_|      /        _)   ;  ),   __--~~                                                           */
+/*                     '~~--_/      _-~/-  / \   '-~ \                                                               */
+/*                    {\__--_/}    / \\_>- )<__\      \                                                              */
+/*                    /'   (_/  _-~  | |__>--<__|      |                                                             */
+/*                   |0  0 _/) )-~     | |__>--<__|     |                                                            */
+/*                   / /~ ,_/       / /__>---<__/      |                                                             */
+/*                  o o _//        /-~_>---<__-~      /                                                              */
+/*                  (^(~          /~_>---<__-      _-~                                                               */
+/*                 ,/|           /__>--<__/     _-~                                                                  */
+/*              ,//('(          |__>--<__|     /                  .----_                                             */
+/*             ( ( '))          |__>--<__|    |                 /' _---_~\                                           */
+/*          `-)) )) (           |__>--<__|    |               /'  /     ~\`\                                         */
+/*         ,/,'//( (             \__>--<__\    \            /'  //        ||                                         */
+/*       ,( ( ((, ))              ~-__>--<_~-_  ~--____---~' _/'/        /'                                          */
+/*     `~/  )` ) ,/|                 ~-_~>--<_/-__       __-~ _/                                                     */
+/*   ._-~//( )/ )) `                    ~~-'_/_/ /~~~~~~~__--~                                                       */
+/*    ;'( ')/ ,)(                              ~~~~~~~~~~                                                            */
+/*   ' ') '( (/                                                                                                      */
+/*     '   '  `                                                                                                      */
+/*********************************************************************************************************************/
+#ifndef _WELD_H_
+#define _WELD_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Vertex welder, an open addressing table that maps unique keys to
+ * sequential indices in order of first appearance. Keys are compared
+ * bytewise and must be a multiple of 4 bytes in size. The table is sized
+ * once from the maximum number of keys and never grows */
+
+struct weld_slot {
+    uint32_t hash; /* Upper bits of key hash, filters most compares */
+    uint32_t idx;  /* Index + 1 of stored key, 0 when slot is empty */
+};
+
+struct welder {
+    struct weld_slot* slots;
+    size_t mask;          /* Slot count - 1 */
+    unsigned char* keys;  /* Unique keys, stored at their index */
+    size_t key_sz;
+    size_t max_keys;
+    size_t num_keys;
+    int own_keys;
+};
+
+/* Prepares a welder for at most max_keys unique keys. When key_store is
+ * given, it must hold max_keys keys and new keys are copied there at
+ * their index, else the welder allocates its own */
+void welder_init(struct welder* w, size_t max_keys, size_t key_sz, void* key_store);
+void welder_destroy(struct welder* w);
+/* Returns the index of given key, adding it if not seen before.
+ * is_new is set when the key was added */
+uint32_t welder_weld(struct welder* w, const void* key, int* is_new);
+/* Key stored at given index */
+const void* welder_key(struct welder* w, uint32_t idx);
+
+#endif /* ! _WELD_H_ */
@@ -21,13 +21,14 @@ static int shader_file_load(const char* uri, struct shader_load_settings* settin
     int ret = 0;
     *data_buf = 0;
     if (settings->load_type == SHADER_LOAD_FILE) {
-        /* Check file for existence */
-        long filesz = filesize(uri);
-        if (filesz != -1) {
-            /* Gather file contents */
-            *data_buf = malloc(filesz + 1);
-            read_file_to_mem(uri, *data_buf, filesz);
-            *(*data_buf + filesz) = '\0';
+        /* Map file contents */
+        struct file_blob fb;
+        if (file_blob_open(&fb, uri, FILE_ACCESS_SEQUENTIAL)) {
+            /* Preprocessing edits the source in place, so keep a terminated copy */
+            *data_buf = malloc(fb.size + 1);
+            memcpy(*data_buf, fb.data, fb.size);
+            *(*data_buf + fb.size) = '\0';
+            file_blob_close(&fb);
             ret = 1;
         }
     } else if (settings->load_type == SHADER_LOAD_CUSTOM) {
@@ -1,4 +1,6 @@
 #include "assets/sound/soundload.h"
+#include "assets/allocator.h"
+#include "assets/error.h"
 #include <stdlib.h>
 #include <string.h>
 #include <ogg/os_types.h>
@@ -95,7 +97,7 @@ struct sound* sound_from_ogg(const unsigned char* data, size_t sz) {
     ov_open_callbacks((void*)(&cbdata), &oggfile, 0, 0, callbacks);
 
     /* Allocate sound structure */
-    struct sound* snd = malloc(sizeof(struct sound));
+    struct sound* snd = asset_malloc(sizeof(struct sound));
 
     /* Gather audio info */
     vorbis_info* vi = ov_info(&oggfile, -1);
@@ -104,7 +106,7 @@ struct sound* sound_from_ogg(const unsigned char* data, size_t sz) {
     snd->bits_per_sample = 16;
     snd->data_sz = (size_t) ov_pcm_total(&oggfile, -1) * vi->channels * 2;
     /* Allocate destination buffer */
-    snd->data = malloc(snd->data_sz);
+    snd->data = asset_malloc(snd->data_sz);
 
     /* Decode data */
     unsigned long bytes = 0;
@@ -123,3 +125,34 @@ struct sound* sound_from_ogg(const unsigned char* data, size_t sz) {
 
     return snd;
 }
+
+static uint32_t ogg_read_u32(const unsigned char* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+int sound_info_from_ogg(const unsigned char* data, size_t sz, struct sound_info* info) {
+    /* First page carries the vorbis identification header as its only packet */
+    if (sz < 27 || memcmp(data, "OggS", 4) != 0) {
+        set_last_asset_load_error("Not an ogg stream");
+        return 0;
+    }
+    size_t ident = 27 + data[26];
+    if (ident + 16 > sz || data[ident] != 1 || memcmp(data + ident + 1, "vorbis", 6) != 0) {
+        set_last_asset_load_error("Not a vorbis stream");
+        return 0;
+    }
+    info->channels = data[ident + 11];
+    info->samplerate = ogg_read_u32(data + ident + 12);
+    /* The loader decodes to 16 bit pcm */
+    info->bits_per_sample = 16;
+
+    /* Granule position of the last page is the total sample count */
+    for (size_t ofs = sz - 27 + 1; ofs-- > 0;) {
+        if (memcmp(data + ofs, "OggS", 4) == 0) {
+            uint64_t granule = ogg_read_u32(data + ofs + 6) | ((uint64_t)ogg_read_u32(data + ofs + 10) << 32);
+            info->num_samples = (size_t)granule;
+            break;
+        }
+    }
+    return 1;
+}
@@ -1,7 +1,11 @@
 #include "assets/sound/sound.h"
+#include "assets/allocator.h"
+#include "../stats.h"
 #include <stdlib.h>
 
 void sound_delete(struct sound* snd) {
-    free(snd->data);
-    free(snd);
+    uint64_t t0 = stats_phase_begin();
+    asset_free(snd->data);
+    asset_free(snd);
+    stats_phase_end(ASSET_PHASE_FREE, t0);
 }
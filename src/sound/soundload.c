@@ -1,34 +1,106 @@
 #include "assets/sound/soundload.h"
 #include "assets/fileload.h"
+#include "assets/error.h"
 #include "../util.h"
+#include "../stats.h"
 #include <stdlib.h>
 #include <string.h>
 
+enum sound_format sound_format_detect(const unsigned char* data, size_t sz, const char* hint) {
+    /* Magic bytes */
+    if (sz >= 12 && memcmp(data, "RIFF", 4) == 0 && memcmp(data + 8, "WAVE", 4) == 0)
+        return SOUND_FORMAT_WAV;
+    if (sz >= 4 && memcmp(data, "OggS", 4) == 0)
+        return SOUND_FORMAT_OGG;
+
+    /* Damaged files are left to the loader the hint selects */
+    if (!hint)
+        return SOUND_FORMAT_UNKNOWN;
+    if (strcmpi(hint, "wav") == 0)
+        return SOUND_FORMAT_WAV;
+    else if (strcmpi(hint, "ogg") == 0)
+        return SOUND_FORMAT_OGG;
+    return SOUND_FORMAT_UNKNOWN;
+}
+
 struct sound* sound_from_mem_buf(const unsigned char* data, size_t sz, const char* hint) {
-    if(strcmpi(hint, "wav") == 0) {
-        return sound_from_wav(data, sz);
-    } else if (strcmpi(hint, "ogg") == 0) {
-        return sound_from_ogg(data, sz);
+    clear_last_asset_load_error();
+    uint64_t t0 = stats_phase_begin();
+    struct sound* snd = 0;
+    switch (sound_format_detect(data, sz, hint)) {
+        case SOUND_FORMAT_WAV:
+            snd = sound_from_wav(data, sz);
+            break;
+        case SOUND_FORMAT_OGG:
+            snd = sound_from_ogg(data, sz);
+            break;
+        default:
+            /* No image parser found */
+            set_last_asset_load_status(ASSET_LOAD_UNKNOWN_FORMAT, "Unknown sound format");
+            break;
     }
-    /* No image parser found */
-    return 0;
+    stats_phase_end(ASSET_PHASE_PARSE, t0);
+    if (snd)
+        stats_count_asset();
+    return snd;
 }
 
-struct sound* sound_from_file(const char* fpath) {
-    /* Check file for existence */
-    long filesz = filesize(fpath);
-    if (filesz == -1)
+int sound_info_from_mem_buf(const unsigned char* data, size_t sz, const char* hint, struct sound_info* info) {
+    clear_last_asset_load_error();
+    memset(info, 0, sizeof(*info));
+    info->format = sound_format_detect(data, sz, hint);
+    int ok = 0;
+    switch (info->format) {
+        case SOUND_FORMAT_WAV:
+            ok = sound_info_from_wav(data, sz, info);
+            break;
+        case SOUND_FORMAT_OGG:
+            ok = sound_info_from_ogg(data, sz, info);
+            break;
+        default:
+            set_last_asset_load_status(ASSET_LOAD_UNKNOWN_FORMAT, "Unknown sound format");
+            return 0;
+    }
+    if (!ok) {
+        if (get_last_asset_load_status() == ASSET_LOAD_OK)
+            set_last_asset_load_error("Invalid sound header");
         return 0;
+    }
+    /* Derived values */
+    info->data_sz = info->num_samples * info->channels * (info->bits_per_sample / 8);
+    if (info->samplerate)
+        info->duration = (float)((double)info->num_samples / info->samplerate);
+    return 1;
+}
 
-    /* Gather file contents */
-    unsigned char* data_buf = malloc(filesz);
-    read_file_to_mem(fpath, data_buf, filesz);
+struct sound* sound_from_file(const char* fpath) {
+    /* Map file contents */
+    struct file_blob fb;
+    if (!file_blob_open(&fb, fpath, FILE_ACCESS_SEQUENTIAL)) {
+        set_last_asset_load_status(ASSET_LOAD_IO_ERROR, "Could not open file");
+        return 0;
+    }
 
     /* Parse image data from memory */
     const char* ext = get_filename_ext(fpath);
-    struct sound* snd = sound_from_mem_buf(data_buf, filesz, ext);
-    free(data_buf);
+    struct sound* snd = sound_from_mem_buf(fb.data, fb.size, ext);
+    file_blob_close(&fb);
 
     /* Return parsed image */
     return snd;
 }
+
+int sound_info_from_file(const char* fpath, struct sound_info* info) {
+    /* Map file contents, only the header pages are touched */
+    struct file_blob fb;
+    if (!file_blob_open(&fb, fpath, FILE_ACCESS_RANDOM)) {
+        set_last_asset_load_status(ASSET_LOAD_IO_ERROR, "Could not open file");
+        return 0;
+    }
+
+    /* Parse sound headers from memory */
+    const char* ext = get_filename_ext(fpath);
+    int ok = sound_info_from_mem_buf(fb.data, fb.size, ext, info);
+    file_blob_close(&fb);
+    return ok;
+}
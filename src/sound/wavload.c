@@ -1,4 +1,6 @@
 #include "assets/sound/soundload.h"
+#include "assets/allocator.h"
+#include "assets/error.h"
 #include <stdlib.h>
 #include <stdint.h>
 #include <string.h>
@@ -85,12 +87,47 @@ struct sound* sound_from_wav(const unsigned char* data, size_t sz) {
     wchunk.data = begin + 8;
 
     /* Fill and return sound object */
-    struct sound* snd = malloc(sizeof(struct sound));
+    struct sound* snd = asset_malloc(sizeof(struct sound));
     snd->channels = wfmt.channels;
     snd->samplerate = wfmt.sample_rate;
     snd->bits_per_sample = wfmt.bits_per_sample;
     snd->data_sz = wchunk.size;
-    snd->data = malloc(snd->data_sz);
+    snd->data = asset_malloc(snd->data_sz);
     memcpy(snd->data, wchunk.data, snd->data_sz);
     return snd;
 }
+
+int sound_info_from_wav(const unsigned char* data, size_t sz, struct sound_info* info) {
+    if (sz < 12)
+        return 0;
+
+    /* Walk the chunks following the riff header */
+    size_t ofs = 12;
+    int have_fmt = 0;
+    while (ofs + 8 <= sz) {
+        const unsigned char* chunk = data + ofs;
+        uint32_t chunk_sz;
+        memcpy(&chunk_sz, chunk + 4, sizeof(chunk_sz));
+        if (memcmp(chunk, "fmt ", 4) == 0 && ofs + 8 + 16 <= sz) {
+            uint16_t channels, bits_per_sample;
+            uint32_t sample_rate;
+            memcpy(&channels, chunk + 10, sizeof(channels));
+            memcpy(&sample_rate, chunk + 12, sizeof(sample_rate));
+            memcpy(&bits_per_sample, chunk + 22, sizeof(bits_per_sample));
+            info->channels = channels;
+            info->samplerate = sample_rate;
+            info->bits_per_sample = bits_per_sample;
+            have_fmt = 1;
+        } else if (memcmp(chunk, "data", 4) == 0) {
+            size_t frame_sz = info->channels * (info->bits_per_sample / 8);
+            if (!have_fmt || !frame_sz)
+                break;
+            info->num_samples = chunk_sz / frame_sz;
+            return 1;
+        }
+        /* Chunks are word aligned */
+        ofs += 8 + chunk_sz + (chunk_sz & 1);
+    }
+    set_last_asset_load_error("Missing wav fmt or data chunk");
+    return 0;
+}
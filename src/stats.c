@@ -0,0 +1,342 @@
+/*********************************************************************************************************************/
+/*                                                  /===-_---~~~~~~~~~------____                                     */
+/*                                                 |===-~___                _,-'                                     */
+/*                  -==\\                         `//~\\   ~~~~`---.___.-~~                                          */
+/*              ______-==|                         | |  \\           _-~`                                            */
+/*        __--~~~  ,-/-==\\                        | |   `\        ,'                                                */
+/*     _-~       /'    |  \\                      / /      \      /                                                  */
+/*   .'        /       |   \\                   /' /        \   /'                                                   */
+/*  /  ____  /         |    \`\.__/-~~ ~ \ _ _/'  /          \/'                                                     */
+/* /-'~    ~~~~~---__  |     ~-/~         ( )   /'        _--~`                                                      */
+/*                   \_|      /        _)   ;  ),   __--~~                                                           */
+/*                     '~~--_/      _-~/-  / \   '-~ \                                                               */
+/*                    {\__--_/}    / \\_>- )<__\      \                                                              */
+/*                    /'   (_/  _-~  | |__>--<__|      |                                                             */
+/*                   |0  0 _/) )-~     | |__>--<__|     |                                                            */
+/*                   / /~ ,_/       / /__>---<__/      |                                                             */
+/*                  o o _//        /-~_>---<__-~      /                                                              */
+/*                  (^(~          /~_>---<__-      _-~                                                               */
+/*                 ,/|           /__>--<__/     _-~                                                                  */
+/*              ,//('(          |__>--<__|     /                  .----_                                             */
+/*             ( ( '))          |__>--<__|    |                 /' _---_~\                                           */
+/*          `-)) )) (           |__>--<__|    |               /'  /     ~\`\                                         */
+/*         ,/,'//( (             \__>--<__\    \            /'  //        ||                                         */
+/*       ,( ( ((, ))              ~-__>--<_~-_  ~--____---~' _/'/        /'                                          */
+/*     `~/  )` ) ,/|                 ~-_~>--<_/-__       __-~ _/                                                     */
+/*   ._-~//( )/ )) `                    ~~-'_/_/ /~~~~~~~__--~                                                       */
+/*    ;'( ')/ ,)(                              ~~~~~~~~~~                                                            */
+/*   ' ') '( (/                                                                                                      */
+/*     '   '  `                                                                                                      */
+/*********************************************************************************************************************/
+#include "stats.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "thread.h"
+#ifdef OS_WINDOWS
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+/*-----------------------------------------------------------------
+ * Clock
+ *-----------------------------------------------------------------*/
+static uint64_t stats_now_ns()
+{
+#ifdef OS_WINDOWS
+    LARGE_INTEGER freq, cnt;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&cnt);
+    return (uint64_t)((double)cnt.QuadPart * 1e9 / (double)freq.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+/*-----------------------------------------------------------------
+ * Per thread state
+ *-----------------------------------------------------------------*/
+#define STATS_MAX_DEPTH 16
+#define STATS_LABEL_SZ 48
+
+struct trace_event {
+    enum asset_phase phase;
+    uint64_t ts;
+    uint64_t dur;
+    char label[STATS_LABEL_SZ];
+};
+
+/* Each thread only writes its own block, readers sum over all of them */
+struct stats_block {
+    struct asset_stats counters;
+    /* Time spent in nested phases, per open phase */
+    uint64_t child_ns[STATS_MAX_DEPTH];
+    int depth;
+    char label[STATS_LABEL_SZ];
+    /* Trace events, guarded for the writer */
+    mutex_t ev_mtx;
+    struct trace_event* events;
+    size_t num_events;
+    size_t cap_events;
+    unsigned int tid;
+    struct stats_block* next;
+};
+
+static int stats_on = 0;
+static int trace_on = 0;
+static uint64_t trace_t0 = 0;
+
+/* Registry of all thread blocks, blocks live until process exit */
+static once_t registry_once = ONCE_INIT;
+static mutex_t registry_mtx;
+static struct stats_block* registry = 0;
+static unsigned int registry_count = 0;
+static thread_local_var struct stats_block* tls_block = 0;
+
+static void stats_registry_init()
+{
+    mutex_init(&registry_mtx);
+}
+
+static struct stats_block* stats_thread_block()
+{
+    struct stats_block* b = tls_block;
+    if (b)
+        return b;
+    b = calloc(1, sizeof(struct stats_block));
+    mutex_init(&b->ev_mtx);
+    thread_once(&registry_once, stats_registry_init);
+    mutex_lock(&registry_mtx);
+    b->tid = ++registry_count;
+    b->next = registry;
+    registry = b;
+    mutex_unlock(&registry_mtx);
+    tls_block = b;
+    return b;
+}
+
+/*-----------------------------------------------------------------
+ * Hooks
+ *-----------------------------------------------------------------*/
+uint64_t stats_phase_begin()
+{
+    if (!atomic_load_int(&stats_on))
+        return 0;
+    struct stats_block* b = stats_thread_block();
+    if (b->depth < STATS_MAX_DEPTH)
+        b->child_ns[b->depth] = 0;
+    ++b->depth;
+    uint64_t t = stats_now_ns();
+    return t ? t : 1;
+}
+
+static void stats_trace_record(struct stats_block* b, enum asset_phase ph, uint64_t t0, uint64_t dur)
+{
+    mutex_lock(&b->ev_mtx);
+    if (b->num_events == b->cap_events) {
+        size_t ncap = b->cap_events ? b->cap_events * 2 : 256;
+        struct trace_event* nev = realloc(b->events, ncap * sizeof(struct trace_event));
+        if (!nev) {
+            mutex_unlock(&b->ev_mtx);
+            return;
+        }
+        b->events = nev;
+        b->cap_events = ncap;
+    }
+    struct trace_event* ev = b->events + b->num_events++;
+    ev->phase = ph;
+    uint64_t start = atomic_load_u64(&trace_t0);
+    ev->ts = t0 > start ? t0 - start : 0;
+    ev->dur = dur;
+    memcpy(ev->label, b->label, STATS_LABEL_SZ);
+    mutex_unlock(&b->ev_mtx);
+}
+
+void stats_phase_end(enum asset_phase ph, uint64_t t0)
+{
+    if (!t0)
+        return;
+    uint64_t dur = stats_now_ns() - t0;
+    struct stats_block* b = stats_thread_block();
+
+    /* Charge only the time not spent in nested phases, and
+     * report the whole duration to the enclosing phase */
+    int depth = --b->depth;
+    uint64_t child = depth < STATS_MAX_DEPTH ? b->child_ns[depth] : 0;
+    if (depth > 0 && depth - 1 < STATS_MAX_DEPTH)
+        b->child_ns[depth - 1] += dur;
+    atomic_add_u64(&b->counters.phase_ns[ph], dur - child);
+    atomic_add_u64(&b->counters.phase_calls[ph], 1);
+
+    if (atomic_load_int(&trace_on))
+        stats_trace_record(b, ph, t0, dur);
+}
+
+void stats_count_alloc(size_t sz)
+{
+    if (!atomic_load_int(&stats_on))
+        return;
+    struct stats_block* b = stats_thread_block();
+    atomic_add_u64(&b->counters.num_allocs, 1);
+    atomic_add_u64(&b->counters.bytes_allocated, sz);
+}
+
+void stats_count_free()
+{
+    if (!atomic_load_int(&stats_on))
+        return;
+    atomic_add_u64(&stats_thread_block()->counters.num_frees, 1);
+}
+
+void stats_count_read(size_t sz)
+{
+    if (!atomic_load_int(&stats_on))
+        return;
+    atomic_add_u64(&stats_thread_block()->counters.bytes_read, sz);
+}
+
+void stats_count_asset()
+{
+    if (!atomic_load_int(&stats_on))
+        return;
+    atomic_add_u64(&stats_thread_block()->counters.assets_loaded, 1);
+}
+
+void stats_set_label(const char* label)
+{
+    if (!atomic_load_int(&trace_on))
+        return;
+    /* Keep the tail, file names are more telling than their directories */
+    struct stats_block* b = stats_thread_block();
+    size_t len = strlen(label);
+    if (len >= STATS_LABEL_SZ)
+        label += len - (STATS_LABEL_SZ - 1);
+    strncpy(b->label, label, STATS_LABEL_SZ - 1);
+    b->label[STATS_LABEL_SZ - 1] = 0;
+}
+
+/*-----------------------------------------------------------------
+ * Public API
+ *-----------------------------------------------------------------*/
+void asset_stats_enable(int enable)
+{
+    atomic_store_int(&stats_on, enable ? 1 : 0);
+    if (!enable)
+        atomic_store_int(&trace_on, 0);
+}
+
+int asset_stats_enabled()
+{
+    return atomic_load_int(&stats_on);
+}
+
+#define stats_counter_count (sizeof(struct asset_stats) / sizeof(uint64_t))
+
+void asset_stats_get(struct asset_stats* st)
+{
+    memset(st, 0, sizeof(*st));
+    thread_once(&registry_once, stats_registry_init);
+    uint64_t* dst = (uint64_t*)st;
+    mutex_lock(&registry_mtx);
+    for (struct stats_block* b = registry; b; b = b->next) {
+        uint64_t* src = (uint64_t*)&b->counters;
+        for (size_t i = 0; i < stats_counter_count; ++i)
+            dst[i] += atomic_load_u64(src + i);
+    }
+    mutex_unlock(&registry_mtx);
+}
+
+void asset_stats_reset()
+{
+    thread_once(&registry_once, stats_registry_init);
+    mutex_lock(&registry_mtx);
+    for (struct stats_block* b = registry; b; b = b->next) {
+        uint64_t* c = (uint64_t*)&b->counters;
+        for (size_t i = 0; i < stats_counter_count; ++i)
+            atomic_store_u64(c + i, 0);
+    }
+    mutex_unlock(&registry_mtx);
+}
+
+static const char* phase_names[ASSET_PHASE_COUNT] = {
+    "read",
+    "decompress",
+    "parse",
+    "weld",
+    "postprocess",
+    "free"
+};
+
+const char* asset_phase_name(enum asset_phase ph)
+{
+    return ph < ASSET_PHASE_COUNT ? phase_names[ph] : "unknown";
+}
+
+void asset_trace_start()
+{
+    thread_once(&registry_once, stats_registry_init);
+    mutex_lock(&registry_mtx);
+    for (struct stats_block* b = registry; b; b = b->next) {
+        mutex_lock(&b->ev_mtx);
+        b->num_events = 0;
+        mutex_unlock(&b->ev_mtx);
+    }
+    mutex_unlock(&registry_mtx);
+    atomic_store_u64(&trace_t0, stats_now_ns());
+    atomic_store_int(&stats_on, 1);
+    atomic_store_int(&trace_on, 1);
+}
+
+void asset_trace_stop()
+{
+    atomic_store_int(&trace_on, 0);
+}
+
+static void trace_write_str(FILE* f, const char* s)
+{
+    fputc('"', f);
+    for (; *s; ++s) {
+        if (*s == '"' || *s == '\\')
+            fputc('\\', f);
+        if ((unsigned char)*s >= 0x20)
+            fputc(*s, f);
+    }
+    fputc('"', f);
+}
+
+int asset_trace_write(const char* fpath)
+{
+    FILE* f = fopen(fpath, "w");
+    if (!f)
+        return 0;
+
+    /* Complete ("X") events with microsecond timestamps */
+    fputs("{\"traceEvents\":[\n", f);
+    int first = 1;
+    thread_once(&registry_once, stats_registry_init);
+    mutex_lock(&registry_mtx);
+    for (struct stats_block* b = registry; b; b = b->next) {
+        mutex_lock(&b->ev_mtx);
+        for (size_t i = 0; i < b->num_events; ++i) {
+            struct trace_event* ev = b->events + i;
+            fputs(first ? "" : ",\n", f);
+            first = 0;
+            fputs("{\"name\":", f);
+            trace_write_str(f, asset_phase_name(ev->phase));
+            fprintf(f, ",\"cat\":\"asset\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u,\"args\":{\"asset\":",
+                    ev->ts / 1000.0, ev->dur / 1000.0, b->tid);
+            trace_write_str(f, ev->label);
+            fputs("}}", f);
+        }
+        mutex_unlock(&b->ev_mtx);
+    }
+    mutex_unlock(&registry_mtx);
+    fputs("\n]}\n", f);
+
+    int ok = !ferror(f);
+    fclose(f);
+    return ok;
+}
@@ -0,0 +1,214 @@
+/*********************************************************************************************************************/
+/*                                                  /===-_---~~~~~~~~~------____                                     */
+/*                                                 |===-~___                _,-'                                     */
+/*                  -==\\                         `//~\\   ~~~~`---.___.-~~                                          */
+/*              ______-==|                         | |  \\           _-~`                                            */
+/*        __--~~~  ,-/-==\\                        | |   `\        ,'                                                */
+/*     _-~       /'    |  \\                      / /      \      /                                                  */
+/*   .'        /       |   \\                   /' /        \   /'                                                   */
+/*  /  ____  /         |    \`\.__/-~~ ~ \ _ _/'  /          \/'                                                     */
+/* /-'~    ~~~~~---__  |     ~-/~         ( )   /'        _--~`                                                      */
+/*                   \_|      /        _)   ;  ),   __--~~                                                           */
+/*                     '~~--_/      _-~/-  / \   '-~ \                                                               */
+/*                    {\__--_/}    / \\_>- )<__\      \                                                              */
+/*                    /'   (_/  _-~  | |__>--<__|      |                                                             */
+/*                   |0  0 _/) )-~     | |__>--<__|     |                                                            */
+/*                   / /~ ,_/       / /__>---<__/      |                                                             */
+/*                  o o _//        /-~_>---<__-~      /                                                              */
+/*                  (^(~          /~_>---<__-      _-~                                                               */
+/*                 ,/|           /__>--<__/     _-~                                                                  */
+/*              ,//('(          |__>--<__|     /                  .----_                                             */
+/*             ( ( '))          |__>--<__|    |                 /' _---_~\                                           */
+/*          `-)) )) (           |__>--<__|    |               /'  /     ~\`\                                         */
+/*         ,/,'//( (             \__>--<__\    \            /'  //        ||                                         */
+/*       ,( ( ((, ))              ~-__>--<_~-_  ~--____---~' _/'/        /'                                          */
+/*     `~/  )` ) ,/|                 ~-_~>--<_/-__       __-~ _/                                                     */
+/*   ._-~//( )/ )) `                    ~~-'_/_/ /~~~~~~~__--~                                                       */
+/*    ;'( ')/ ,)(                              ~~~~~~~~~~                                                            */
+/*   ' ') '( (/                                                                                                      */
+/*     '   '  `                                                                                                      */
+/*********************************************************************************************************************/
+#include "thread.h"
+#include <stdlib.h>
+#ifndef OS_WINDOWS
+#include <unistd.h>
+#endif
+
+struct thread_start {
+    thread_fn fn;
+    void* arg;
+};
+
+#ifdef OS_WINDOWS
+static DWORD WINAPI thread_entry(LPVOID p)
+{
+    struct thread_start ts = *(struct thread_start*)p;
+    free(p);
+    ts.fn(ts.arg);
+    return 0;
+}
+
+int thread_create(thread_t* t, thread_fn fn, void* arg)
+{
+    struct thread_start* ts = malloc(sizeof(struct thread_start));
+    ts->fn = fn;
+    ts->arg = arg;
+    *t = CreateThread(0, 0, thread_entry, ts, 0, 0);
+    if (!*t) {
+        free(ts);
+        return 0;
+    }
+    return 1;
+}
+
+void thread_join(thread_t* t)
+{
+    WaitForSingleObject(*t, INFINITE);
+    CloseHandle(*t);
+}
+
+unsigned int thread_hw_concurrency()
+{
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    return si.dwNumberOfProcessors > 0 ? si.dwNumberOfProcessors : 1;
+}
+
+static BOOL CALLBACK thread_once_entry(PINIT_ONCE flag, PVOID fn, PVOID* ctx)
+{
+    (void)flag; (void)ctx;
+    ((void(*)())fn)();
+    return TRUE;
+}
+
+void thread_once(once_t* flag, void(*fn)())
+{
+    InitOnceExecuteOnce(flag, thread_once_entry, (PVOID)fn, 0);
+}
+
+void mutex_init(mutex_t* m)
+{
+    InitializeCriticalSection(m);
+}
+
+void mutex_destroy(mutex_t* m)
+{
+    DeleteCriticalSection(m);
+}
+
+void mutex_lock(mutex_t* m)
+{
+    EnterCriticalSection(m);
+}
+
+void mutex_unlock(mutex_t* m)
+{
+    LeaveCriticalSection(m);
+}
+
+void cond_init(cond_t* c)
+{
+    InitializeConditionVariable(c);
+}
+
+void cond_destroy(cond_t* c)
+{
+    (void)c;
+}
+
+void cond_wait(cond_t* c, mutex_t* m)
+{
+    SleepConditionVariableCS(c, m, INFINITE);
+}
+
+void cond_signal(cond_t* c)
+{
+    WakeConditionVariable(c);
+}
+
+void cond_broadcast(cond_t* c)
+{
+    WakeAllConditionVariable(c);
+}
+#else
+static void* thread_entry(void* p)
+{
+    struct thread_start ts = *(struct thread_start*)p;
+    free(p);
+    ts.fn(ts.arg);
+    return 0;
+}
+
+int thread_create(thread_t* t, thread_fn fn, void* arg)
+{
+    struct thread_start* ts = malloc(sizeof(struct thread_start));
+    ts->fn = fn;
+    ts->arg = arg;
+    if (pthread_create(t, 0, thread_entry, ts) != 0) {
+        free(ts);
+        return 0;
+    }
+    return 1;
+}
+
+void thread_join(thread_t* t)
+{
+    pthread_join(*t, 0);
+}
+
+unsigned int thread_hw_concurrency()
+{
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (unsigned int)n : 1;
+}
+
+void thread_once(once_t* flag, void(*fn)())
+{
+    pthread_once(flag, fn);
+}
+
+void mutex_init(mutex_t* m)
+{
+    pthread_mutex_init(m, 0);
+}
+
+void mutex_destroy(mutex_t* m)
+{
+    pthread_mutex_destroy(m);
+}
+
+void mutex_lock(mutex_t* m)
+{
+    pthread_mutex_lock(m);
+}
+
+void mutex_unlock(mutex_t* m)
+{
+    pthread_mutex_unlock(m);
+}
+
+void cond_init(cond_t* c)
+{
+    pthread_cond_init(c, 0);
+}
+
+void cond_destroy(cond_t* c)
+{
+    pthread_cond_destroy(c);
+}
+
+void cond_wait(cond_t* c, mutex_t* m)
+{
+    pthread_cond_wait(c, m);
+}
+
+void cond_signal(cond_t* c)
+{
+    pthread_cond_signal(c);
+}
+
+void cond_broadcast(cond_t* c)
+{
+    pthread_cond_broadcast(c);
+}
+#endif
@@ -0,0 +1,93 @@
+/*********************************************************************************************************************/
+/*                                                  /===-_---~~~~~~~~~------____                                     */
+/*                                                 |===-~___                _,-'                                     */
+/*                  -==\\                         `//~\\   ~~~~`---.___.-~~                                          */
+/*              ______-==|                         | |  \\           _-~`                                            */
+/*        __--~~~  ,-/-==\\                        | |   `\        ,'                                                */
+/*     _-~       /'    |  \\                      / /      \      /                                                  */
+/*   .'        /       |   \\                   /' /        \   /'                                                   */
+/*  /  ____  /         |    \`\.__/-~~ ~ \ _ _/'  /          \/'                                                     */
+/* /-'~    ~~~~~---__  |     ~-/~         ( )   /'        _--~`                                                      */
+/*                   \_|      /        _)   ;  ),   __--~~                                                           */
+/*                     '~~--_/      _-~/-  / \   '-~ \                                                               */
+/*                    {\__--_/}    / \\_>- )<__\      \                                                              */
+/*                    /'   (_/  _-~  | |__>--<__|      |                                                             */
+/*                   |0  0 _/) )-~     | |__>--<__|     |                                                            */
+/*                   / /~ ,_/       / /__>---<__/      |                                                             */
+/*                  o o _//        /-~_>---<__-~      /                                                              */
+/*                  (^(~          /~_>---<__-      _-~                                                               */
+/*                 ,/|           /__>--<__/     _-~                                                                  */
+/*              ,//('(          |__>--<__|     /                  .----_                                             */
+/*             ( ( '))          |__>--<__|    |                 /' _---_~\                                           */
+/*          `-)) )) (           |__>--<__|    |               /'  /     ~\`\                                         */
+/*         ,/,'//( (             \__>--<__\    \            /'  //        ||                                         */
+/*       ,( ( ((, ))              ~-__>--<_~-_  ~--____---~' _/'/        /'                                          */
+/*     `~/  )` ) ,/|                 ~-_~>--<_/-__       __-~ _/                                                     */
+/*   ._-~//( )/ )) `                    ~~-'_/_/ /~~~~~~~__--~                                                       */
+/*    ;'( ')/ ,)(                              ~~~~~~~~~~                                                            */
+/*   ' ') '( (/                                                                                                      */
+/*     '   '  `                                                                                                      */
+/*********************************************************************************************************************/
+#ifndef _THREAD_H_
+#define _THREAD_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <plat.h>
+
+/* Thin portable layer over the native threading primitives */
+#ifdef OS_WINDOWS
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+typedef HANDLE thread_t;
+typedef CRITICAL_SECTION mutex_t;
+typedef CONDITION_VARIABLE cond_t;
+typedef INIT_ONCE once_t;
+#define ONCE_INIT INIT_ONCE_STATIC_INIT
+#define thread_local_var __declspec(thread)
+#else
+#include <pthread.h>
+typedef pthread_t thread_t;
+typedef pthread_mutex_t mutex_t;
+typedef pthread_cond_t cond_t;
+typedef pthread_once_t once_t;
+#define ONCE_INIT PTHREAD_ONCE_INIT
+#define thread_local_var __thread
+#endif
+
+typedef void(*thread_fn)(void* arg);
+
+int thread_create(thread_t* t, thread_fn fn, void* arg);
+void thread_join(thread_t* t);
+/* Number of hardware threads available to the process */
+unsigned int thread_hw_concurrency();
+/* Runs fn exactly once for the given flag, no matter how many threads race */
+void thread_once(once_t* flag, void(*fn)());
+
+void mutex_init(mutex_t* m);
+void mutex_destroy(mutex_t* m);
+void mutex_lock(mutex_t* m);
+void mutex_unlock(mutex_t* m);
+
+void cond_init(cond_t* c);
+void cond_destroy(cond_t* c);
+void cond_wait(cond_t* c, mutex_t* m);
+void cond_signal(cond_t* c);
+void cond_broadcast(cond_t* c);
+
+/* Relaxed atomics for counters and flags */
+#ifdef OS_WINDOWS
+#define atomic_add_u64(p, v) ((void)InterlockedExchangeAdd64((volatile LONG64*)(p), (LONG64)(v)))
+#define atomic_load_u64(p) ((uint64_t)InterlockedCompareExchange64((volatile LONG64*)(p), 0, 0))
+#define atomic_store_u64(p, v) ((void)InterlockedExchange64((volatile LONG64*)(p), (LONG64)(v)))
+#define atomic_load_int(p) ((int)InterlockedCompareExchange((volatile LONG*)(p), 0, 0))
+#define atomic_store_int(p, v) ((void)InterlockedExchange((volatile LONG*)(p), (LONG)(v)))
+#else
+#define atomic_add_u64(p, v) ((void)__atomic_fetch_add((p), (uint64_t)(v), __ATOMIC_RELAXED))
+#define atomic_load_u64(p) __atomic_load_n((p), __ATOMIC_RELAXED)
+#define atomic_store_u64(p, v) __atomic_store_n((p), (uint64_t)(v), __ATOMIC_RELAXED)
+#define atomic_load_int(p) __atomic_load_n((p), __ATOMIC_RELAXED)
+#define atomic_store_int(p, v) __atomic_store_n((p), (v), __ATOMIC_RELAXED)
+#endif
+
+#endif /* ! _THREAD_H_ */
@@ -0,0 +1,370 @@
+/*********************************************************************************************************************/
+/*                                                  /===-_---~~~~~~~~~------____                                     */
+/*                                                 |===-~___                _,-'                                     */
+/*                  -==\\                         `//~\\   ~~~~`---.___.-~~                                          */
+/*              ______-==|                         | |  \\           _-~`                                            */
+/*        __--~~~  ,-/-==\\                        | |   `\        ,'                                                */
+/*     _-~       /'    |  \\                      / /      \      /                                                  */
+/*   .'        /       |   \\                   /' /        \   /'                                                   */
+/*  /  ____  /         |    \`\.__/-~~ ~ \ _ _/'  /          \/'                                                     */
+/* /-'~    ~~~~~---__  |     ~-/~         ( )   /'        _--~`                                                      */
+/*                   \_|      /        _)   ;  ),   __--~~                                                           */
+/*                     '~~--_/      _-~/-  / \   '-~ \                                                               */
+/*                    {\__--_/}    / \\_>- )<__\      \                                                              */
+/*                    /'   (_/  _-~  | |__>--<__|      |                                                             */
+/*                   |0  0 _/) )-~     | |__>--<__|     |                                                            */
+/*                   / /~ ,_/       / /__>---<__/      |                                                             */
+/*                  o o _//        /-~_>---<__-~      /                                                              */
+/*                  (^(~          /~_>---<__-      _-~                                                               */
+/*                 ,/|           /__>--<__/     _-~                                                                  */
+/*              ,//('(          |__>--<__|     /                  .----_                                             */
+/*             ( ( '))          |__>--<__|    |                 /' _---_~\                                           */
+/*          `-)) )) (           |__>--<__|    |               /'  /     ~\`\                                         */
+/*         ,/,'//( (             \__>--<__\    \            /'  //        ||                                         */
+/*       ,( ( ((, ))              ~-__>--<_~-_  ~--____---~' _/'/        /'                                          */
+/*     `~/  )` ) ,/|                 ~-_~>--<_/-__       __-~ _/                                                     */
+/*   ._-~//( )/ )) `                    ~~-'_/_/ /~~~~~~~__--~                                                       */
+/*    ;'( ')/ ,)(                              ~~~~~~~~~~                                                            */
+/*   ' ') '( (/                                                                                                      */
+/*     '   '  `                                                                                                      */
+/*********************************************************************************************************************/
+#include "threadpool.h"
+#include <stdlib.h>
+#include <string.h>
+
+/*-----------------------------------------------------------------
+ * Task deque
+ *-----------------------------------------------------------------*/
+struct tp_task {
+    tp_task_fn fn;
+    void* arg;
+    struct tp_group* grp;
+};
+
+/* Growable ring buffer guarded by its own lock. The owner works
+ * on the back (LIFO, cache warm), thieves take from the front */
+struct tp_deque {
+    mutex_t mtx;
+    struct tp_task* tasks;
+    size_t cap;
+    size_t head;
+    size_t count;
+};
+
+static void tp_deque_init(struct tp_deque* dq)
+{
+    mutex_init(&dq->mtx);
+    dq->cap = 64;
+    dq->tasks = malloc(dq->cap * sizeof(struct tp_task));
+    dq->head = 0;
+    dq->count = 0;
+}
+
+static void tp_deque_destroy(struct tp_deque* dq)
+{
+    free(dq->tasks);
+    mutex_destroy(&dq->mtx);
+}
+
+static void tp_deque_push_back(struct tp_deque* dq, struct tp_task* t)
+{
+    mutex_lock(&dq->mtx);
+    if (dq->count == dq->cap) {
+        /* Unroll ring into a buffer of double size */
+        struct tp_task* ntasks = malloc(2 * dq->cap * sizeof(struct tp_task));
+        for (size_t i = 0; i < dq->count; ++i)
+            ntasks[i] = dq->tasks[(dq->head + i) % dq->cap];
+        free(dq->tasks);
+        dq->tasks = ntasks;
+        dq->head = 0;
+        dq->cap *= 2;
+    }
+    dq->tasks[(dq->head + dq->count) % dq->cap] = *t;
+    ++dq->count;
+    mutex_unlock(&dq->mtx);
+}
+
+static int tp_deque_pop_back(struct tp_deque* dq, struct tp_task* t)
+{
+    int found = 0;
+    mutex_lock(&dq->mtx);
+    if (dq->count) {
+        --dq->count;
+        *t = dq->tasks[(dq->head + dq->count) % dq->cap];
+        found = 1;
+    }
+    mutex_unlock(&dq->mtx);
+    return found;
+}
+
+static int tp_deque_pop_front(struct tp_deque* dq, struct tp_task* t)
+{
+    int found = 0;
+    mutex_lock(&dq->mtx);
+    if (dq->count) {
+        *t = dq->tasks[dq->head];
+        dq->head = (dq->head + 1) % dq->cap;
+        --dq->count;
+        found = 1;
+    }
+    mutex_unlock(&dq->mtx);
+    return found;
+}
+
+/*-----------------------------------------------------------------
+ * Pool
+ *-----------------------------------------------------------------*/
+struct tp_worker {
+    thread_t thrd;
+    struct tp_deque dq;
+    unsigned int idx;
+};
+
+static struct {
+    struct tp_worker* workers;
+    unsigned int num_workers;
+    unsigned int num_slots; /* Allocated workers, running or not */
+    /* Guards start/stop */
+    mutex_t state_mtx;
+    /* Guards the sleep state and group counters */
+    mutex_t mtx;
+    cond_t wake;
+    size_t queued;
+    unsigned int next;
+    int stop;
+} pool;
+
+static once_t pool_once = ONCE_INIT;
+static thread_local_var struct tp_worker* cur_worker;
+
+static void tp_pool_init()
+{
+    mutex_init(&pool.state_mtx);
+    mutex_init(&pool.mtx);
+    cond_init(&pool.wake);
+}
+
+static int tp_try_get(struct tp_task* t)
+{
+    struct tp_worker* self = cur_worker;
+    int found = self && tp_deque_pop_back(&self->dq, t);
+    if (!found) {
+        /* Steal, starting from the neighbour to spread contention */
+        unsigned int n = pool.num_workers;
+        unsigned int start = self ? self->idx + 1 : 0;
+        for (unsigned int i = 0; i < n && !found; ++i) {
+            struct tp_worker* w = pool.workers + (start + i) % n;
+            if (w != self)
+                found = tp_deque_pop_front(&w->dq, t);
+        }
+    }
+    if (found) {
+        mutex_lock(&pool.mtx);
+        --pool.queued;
+        mutex_unlock(&pool.mtx);
+    }
+    return found;
+}
+
+static void tp_run(struct tp_task* t)
+{
+    t->fn(t->arg);
+    if (t->grp) {
+        mutex_lock(&pool.mtx);
+        if (--t->grp->pending == 0)
+            cond_broadcast(&pool.wake);
+        mutex_unlock(&pool.mtx);
+    }
+}
+
+static void tp_worker_main(void* arg)
+{
+    cur_worker = arg;
+    struct tp_task t;
+    for (;;) {
+        if (tp_try_get(&t)) {
+            tp_run(&t);
+            continue;
+        }
+        mutex_lock(&pool.mtx);
+        while (!pool.stop && pool.queued == 0)
+            cond_wait(&pool.wake, &pool.mtx);
+        int done = pool.stop && pool.queued == 0;
+        mutex_unlock(&pool.mtx);
+        if (done)
+            break;
+    }
+    cur_worker = 0;
+}
+
+int tp_start(unsigned int num_workers)
+{
+    thread_once(&pool_once, tp_pool_init);
+    mutex_lock(&pool.state_mtx);
+    if (!pool.num_workers) {
+        if (!num_workers)
+            num_workers = thread_hw_concurrency();
+        pool.stop = 0;
+        pool.queued = 0;
+        pool.next = 0;
+        pool.workers = calloc(num_workers, sizeof(struct tp_worker));
+        for (unsigned int i = 0; i < num_workers; ++i) {
+            pool.workers[i].idx = i;
+            tp_deque_init(&pool.workers[i].dq);
+        }
+        /* Publish count before spawning, workers steal across the whole array */
+        pool.num_slots = num_workers;
+        pool.num_workers = num_workers;
+        unsigned int started = 0;
+        while (started < num_workers && thread_create(&pool.workers[started].thrd, tp_worker_main, pool.workers + started))
+            ++started;
+        /* Keep only the workers that run, the deques of the rest stay empty */
+        pool.num_workers = started;
+        if (!started) {
+            for (unsigned int i = 0; i < num_workers; ++i)
+                tp_deque_destroy(&pool.workers[i].dq);
+            free(pool.workers);
+            pool.workers = 0;
+            pool.num_slots = 0;
+        }
+    }
+    int running = pool.num_workers != 0;
+    mutex_unlock(&pool.state_mtx);
+    return running;
+}
+
+void tp_stop()
+{
+    thread_once(&pool_once, tp_pool_init);
+    mutex_lock(&pool.state_mtx);
+    if (pool.num_workers) {
+        mutex_lock(&pool.mtx);
+        pool.stop = 1;
+        cond_broadcast(&pool.wake);
+        mutex_unlock(&pool.mtx);
+        for (unsigned int i = 0; i < pool.num_workers; ++i)
+            thread_join(&pool.workers[i].thrd);
+        for (unsigned int i = 0; i < pool.num_slots; ++i)
+            tp_deque_destroy(&pool.workers[i].dq);
+        free(pool.workers);
+        pool.workers = 0;
+        pool.num_workers = 0;
+        pool.num_slots = 0;
+    }
+    mutex_unlock(&pool.state_mtx);
+}
+
+void tp_ensure_started()
+{
+    if (!pool.num_workers)
+        tp_start(0);
+}
+
+unsigned int tp_num_workers()
+{
+    return pool.num_workers;
+}
+
+void tp_submit(struct tp_group* g, tp_task_fn fn, void* arg)
+{
+    /* No pool, run synchronously */
+    if (!pool.num_workers) {
+        fn(arg);
+        return;
+    }
+
+    struct tp_task t;
+    t.fn = fn;
+    t.arg = arg;
+    t.grp = g;
+
+    /* Counted before the push, a thief may take the task and decrement right after */
+    mutex_lock(&pool.mtx);
+    if (g)
+        ++g->pending;
+    ++pool.queued;
+    unsigned int target = pool.next++ % pool.num_workers;
+    mutex_unlock(&pool.mtx);
+
+    /* Workers keep their own spawned tasks local */
+    struct tp_worker* w = cur_worker ? cur_worker : pool.workers + target;
+    tp_deque_push_back(&w->dq, &t);
+
+    mutex_lock(&pool.mtx);
+    cond_signal(&pool.wake);
+    mutex_unlock(&pool.mtx);
+}
+
+int tp_run_one()
+{
+    struct tp_task t;
+    if (!tp_try_get(&t))
+        return 0;
+    tp_run(&t);
+    return 1;
+}
+
+void tp_group_init(struct tp_group* g)
+{
+    g->pending = 0;
+}
+
+void tp_group_wait(struct tp_group* g)
+{
+    struct tp_task t;
+    for (;;) {
+        /* Help out instead of idling */
+        if (tp_try_get(&t)) {
+            tp_run(&t);
+            continue;
+        }
+        mutex_lock(&pool.mtx);
+        int done = g->pending == 0;
+        if (!done && pool.queued == 0)
+            cond_wait(&pool.wake, &pool.mtx);
+        mutex_unlock(&pool.mtx);
+        if (done)
+            break;
+    }
+}
+
+struct tp_range {
+    tp_range_fn fn;
+    void* arg;
+    size_t begin;
+    size_t end;
+};
+
+static void tp_range_task(void* arg)
+{
+    struct tp_range* r = arg;
+    r->fn(r->arg, r->begin, r->end);
+}
+
+void tp_parallel_for(size_t count, size_t grain, tp_range_fn fn, void* arg)
+{
+    if (!grain)
+        grain = 1;
+    if (!pool.num_workers || count <= grain) {
+        fn(arg, 0, count);
+        return;
+    }
+
+    size_t num_ranges = (count + grain - 1) / grain;
+    struct tp_range* ranges = malloc(num_ranges * sizeof(struct tp_range));
+    struct tp_group g;
+    tp_group_init(&g);
+    for (size_t i = 0; i < num_ranges; ++i) {
+        struct tp_range* r = ranges + i;
+        r->fn = fn;
+        r->arg = arg;
+        r->begin = i * grain;
+        r->end = r->begin + grain < count ? r->begin + grain : count;
+        /* Keep the first range for the calling thread */
+        if (i > 0)
+            tp_submit(&g, tp_range_task, r);
+    }
+    tp_range_task(ranges);
+    tp_group_wait(&g);
+    free(ranges);
+}
@@ -0,0 +1,75 @@
+/*********************************************************************************************************************/
+/*                                                  /===-_---~~~~~~~~~------____                                     */
+/*                                                 |===-~___                _,-'                                     */
+/*                  -==\\                         `//~\\   ~~~~`---.___.-~~                                          */
+/*              ______-==|                         | |  \\           _-~`                                            */
+/*        __--~~~  ,-/-==\\                        | |   `\        ,'                                                */
+/*     _-~       /'    |  \\                      / /      \      /                                                  */
+/*   .'        /       |   \\                   /' /        \   /'                                                   */
+/*  /  ____  /         |    \`\.__/-~~ ~ \ _ _/'  /          \/'                                                     */
+/* /-'~    ~~~~~---__  |     ~-/~         ( )   /'        _--~`                                                      */
+/*                   \_|      /        _)   ;  ),   __--~~                                                           */
+/*                     '~~--_/      _-~/-  / \   '-~ \                                                               */
+/*                    {\__--_/}    / \\_>- )<__\      \                                                              */
+/*                    /'   (_/  _-~  | |__>--<__|      |                                                             */
+/*                   |0  0 _/) )-~     | |__>--<__|     |                                                            */
+/*                   / /~ ,_/       / /__>---<__/      |                                                             */
+/*                  o o _//        /-~_>---<__-~      /                                                              */
+/*                  (^(~          /~_>---<__-      _-~                                                               */
+/*                 ,/|           /__>--<__/     _-~                                                                  */
+/*              ,//('(          |__>--<__|     /                  .----_                                             */
+/*             ( ( '))          |__>--<__|    |                 /' _---_~\                                           */
+/*          `-)) )) (           |__>--<__|    |               /'  /     ~\`\                                         */
+/*         ,/,'//( (             \__>--<__\    \            /'  //        ||                                         */
+/*       ,( ( ((, ))              ~-__>--<_~-_  ~--____---~' _/'/        /'                                          */
+/*     `~/  )` ) ,/|                 ~-_~>--<_/-__       __-~ _/                                                     */
+/*   ._-~//( )/ )) `                    ~~-'_/_/ /~~~~~~~__--~                                                       */
+/*    ;'( ')/ ,)(                              ~~~~~~~~~~                                                            */
+/*   ' ') '( (/                                                                                                      */
+/*     '   '  `                                                                                                      */
+/*********************************************************************************************************************/
+#ifndef _THREADPOOL_H_
+#define _THREADPOOL_H_
+
+#include <stddef.h>
+#include "thread.h"
+
+/* Process wide work-stealing pool. Every worker owns a task deque, pushes
+ * and pops its own work from the back and steals from the front of the
+ * others when it runs dry. Tasks submitted from outside the pool are
+ * spread round robin across the worker deques */
+
+typedef void(*tp_task_fn)(void* arg);
+
+/* Tracks completion of a set of submitted tasks */
+struct tp_group {
+    size_t pending;
+};
+
+/* Starts the pool with the given number of workers (0 for one per core).
+ * Returns 1 if the pool is running after the call */
+int tp_start(unsigned int num_workers);
+/* Drains all queued tasks and joins the workers */
+void tp_stop();
+/* Starts the pool with the default worker count if not already running */
+void tp_ensure_started();
+/* Number of workers, 0 when the pool is not running */
+unsigned int tp_num_workers();
+
+/* Queues a task, optionally accounted to a group.
+ * Runs the task inline when the pool is not running */
+void tp_submit(struct tp_group* g, tp_task_fn fn, void* arg);
+
+/* Runs one queued task on the calling thread if any. Returns 1 if it did */
+int tp_run_one();
+
+void tp_group_init(struct tp_group* g);
+/* Blocks until every task in the group has finished,
+ * executing queued tasks on the calling thread meanwhile */
+void tp_group_wait(struct tp_group* g);
+
+/* Splits [0, count) in ranges of at most grain items and runs them on the pool */
+typedef void(*tp_range_fn)(void* arg, size_t begin, size_t end);
+void tp_parallel_for(size_t count, size_t grain, tp_range_fn fn, void* arg);
+
+#endif /* ! _THREADPOOL_H_ */